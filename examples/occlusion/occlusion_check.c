@@ -0,0 +1,196 @@
+#include "raylib.h"
+#include "raymath.h"
+
+#define RFRUSTUM_IMPLEMENTATION    // NOTE : rfrustum.h is included by rocclusion.h
+#define ROCCLUSION_IMPLEMENTATION
+#include "rocclusion.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+
+// Headless check of the occlusion buffer :
+// a few walls are rasterized, and random boxes are tested with OcclusionBufferTestBox() (Hi-Z pyramid), then
+// - against the depth buffer itself, pixel by pixel : the pyramid must never hide a box that a pixel shows,
+// - against the geometry : a box with a corner in front of every wall, or outside of their silhouettes, must be visible.
+// The SIMD path of the rasterizer is the one selected by rfrustum.h (scalar with -DRFRUSTUM_NO_SIMD).
+// NOTE : no window is opened, it only needs to be linked with raylib. Return 1 if a check failed.
+
+#define BUFFER_WIDTH 256
+#define BUFFER_HEIGHT 144
+#define WALL_COUNT 3
+#define BOX_COUNT 20000
+
+//--------
+
+typedef struct Wall
+{
+	float z ;      // The walls face the camera, at this depth
+	float x0 , y0 ;
+	float x1 , y1 ;
+
+} Wall;
+
+float RandomFloat( float min , float max )
+{
+	return min + ( max - min )*( (float)rand()/(float)RAND_MAX );
+}
+
+// Reference test, on every pixel of the rectangle that OcclusionBufferTestBox() covers :
+bool TestBoxPerPixel( OcclusionBuffer *buffer , BoundingBox box )
+{
+	float minX = FLT_MAX , minY = FLT_MAX ;
+	float maxX = -FLT_MAX , maxY = -FLT_MAX ;
+	float nearest = 0.0f ;
+
+	for( int c = 0 ; c < 8 ; c++ )
+	{
+		Vector4 v = _OcclusionTransform( buffer->viewProj ,
+			c & 1 ? box.max.x : box.min.x ,
+			c & 2 ? box.max.y : box.min.y ,
+			c & 4 ? box.max.z : box.min.z );
+
+		if ( v.z < -v.w || v.w <= 0.0f ) return true ;
+
+		float iw = 1.0f/v.w ;
+
+		minX = fminf( minX , ( 0.5f + 0.5f*v.x*iw )*buffer->width );
+		maxX = fmaxf( maxX , ( 0.5f + 0.5f*v.x*iw )*buffer->width );
+		minY = fminf( minY , ( 0.5f - 0.5f*v.y*iw )*buffer->height );
+		maxY = fmaxf( maxY , ( 0.5f - 0.5f*v.y*iw )*buffer->height );
+
+		nearest = fmaxf( nearest , iw );
+	}
+
+	if ( maxX < 0.0f || maxY < 0.0f || minX >= buffer->width || minY >= buffer->height ) return true ;
+
+	int x0 = minX < 0.0f ? 0 : (int)minX ;
+	int y0 = minY < 0.0f ? 0 : (int)minY ;
+	int x1 = maxX > buffer->width - 1 ? buffer->width - 1 : (int)maxX ;
+	int y1 = maxY > buffer->height - 1 ? buffer->height - 1 : (int)maxY ;
+
+	for( int y = y0 ; y <= y1 ; y++ )
+	{
+		for( int x = x0 ; x <= x1 ; x++ )
+		{
+			if ( buffer->depth[ y*buffer->width + x ] < nearest ) return true ;
+		}
+	}
+
+	return false ;
+}
+
+// True if the box is for sure not hidden by the walls : a corner is on screen, and nearer than the wall or outside of its silhouette, for every wall.
+// NOTE : the camera is at the origin and looks down -z, so a point hides behind a wall if it projects inside the wall's rectangle.
+bool BoxIsSurelyVisible( Frustum *frustum , Wall *walls , BoundingBox box )
+{
+	for( int c = 0 ; c < 8 ; c++ )
+	{
+		Vector3 p = {
+			c & 1 ? box.max.x : box.min.x ,
+			c & 2 ? box.max.y : box.min.y ,
+			c & 4 ? box.max.z : box.min.z };
+
+		bool hidden = ! FrustumContainsPoint( frustum , p );
+
+		for( int w = 0 ; w < WALL_COUNT && ! hidden ; w++ )
+		{
+			if ( p.z > walls[w].z + 0.01f ) continue ; // Clearly in front of the wall
+
+			// Project the point onto the plane of the wall, with a margin of a few pixels for the rasterization :
+
+			float s = walls[w].z / p.z ;
+			float margin = 0.05f*fabsf( walls[w].z );
+
+			float x = p.x*s ;
+			float y = p.y*s ;
+
+			hidden = x > walls[w].x0 - margin && x < walls[w].x1 + margin && y > walls[w].y0 - margin && y < walls[w].y1 + margin ;
+		}
+
+		if ( ! hidden ) return true ;
+	}
+
+	return false ;
+}
+
+int main( void )
+{
+	Matrix view = MatrixLookAt( (Vector3){ 0.0f , 0.0f , 0.0f } , (Vector3){ 0.0f , 0.0f , -1.0f } , (Vector3){ 0.0f , 1.0f , 0.0f } );
+	Matrix proj = MatrixPerspective( 60.0f*DEG2RAD , (double)BUFFER_WIDTH/(double)BUFFER_HEIGHT , 0.1 , 1000.0 );
+
+	Frustum frustum = FrustumFromMatrices( view , proj );
+
+	OcclusionBuffer *buffer = OcclusionBufferCreate( BUFFER_WIDTH , BUFFER_HEIGHT );
+
+	// Occluders :
+
+	Wall walls[ WALL_COUNT ] = {
+		{ -10.0f , -4.0f , -3.0f ,  2.0f , 3.0f } ,
+		{ -25.0f ,  1.0f , -8.0f , 14.0f , 6.0f } ,
+		{ -40.0f , -30.0f , -20.0f , -5.0f , 0.0f } };
+
+	OcclusionBufferBegin( buffer , &frustum );
+
+	for( int w = 0 ; w < WALL_COUNT ; w++ )
+	{
+		float vertices[] = {
+			walls[w].x0 , walls[w].y0 , walls[w].z ,
+			walls[w].x1 , walls[w].y0 , walls[w].z ,
+			walls[w].x1 , walls[w].y1 , walls[w].z ,
+			walls[w].x0 , walls[w].y1 , walls[w].z };
+
+		unsigned short indices[] = { 0 , 1 , 2 , 0 , 2 , 3 };
+
+		OcclusionBufferRasterizeTriangles( buffer , vertices , 4 , indices , 2 , MatrixIdentity() );
+	}
+
+	OcclusionBufferEnd( buffer );
+
+	// Random boxes in front of the camera :
+
+	int hiddenPerPixel = 0 ;
+	int hiddenHiZ = 0 ;
+	int pyramidErrors = 0 ;
+	int geometryErrors = 0 ;
+
+	for( int i = 0 ; i < BOX_COUNT ; i++ )
+	{
+		Vector3 center = { RandomFloat( -30.0f , 30.0f ) , RandomFloat( -20.0f , 20.0f ) , RandomFloat( -60.0f , -2.0f ) };
+		Vector3 half = { RandomFloat( 0.05f , 2.0f ) , RandomFloat( 0.05f , 2.0f ) , RandomFloat( 0.05f , 2.0f ) };
+
+		BoundingBox box = { Vector3Subtract( center , half ) , Vector3Add( center , half ) };
+
+		bool visible = OcclusionBufferTestBox( buffer , box );
+		bool visiblePerPixel = TestBoxPerPixel( buffer , box );
+
+		if ( ! visible ) hiddenHiZ++ ;
+		if ( ! visiblePerPixel ) hiddenPerPixel++ ;
+
+		if ( ! visible && visiblePerPixel ) pyramidErrors++ ;
+		if ( ! visible && BoxIsSurelyVisible( &frustum , walls , box ) ) geometryErrors++ ;
+	}
+
+#if defined(RFRUSTUM_SIMD_AVX2)
+	const char *path = "AVX2" ;
+#elif defined(RFRUSTUM_SIMD_SSE)
+	const char *path = "SSE" ;
+#elif defined(RFRUSTUM_SIMD_NEON)
+	const char *path = "NEON" ;
+#else
+	const char *path = "scalar" ;
+#endif
+
+	printf( "%s rasterizer , %dx%d buffer , %d levels , %d triangles\n" , path , buffer->width , buffer->height , buffer->levels , buffer->triangles );
+	printf( "%d boxes : %d hidden per pixel , %d hidden by the Hi-Z (%.1f%%)\n" , BOX_COUNT , hiddenPerPixel , hiddenHiZ ,
+		hiddenPerPixel > 0 ? 100.0f*(float)hiddenHiZ/(float)hiddenPerPixel : 100.0f );
+	printf( "hidden by the Hi-Z but visible per pixel : %d\n" , pyramidErrors );
+	printf( "hidden by the Hi-Z but visible in the geometry : %d\n" , geometryErrors );
+
+	OcclusionBufferRelease( buffer );
+
+	bool failed = pyramidErrors > 0 || geometryErrors > 0 || hiddenHiZ == 0 ;
+
+	printf( "%s\n" , failed ? "FAILED" : "OK" );
+
+	return failed ? 1 : 0 ;
+}
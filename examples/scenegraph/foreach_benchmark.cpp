@@ -0,0 +1,194 @@
+#include "raylib.h"
+#include "raymath.h"
+
+// NOTE : the headers include each other, so each implementation is included alone, before the next one.
+
+#define RFRUSTUM_IMPLEMENTATION
+#include "rfrustum.h"
+#undef RFRUSTUM_IMPLEMENTATION
+
+#define ROCCLUSION_IMPLEMENTATION
+#include "rocclusion.h"
+#undef ROCCLUSION_IMPLEMENTATION
+
+#define RTRANSFORMS_IMPLEMENTATION
+#include "rtransforms.h"
+#undef RTRANSFORMS_IMPLEMENTATION
+
+#define RSKINNING_IMPLEMENTATION
+#include "rskinning.h"
+#undef RSKINNING_IMPLEMENTATION
+
+#define RWORKERS_IMPLEMENTATION
+#include "rworkers.h"
+#undef RWORKERS_IMPLEMENTATION
+
+#define RNODES_IMPLEMENTATION
+#include "rnodes.h"
+#undef RNODES_IMPLEMENTATION
+
+#define RSCENEGRAPH_IMPLEMENTATION
+#include "rscenegraph.hpp"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+// Micro-benchmark of the tree traversals :
+// - every node : NodeTreeTraversal() and its function pointer, against ForEachNode() and a lambda,
+// - the visible nodes : NodeTreeVisit() with a culling callback, against ForEachVisible() and a lambda,
+//   with NodeTreeCullInFrustum() as reference.
+// NOTE : no window is opened, it only needs to be linked with raylib. The nodes share an empty model, so nothing is drawn.
+
+#define NODE_COUNT 100000
+#define PASS_COUNT 100
+
+//--------
+
+float RandomFloat( float min , float max )
+{
+	return min + ( max - min )*( (float)rand()/(float)RAND_MAX );
+}
+
+double ElapsedMilliseconds( clock_t start )
+{
+	return 1000.0*(double)( clock() - start )/(double)CLOCKS_PER_SEC ;
+}
+
+// Function pointer path :
+
+void SumNodeCallback( Node *node , void *userData )
+{
+	*(float*)userData += node->transform.m12 ;
+}
+
+typedef struct CullTraversal
+{
+	Frustum *frustum ;
+	int visibleCount ;
+} CullTraversal;
+
+// Same tests as ForEachVisible() :
+NodeVisitResult CullNodeCallback( Node *node , int order , unsigned int *planeMask , void *userData )
+{
+	CullTraversal *cull = (CullTraversal*)userData ;
+
+	if ( node->subtreeBoxValid && ( node->firstChild != NULL || BoundingBoxIsEmpty( node->subtreeBox ) ) )
+	{
+		if ( BoundingBoxIsEmpty( node->subtreeBox ) || FrustumClassifyBoxMasked( cull->frustum , node->subtreeBox , planeMask ) == FRUSTUM_OUTSIDE ) return NODE_VISIT_PRUNE ;
+	}
+
+	if ( ! NodeIsDrawable( node ) ) return NODE_VISIT_CONTINUE ;
+
+	unsigned int nodePlaneMask = *planeMask ;
+
+	if ( FrustumClassifyBoxMasked( cull->frustum , node->transformedBox , &nodePlaneMask ) != FRUSTUM_OUTSIDE ) cull->visibleCount++ ;
+
+	return NODE_VISIT_CONTINUE ;
+}
+
+int main( int argc , char** argv )
+{
+	Model model = { 0 };
+
+	Node3D *nodes = (Node3D*)MemAlloc( sizeof( Node3D )*NODE_COUNT );
+
+	// Random hierarchy :
+
+	for( int i = 0 ; i < NODE_COUNT ; i++ )
+	{
+		nodes[i] = NodeAsGroup( (char*)"node" );
+
+		nodes[i].model = &model ;
+		nodes[i].untransformedBox = (BoundingBox){ { -1.0f , -1.0f , -1.0f } , { 1.0f , 1.0f , 1.0f } };
+		nodes[i].position = (Vector3){ RandomFloat( -10.0f , 10.0f ) , RandomFloat( -10.0f , 10.0f ) , RandomFloat( -10.0f , 10.0f ) };
+
+		if ( i > 0 ) NodeAttachChild( &nodes[ rand() % i ] , &nodes[i] );
+	}
+
+	NodeTreeUpdateTransforms( &nodes[0] );
+
+	Camera camera = { 0 };
+	camera.position = (Vector3){ 0.0f , 0.0f , 0.0f };
+	camera.target = (Vector3){ 1.0f , 0.0f , 0.0f };
+	camera.up = (Vector3){ 0.0f , 1.0f , 0.0f };
+	camera.fovy = 60.0f ;
+	camera.projection = CAMERA_PERSPECTIVE ;
+
+	Frustum frustum = FrustumFromCamera( &camera , 16.0f/9.0f );
+
+	VisibleList *list = VisibleListCreate( NODE_COUNT );
+
+	NodeStack *stack = NodeStackCreate( 64 ); // Reused by all the traversals, as the shared stack of NodeTreeTraversal()
+
+	// Every node :
+
+	float pointerSum = 0.0f ;
+
+	clock_t start = clock();
+
+	for( int pass = 0 ; pass < PASS_COUNT ; pass++ )
+	{
+		NodeTreeTraversal( &nodes[0] , SumNodeCallback , &pointerSum );
+	}
+
+	double pointerTime = ElapsedMilliseconds( start );
+
+	float lambdaSum = 0.0f ;
+
+	start = clock();
+
+	for( int pass = 0 ; pass < PASS_COUNT ; pass++ )
+	{
+		ForEachNode( &nodes[0] , [&]( Node *node ) { lambdaSum += node->transform.m12 ; } , stack );
+	}
+
+	double lambdaTime = ElapsedMilliseconds( start );
+
+	// Visible nodes :
+
+	CullTraversal cull = { &frustum , 0 };
+
+	start = clock();
+
+	for( int pass = 0 ; pass < PASS_COUNT ; pass++ )
+	{
+		cull.visibleCount = 0 ;
+		NodeTreeVisit( &nodes[0] , NODE_VISIT_PRE_ORDER , FRUSTUM_ALL_PLANES , CullNodeCallback , &cull , stack );
+	}
+
+	double pointerCullTime = ElapsedMilliseconds( start );
+
+	int lambdaVisibleCount = 0 ;
+
+	start = clock();
+
+	for( int pass = 0 ; pass < PASS_COUNT ; pass++ )
+	{
+		lambdaVisibleCount = 0 ;
+		ForEachVisible( &nodes[0] , &frustum , [&]( Node *node ) { lambdaVisibleCount++ ; } , stack );
+	}
+
+	double lambdaCullTime = ElapsedMilliseconds( start );
+
+	start = clock();
+
+	for( int pass = 0 ; pass < PASS_COUNT ; pass++ )
+	{
+		VisibleListClear( list );
+		NodeTreeCullInFrustum( &nodes[0] , &frustum , list );
+	}
+
+	double listCullTime = ElapsedMilliseconds( start );
+
+	printf( "%d nodes x %d passes\n" , NODE_COUNT , PASS_COUNT );
+	printf( "every node : pointer %8.2f ms , lambda %8.2f ms (x%.2f) , same sum : %s\n" , pointerTime , lambdaTime , pointerTime/lambdaTime , pointerSum == lambdaSum ? "yes" : "no" );
+	printf( "visible    : pointer %8.2f ms , lambda %8.2f ms (x%.2f) , %d and %d nodes\n" , pointerCullTime , lambdaCullTime , pointerCullTime/lambdaCullTime , cull.visibleCount , lambdaVisibleCount );
+	printf( "NodeTreeCullInFrustum() : %8.2f ms , %d nodes\n" , listCullTime , list->count );
+
+	NodeStackRelease( stack );
+	VisibleListRelease( list );
+	MemFree( nodes );
+
+	return 0 ;
+}
@@ -0,0 +1,242 @@
+#include "raylib.h"
+#include "raymath.h"
+
+#define RFRUSTUM_IMPLEMENTATION    // NOTE : rfrustum.h is included by rtransforms.h
+#define RTRANSFORMS_IMPLEMENTATION
+#define RWORKERS_IMPLEMENTATION
+#define RSKINNING_IMPLEMENTATION
+#include "rskinning.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+
+// Headless check of the CPU skinning :
+// a tube skinned to a few bones is animated by UpdateModelAnimation() (the reference), then by AnimationPoseSample()
+// and SkinVertices(), on ranges of odd sizes written into larger buffers, and both are compared on every frame :
+// - the vertices must be within a small distance of the reference, relative to the size of the mesh,
+// - the normals must point in the same direction (raylib only rotates them, so the bones are scaled uniformly),
+// - nothing must be written past the end of a range.
+// The SIMD path of SkinVertices() is the one selected by rfrustum.h (scalar with -DRFRUSTUM_NO_SIMD).
+// NOTE : UpdateModelAnimation() uploads the meshes, so a hidden window is opened. Return 1 if a check failed.
+
+#define RING_COUNT 24
+#define RING_VERTICES 17
+#define BONE_COUNT 4
+#define FRAME_COUNT 32
+#define RANGE_SIZE 37      // Vertices skinned by each call, odd so that the SIMD paths end on a partial block
+#define SENTINEL 12345.0f  // Written past the end of each range
+
+#define VERTEX_ERROR 1e-4f // Relative to the size of the mesh
+#define NORMAL_ERROR 1e-3f // Angle, in radians
+
+//--------
+
+float RandomFloat( float min , float max )
+{
+	return min + ( max - min )*( (float)rand()/(float)RAND_MAX );
+}
+
+Quaternion RandomRotation( float maxAngle )
+{
+	Vector3 axis = Vector3Normalize( (Vector3){ RandomFloat( -1.0f , 1.0f ) , RandomFloat( -1.0f , 1.0f ) , RandomFloat( 0.1f , 1.0f ) } );
+
+	return QuaternionFromAxisAngle( axis , RandomFloat( -maxAngle , maxAngle ) );
+}
+
+// Tube along y, each vertex weighted by up to 4 random bones (some weights are 0) :
+Mesh GenMeshSkinnedTube( void )
+{
+	Mesh mesh = { 0 };
+
+	mesh.vertexCount = RING_COUNT*RING_VERTICES ;
+	mesh.vertices = (float *)MemAlloc( mesh.vertexCount*3*sizeof(float) );
+	mesh.normals = (float *)MemAlloc( mesh.vertexCount*3*sizeof(float) );
+	mesh.animVertices = (float *)MemAlloc( mesh.vertexCount*3*sizeof(float) );
+	mesh.animNormals = (float *)MemAlloc( mesh.vertexCount*3*sizeof(float) );
+	mesh.boneIds = (unsigned char *)MemAlloc( mesh.vertexCount*4*sizeof(unsigned char) );
+	mesh.boneWeights = (float *)MemAlloc( mesh.vertexCount*4*sizeof(float) );
+
+	for( int r = 0 ; r < RING_COUNT ; r++ )
+	{
+		for( int s = 0 ; s < RING_VERTICES ; s++ )
+		{
+			int v = r*RING_VERTICES + s ;
+			float angle = 2.0f*PI*(float)s/(float)RING_VERTICES ;
+
+			mesh.vertices[ 3*v + 0 ] = cosf( angle );
+			mesh.vertices[ 3*v + 1 ] = 4.0f*(float)r/(float)( RING_COUNT - 1 );
+			mesh.vertices[ 3*v + 2 ] = sinf( angle );
+
+			mesh.normals[ 3*v + 0 ] = cosf( angle );
+			mesh.normals[ 3*v + 1 ] = 0.0f ;
+			mesh.normals[ 3*v + 2 ] = sinf( angle );
+
+			float total = 0.0f ;
+
+			for( int b = 0 ; b < 4 ; b++ )
+			{
+				mesh.boneIds[ 4*v + b ] = (unsigned char)( rand() % BONE_COUNT );
+				mesh.boneWeights[ 4*v + b ] = ( b > 0 && rand() % 3 == 0 ) ? 0.0f : RandomFloat( 0.1f , 1.0f );
+				total += mesh.boneWeights[ 4*v + b ];
+			}
+
+			for( int b = 0 ; b < 4 ; b++ ) mesh.boneWeights[ 4*v + b ] /= total ;
+		}
+	}
+
+	return mesh ;
+}
+
+int main( void )
+{
+	SetConfigFlags( FLAG_WINDOW_HIDDEN );
+	InitWindow( 64 , 64 , "skinning check" );
+
+	Mesh mesh = GenMeshSkinnedTube();
+	UploadMesh( &mesh , true );
+
+	Model model = LoadModelFromMesh( mesh );
+
+	// Bones along the tube, with a rotated bind pose :
+
+	model.boneCount = BONE_COUNT ;
+	model.bones = (BoneInfo *)MemAlloc( BONE_COUNT*sizeof(BoneInfo) );
+	model.bindPose = (Transform *)MemAlloc( BONE_COUNT*sizeof(Transform) );
+
+	for( int b = 0 ; b < BONE_COUNT ; b++ )
+	{
+		model.bones[b] = (BoneInfo){ "bone" , b - 1 };
+		model.bindPose[b].translation = (Vector3){ 0.0f , (float)b , 0.0f };
+		model.bindPose[b].rotation = RandomRotation( 1.0f );
+		model.bindPose[b].scale = Vector3One();
+	}
+
+#if RAYLIB_VERSION_MAJOR > 5 || ( RAYLIB_VERSION_MAJOR == 5 && RAYLIB_VERSION_MINOR >= 5 )
+	// NOTE : since raylib 5.5, UpdateModelAnimation() also writes the bone matrices of the meshes
+	model.meshes[0].boneCount = BONE_COUNT ;
+	model.meshes[0].boneMatrices = (Matrix *)MemAlloc( BONE_COUNT*sizeof(Matrix) );
+#endif
+
+	// Random frames, scaled uniformly :
+
+	ModelAnimation animation = { 0 };
+
+	animation.boneCount = BONE_COUNT ;
+	animation.frameCount = FRAME_COUNT ;
+	animation.bones = (BoneInfo *)MemAlloc( BONE_COUNT*sizeof(BoneInfo) );
+	animation.framePoses = (Transform **)MemAlloc( FRAME_COUNT*sizeof(Transform *) );
+
+	for( int b = 0 ; b < BONE_COUNT ; b++ ) animation.bones[b] = model.bones[b] ;
+
+	for( int f = 0 ; f < FRAME_COUNT ; f++ )
+	{
+		animation.framePoses[f] = (Transform *)MemAlloc( BONE_COUNT*sizeof(Transform) );
+
+		float scale = RandomFloat( 0.5f , 2.0f );
+
+		for( int b = 0 ; b < BONE_COUNT ; b++ )
+		{
+			animation.framePoses[f][b].translation = (Vector3){ RandomFloat( -2.0f , 2.0f ) , RandomFloat( -2.0f , 2.0f ) , RandomFloat( -2.0f , 2.0f ) };
+			animation.framePoses[f][b].rotation = RandomRotation( PI );
+			animation.framePoses[f][b].scale = (Vector3){ scale , scale , scale };
+		}
+	}
+
+	// Skin each frame both ways :
+
+	int vertexCount = model.meshes[0].vertexCount ;
+	int paddedCount = vertexCount + RANGE_SIZE ;
+
+	float *reference = (float *)MemAlloc( vertexCount*3*sizeof(float) );
+	float *referenceNormals = (float *)MemAlloc( vertexCount*3*sizeof(float) );
+	float *skinned = (float *)MemAlloc( paddedCount*3*sizeof(float) );
+	float *skinnedNormals = (float *)MemAlloc( paddedCount*3*sizeof(float) );
+
+	AnimationPose pose = { 0 };
+
+	float vertexError = 0.0f ;
+	float normalError = 0.0f ;
+	int overwrites = 0 ;
+
+	for( int f = 0 ; f < FRAME_COUNT ; f++ )
+	{
+		Mesh *m = &model.meshes[0] ;
+
+		UpdateModelAnimation( model , animation , f );
+
+		for( int i = 0 ; i < vertexCount*3 ; i++ )
+		{
+			reference[i] = m->animVertices[i] ;
+			referenceNormals[i] = m->animNormals[i] ;
+		}
+
+		AnimationPoseSample( &pose , &model , &animation , f );
+
+		// Each range goes to its own place, followed by sentinels :
+
+		for( int first = 0 ; first < vertexCount ; first += RANGE_SIZE )
+		{
+			int count = vertexCount - first < RANGE_SIZE ? vertexCount - first : RANGE_SIZE ;
+
+			for( int i = 3*first ; i < 3*( first + RANGE_SIZE + 1 ) && i < paddedCount*3 ; i++ )
+			{
+				skinned[i] = SENTINEL ;
+				skinnedNormals[i] = SENTINEL ;
+			}
+
+			SkinVertices( &m->vertices[ 3*first ] , &m->normals[ 3*first ] , &m->boneIds[ 4*first ] , &m->boneWeights[ 4*first ] ,
+				pose.bones , pose.boneCount , &skinned[ 3*first ] , &skinnedNormals[ 3*first ] , count );
+
+			for( int i = 3*( first + count ) ; i < 3*( first + RANGE_SIZE + 1 ) && i < paddedCount*3 ; i++ )
+			{
+				if ( skinned[i] != SENTINEL || skinnedNormals[i] != SENTINEL ) overwrites++ ;
+			}
+		}
+
+		for( int v = 0 ; v < vertexCount ; v++ )
+		{
+			Vector3 a = { reference[ 3*v ] , reference[ 3*v + 1 ] , reference[ 3*v + 2 ] };
+			Vector3 b = { skinned[ 3*v ] , skinned[ 3*v + 1 ] , skinned[ 3*v + 2 ] };
+
+			vertexError = fmaxf( vertexError , Vector3Distance( a , b )/fmaxf( 1.0f , Vector3Length( a ) ) );
+
+			Vector3 na = Vector3Normalize( (Vector3){ referenceNormals[ 3*v ] , referenceNormals[ 3*v + 1 ] , referenceNormals[ 3*v + 2 ] } );
+			Vector3 nb = Vector3Normalize( (Vector3){ skinnedNormals[ 3*v ] , skinnedNormals[ 3*v + 1 ] , skinnedNormals[ 3*v + 2 ] } );
+
+			normalError = fmaxf( normalError , 2.0f*asinf( fminf( 1.0f , 0.5f*Vector3Distance( na , nb ) ) ) );
+		}
+	}
+
+#if defined(RFRUSTUM_SIMD_AVX2)
+	const char *path = "AVX2" ;
+#elif defined(RFRUSTUM_SIMD_SSE)
+	const char *path = "SSE" ;
+#elif defined(RFRUSTUM_SIMD_NEON)
+	const char *path = "NEON" ;
+#else
+	const char *path = "scalar" ;
+#endif
+
+	printf( "%s skinning , %d vertices , %d bones , %d frames , ranges of %d vertices\n" , path , vertexCount , BONE_COUNT , FRAME_COUNT , RANGE_SIZE );
+	printf( "maximum vertex error : %g (relative)\n" , vertexError );
+	printf( "maximum normal error : %g rad\n" , normalError );
+	printf( "values written past a range : %d\n" , overwrites );
+
+	AnimationPoseUnload( &pose );
+
+	MemFree( reference );
+	MemFree( referenceNormals );
+	MemFree( skinned );
+	MemFree( skinnedNormals );
+
+	UnloadModelAnimation( animation );
+	UnloadModel( model );
+
+	CloseWindow();
+
+	bool failed = !( vertexError <= VERTEX_ERROR ) || !( normalError <= NORMAL_ERROR ) || overwrites > 0 ;
+
+	printf( "%s\n" , failed ? "FAILED" : "OK" );
+
+	return failed ? 1 : 0 ;
+}
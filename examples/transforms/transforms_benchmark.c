@@ -0,0 +1,159 @@
+#include "raylib.h"
+#include "raymath.h"
+
+#define RFRUSTUM_IMPLEMENTATION    // NOTE : rfrustum.h is included by rtransforms.h
+#define RTRANSFORMS_IMPLEMENTATION
+#include "rtransforms.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+// Micro-benchmark of the world transform update :
+// - the current path : raymath MatrixMultiply() and BoundingBoxTransform() for each node,
+// - the batch kernels of rtransforms.h (SIMD path selected by rfrustum.h, or scalar with -DRFRUSTUM_NO_SIMD),
+// then the bounding boxes alone : BoundingBoxTransform() (8 corners) against BoundingBoxTransformBatch() (center and extents).
+// NOTE : no window is opened, it only needs to be linked with raylib (or raymath with RAYMATH_IMPLEMENTATION).
+
+#define NODE_COUNT 100000
+#define PASS_COUNT 100
+
+//--------
+
+float RandomFloat( float min , float max )
+{
+	return min + ( max - min )*( (float)rand()/(float)RAND_MAX );
+}
+
+double ElapsedMilliseconds( clock_t start )
+{
+	return 1000.0*(double)( clock() - start )/(double)CLOCKS_PER_SEC ;
+}
+
+int main( void )
+{
+	Vector3 *position = (Vector3*)MemAlloc( sizeof( Vector3 )*NODE_COUNT );
+	Vector3 *scale = (Vector3*)MemAlloc( sizeof( Vector3 )*NODE_COUNT );
+	Quaternion *rotation = (Quaternion*)MemAlloc( sizeof( Quaternion )*NODE_COUNT );
+	int *parent = (int*)MemAlloc( sizeof( int )*NODE_COUNT );
+	BoundingBox *box = (BoundingBox*)MemAlloc( sizeof( BoundingBox )*NODE_COUNT );
+
+	Matrix3x4 *local = (Matrix3x4*)MemAlloc( sizeof( Matrix3x4 )*NODE_COUNT );
+	Matrix3x4 *world = (Matrix3x4*)MemAlloc( sizeof( Matrix3x4 )*NODE_COUNT );
+	BoundingBox *worldBox = (BoundingBox*)MemAlloc( sizeof( BoundingBox )*NODE_COUNT );
+
+	Matrix *refWorld = (Matrix*)MemAlloc( sizeof( Matrix )*NODE_COUNT );
+	BoundingBox *refWorldBox = (BoundingBox*)MemAlloc( sizeof( BoundingBox )*NODE_COUNT );
+
+	// Random hierarchy, parents before their children :
+
+	for( int i = 0 ; i < NODE_COUNT ; i++ )
+	{
+		position[i] = (Vector3){ RandomFloat( -10.0f , 10.0f ) , RandomFloat( -10.0f , 10.0f ) , RandomFloat( -10.0f , 10.0f ) };
+		scale[i] = (Vector3){ RandomFloat( 0.5f , 1.5f ) , RandomFloat( 0.5f , 1.5f ) , RandomFloat( 0.5f , 1.5f ) };
+		rotation[i] = QuaternionFromAxisAngle( Vector3Normalize( (Vector3){ RandomFloat( -1.0f , 1.0f ) , RandomFloat( -1.0f , 1.0f ) , 1.0f } ) , RandomFloat( -PI , PI ) );
+		parent[i] = i == 0 ? -1 : rand() % i ;
+		box[i] = (BoundingBox){ { -1.0f , -1.0f , -1.0f } , { 1.0f , 1.0f , 1.0f } };
+	}
+
+	// Current path :
+
+	clock_t start = clock();
+
+	for( int pass = 0 ; pass < PASS_COUNT ; pass++ )
+	{
+		for( int i = 0 ; i < NODE_COUNT ; i++ )
+		{
+			Matrix matScale       = MatrixScale( scale[i].x , scale[i].y , scale[i].z );
+			Matrix matTranslation = MatrixTranslate( position[i].x , position[i].y , position[i].z );
+
+			Matrix matLocal = MatrixMultiply( MatrixMultiply( matScale , QuaternionToMatrix( rotation[i] ) ) , matTranslation );
+
+			refWorld[i] = parent[i] >= 0 ? MatrixMultiply( matLocal , refWorld[ parent[i] ] ) : matLocal ;
+			refWorldBox[i] = BoundingBoxTransform( box[i] , refWorld[i] );
+		}
+	}
+
+	double raymathTime = ElapsedMilliseconds( start );
+
+	// Batch kernels :
+
+	start = clock();
+
+	for( int pass = 0 ; pass < PASS_COUNT ; pass++ )
+	{
+		TransformComposeBatch( position , scale , rotation , local , NULL , NODE_COUNT );
+		TransformComposeWorldBatch( local , parent , world , box , worldBox , NULL , NODE_COUNT );
+	}
+
+	double batchTime = ElapsedMilliseconds( start );
+
+	// Bounding boxes alone :
+
+	start = clock();
+
+	for( int pass = 0 ; pass < PASS_COUNT ; pass++ )
+	{
+		for( int i = 0 ; i < NODE_COUNT ; i++ ) refWorldBox[i] = BoundingBoxTransform( box[i] , refWorld[i] );
+	}
+
+	double cornersTime = ElapsedMilliseconds( start );
+
+	start = clock();
+
+	for( int pass = 0 ; pass < PASS_COUNT ; pass++ )
+	{
+		BoundingBoxTransformBatch( box , world , worldBox , NODE_COUNT );
+	}
+
+	double extentsTime = ElapsedMilliseconds( start );
+
+	// Compare the results :
+	// NOTE : the matrices are the same, the boxes only differ by rounding (center and extents instead of corners).
+
+	float maxError = 0.0f ;
+	float maxBoxError = 0.0f ;
+
+	for( int i = 0 ; i < NODE_COUNT ; i++ )
+	{
+		const float *a = (const float*)&world[i] ;
+		const float *b = (const float*)&refWorld[i] ;
+
+		for( int k = 0 ; k < 12 ; k++ ) maxError = fmaxf( maxError , fabsf( a[k] - b[k] ) );
+
+		a = (const float*)&worldBox[i] ;
+		b = (const float*)&refWorldBox[i] ;
+
+		for( int k = 0 ; k < 6 ; k++ ) maxBoxError = fmaxf( maxBoxError , fabsf( a[k] - b[k] ) );
+	}
+
+#if defined(RFRUSTUM_SIMD_AVX2)
+	const char *path = "AVX2" ;
+#elif defined(RFRUSTUM_SIMD_SSE)
+	const char *path = "SSE" ;
+#elif defined(RFRUSTUM_SIMD_NEON)
+	const char *path = "NEON" ;
+#else
+	const char *path = "scalar" ;
+#endif
+
+	printf( "%d nodes x %d passes\n" , NODE_COUNT , PASS_COUNT );
+	printf( "raymath : %8.2f ms\n" , raymathTime );
+	printf( "%-7s : %8.2f ms (x%.2f)\n" , path , batchTime , raymathTime/batchTime );
+	printf( "max difference : %g\n" , maxError );
+	printf( "boxes : corners %8.2f ms , batch %8.2f ms (x%.2f)\n" , cornersTime , extentsTime , cornersTime/extentsTime );
+	printf( "max box difference : %g\n" , maxBoxError );
+
+	MemFree( position );
+	MemFree( scale );
+	MemFree( rotation );
+	MemFree( parent );
+	MemFree( box );
+	MemFree( local );
+	MemFree( world );
+	MemFree( worldBox );
+	MemFree( refWorld );
+	MemFree( refWorldBox );
+
+	return 0 ;
+}
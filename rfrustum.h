@@ -6,6 +6,23 @@
 #include "raymath.h"
 #include "rcamera.h"
 
+#include <stdint.h>
+#include <float.h>
+
+// SIMD code path selection :
+// NOTE : the path is selected at compile time from the target flags (-mavx2, -msse2, NEON, ...).
+// Define RFRUSTUM_NO_SIMD to force the scalar code path.
+
+#if !defined(RFRUSTUM_NO_SIMD)
+	#if defined(__AVX2__)
+		#define RFRUSTUM_SIMD_AVX2
+		#define RFRUSTUM_SIMD_SSE
+	#elif defined(__SSE2__) || defined(_M_X64) || ( defined(_M_IX86_FP) && _M_IX86_FP >= 2 )
+		#define RFRUSTUM_SIMD_SSE
+	#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+		#define RFRUSTUM_SIMD_NEON
+	#endif
+#endif
 
 // BoundingBoxCornersFlag 
 // NOTE: bitwise flags to select corners
@@ -28,6 +45,51 @@ typedef enum
 } BoundingBoxCornersFlag;
 
 
+// FrustumCollision
+// NOTE : result of the tri-state frustum tests
+typedef enum
+{
+	FRUSTUM_OUTSIDE      = 0 , // Completely under at least one plane (culled)
+	FRUSTUM_INTERSECTING = 1 , // Crossing at least one plane
+	FRUSTUM_INSIDE       = 2   // Completely above all planes
+
+} FrustumCollision;
+
+// Frustum planes mask
+// NOTE : bit i selects frustum.plane[i]. Used by hierarchical culling to skip the planes a parent is fully inside.
+#define FRUSTUM_NO_PLANE   0x00
+#define FRUSTUM_ALL_PLANES 0x3F
+
+
+// FrustumCullCache
+// NOTE : per-box memory of the last frustum tests (temporal coherency), see FrustumClassifyBoxCached()
+typedef struct FrustumCullCache
+{
+	int planeHint ;     // Plane that rejected the box last time (tested first next time), or -1
+	float margin ;      // Distance between the box and the closest plane when last found fully inside, or -1
+
+	BoundingBox box ;   // The box when the margin was computed
+	Vector3 eye ;       // Frustum eye when the margin was computed
+	Vector3 forward ;   // Frustum Z axis when the margin was computed
+	Vector3 up ;        // Frustum Y axis when the margin was computed
+	unsigned int shape ; // Frustum shape when the margin was computed, so that another projection invalidates the margin
+
+} FrustumCullCache;
+
+// FrustumCullStats
+// NOTE : counters accumulated by FrustumClassifyBoxCached()
+typedef struct FrustumCullStats
+{
+	int tests ;            // Boxes that had to be tested against the planes
+	int coherentSkips ;    // Fully inside boxes that skipped the test because they and the camera barely moved
+	int planeHintTests ;   // Tests that started with the plane that rejected the box last time
+	int planeHintRejects ; // Tests rejected by this first plane
+
+} FrustumCullStats;
+
+
+// NOTE : use FrustumFromCamera() or FrustumFromMatrices(), or clear a frustum ( = { 0 } ) before setting its planes,
+// so that occlusion, shape and stats are valid.
 typedef struct Frustum 
 {
 	Camera *camera ;
@@ -37,10 +99,17 @@ typedef struct Frustum
 	Matrix proj ;
 	Matrix view ;
 
+	struct OcclusionBuffer *occlusion ; // Optional CPU depth buffer of the occluders, tested after the planes (see rocclusion.h)
+
+	unsigned int shape ;     // Hash of proj, set by FrustumFromMatrices() (0 : unknown, the culling caches don't skip any test)
+	FrustumCullStats stats ; // Counters of the culling done with this frustum outside of a view (see NodeView)
+
 	// Frustum planes :
 	// Note : their normals point inside the frustum
 	// so that if a point is touching or is "under" a plane,
 	// it is considered "oustide" the frustum.
+	// Note : their normals are unit length (see PlaneNormalize()),
+	// so the Frustum*() functions don't need to normalize the distances.
 
 	union 
 	{
@@ -67,6 +136,11 @@ extern "C" {            // Prevents name mangling of functions
 // AABB BoundingBox stuff :
 
 RLAPI BoundingBox BoundingBoxTransform( BoundingBox box , Matrix transform );
+RLAPI BoundingBox BoundingBoxTransformAffine( BoundingBox box , Matrix transform ); // Faster BoundingBoxTransform() for an affine matrix : transform the center, and the extents by the absolute 3x3 part
+
+RLAPI BoundingBox BoundingBoxEmpty( void ); // Return an inverted box (min = FLT_MAX , max = -FLT_MAX) that any merge will replace
+RLAPI bool BoundingBoxIsEmpty( BoundingBox box ); // True if min > max on any axis
+RLAPI BoundingBox BoundingBoxMerge( BoundingBox a , BoundingBox b ); // Smallest box containing both boxes
 
 // Matrix space travels :
 
@@ -87,6 +161,7 @@ RLAPI Vector3 MatrixExtractScale( Matrix m ); // Return the absolute scale of ea
 
 // Plane stuff :
 
+RLAPI Vector4 PlaneNormalize( Vector4 plane ); // Scale the plane so that its normal is unit length
 RLAPI float PlaneDistanceToPoint( Vector4 plane , Vector3 point ); // Signed distance between point and plane. Negative distance means the point is under the plane.
 
 RLAPI bool CheckCollisionPlanePoint( Vector4 plane , Vector3 point ); // True if point is touching or under the plane
@@ -97,12 +172,30 @@ RLAPI int  CheckCollisionPlaneBoxEx( Vector4 plane , BoundingBox box ); // Retur
 // Frustum stuff :
 
 RLAPI Frustum FrustumFromCamera( Camera *camera , float aspect ); // Compute the furstum of a perspective or orthogonal camera.
+RLAPI Frustum FrustumFromMatrices( Matrix view , Matrix proj ); // Same, from a view and a projection matrix (no camera : shadow maps, custom projections...)
 #define GetCameraFrustum FrustumFromCamera
 #define CameraGetFrustum FrustumFromCamera
+RLAPI Vector3 FrustumGetEye( Frustum *frustum ); // Position of the eye, from the view matrix (not from the camera, which may have moved since)
 
 RLAPI bool FrustumContainsPoint( Frustum *frustum , Vector3 point ); // True if above all planes
 RLAPI bool FrustumContainsSphere( Frustum *frustum , Vector3 center , float radius ); // True if at least a surface is above all planes
 RLAPI bool FrustumContainsBox( Frustum *frustum , BoundingBox box ); // True if at least one corner is above all planes
+RLAPI int  FrustumClassifyBox( Frustum *frustum , BoundingBox box ); // Return a FrustumCollision (outside, intersecting or inside)
+RLAPI int  FrustumClassifyBoxMasked( Frustum *frustum , BoundingBox box , unsigned int *planeMask ); // Same, but only test the planes in the mask, and remove the planes the box is fully inside
+RLAPI int  FrustumClassifyBoxEx( Frustum *frustum , BoundingBox box , unsigned int *planeMask , int *planeHint , float *insideMargin ); // Same, but test the hint plane first, and return the rejecting plane or the inside margin
+
+// Frustum culling coherency :
+
+RLAPI FrustumCullCache FrustumCullCacheInit( void ); // Return an empty cache
+RLAPI int  FrustumClassifyBoxCached( Frustum *frustum , BoundingBox box , unsigned int *planeMask , FrustumCullCache *cache , FrustumCullStats *stats ); // Same as FrustumClassifyBoxMasked(), using and updating the cache (cache and stats can be NULL)
+
+// Frustum batch culling :
+// NOTE : the inputs are arrays of `count` elements (Structure of Arrays). They don't need to be aligned.
+
+RLAPI int FrustumCullSpheres( Frustum *frustum , const float *cx , const float *cy , const float *cz , const float *r , int count , uint8_t *outVisible ); // Write 1 (visible) or 0 (culled) for each sphere, and return how many are visible
+#define CullSpheresInFrustum FrustumCullSpheres
+RLAPI int FrustumCullBoxes( Frustum *frustum , const BoundingBox *boxes , int count , uint8_t *outResult ); // Write a FrustumCollision for each box, and return how many are not outside
+#define CullBoxesInFrustum FrustumCullBoxes
 
 #if defined(__cplusplus)
 }
@@ -112,6 +205,16 @@ RLAPI bool FrustumContainsBox( Frustum *frustum , BoundingBox box ); // True if
 
 #if defined(RFRUSTUM_IMPLEMENTATION)
 
+#include <string.h> // Required for: memcpy()
+
+#if defined(RFRUSTUM_SIMD_AVX2)
+	#include <immintrin.h>
+#elif defined(RFRUSTUM_SIMD_SSE)
+	#include <emmintrin.h>
+#elif defined(RFRUSTUM_SIMD_NEON)
+	#include <arm_neon.h>
+#endif
+
 // Normalize each axis of the transform matrix (cancel the scale factor)
 // Note : this function does not check for division by zero
 Matrix MatrixNormalize( Matrix m )
@@ -237,33 +340,124 @@ BoundingBox BoundingBoxTransform( BoundingBox box , Matrix transform )
 	return box ;
 }
 
+// Arvo's method : the box is its center plus or minus its extents. The center is transformed as a point,
+// and each transformed extent is the sum of the absolute values of the 3x3 part times the extents.
+// NOTE : same box as BoundingBoxTransform() (up to rounding), with 1 matrix-vector product instead of 4 and no min/max over 8 corners.
+// The last row of transform is ignored.
+BoundingBox BoundingBoxTransformAffine( BoundingBox box , Matrix transform )
+{
+	Vector3 center = { ( box.min.x + box.max.x )*0.5f , ( box.min.y + box.max.y )*0.5f , ( box.min.z + box.max.z )*0.5f };
+	Vector3 extent = { ( box.max.x - box.min.x )*0.5f , ( box.max.y - box.min.y )*0.5f , ( box.max.z - box.min.z )*0.5f };
+
+	Vector3 c = {
+		transform.m0*center.x + transform.m4*center.y + transform.m8*center.z + transform.m12 ,
+		transform.m1*center.x + transform.m5*center.y + transform.m9*center.z + transform.m13 ,
+		transform.m2*center.x + transform.m6*center.y + transform.m10*center.z + transform.m14
+	};
+
+	Vector3 e = {
+		fabsf( transform.m0 )*extent.x + fabsf( transform.m4 )*extent.y + fabsf( transform.m8 )*extent.z ,
+		fabsf( transform.m1 )*extent.x + fabsf( transform.m5 )*extent.y + fabsf( transform.m9 )*extent.z ,
+		fabsf( transform.m2 )*extent.x + fabsf( transform.m6 )*extent.y + fabsf( transform.m10 )*extent.z
+	};
+
+	box.min = Vector3Subtract( c , e );
+	box.max = Vector3Add( c , e );
+
+	return box ;
+}
+
+
+BoundingBox BoundingBoxEmpty( void )
+{
+	return (BoundingBox){ (Vector3){ FLT_MAX , FLT_MAX , FLT_MAX } , (Vector3){ -FLT_MAX , -FLT_MAX , -FLT_MAX } };
+}
+
+bool BoundingBoxIsEmpty( BoundingBox box )
+{
+	return box.min.x > box.max.x || box.min.y > box.max.y || box.min.z > box.max.z ;
+}
+
+BoundingBox BoundingBoxMerge( BoundingBox a , BoundingBox b )
+{
+	return (BoundingBox){ Vector3Min( a.min , b.min ) , Vector3Max( a.max , b.max ) };
+}
+
 
 // Return the frustum of the camera.
 // NOTE : The returned frustum is in World Space coordinates.
 Frustum FrustumFromCamera( Camera *camera , float aspect )
 {
-	Frustum frustum ;
+	Frustum frustum = FrustumFromMatrices( GetCameraViewMatrix( camera ) , GetCameraProjectionMatrix( camera , aspect ) );
 
 	frustum.camera = camera;
 	frustum.aspect = aspect;
 
-	frustum.view = GetCameraViewMatrix( camera );
-	frustum.proj = GetCameraProjectionMatrix( camera , aspect );
+	return frustum;
+}
+
+// Return the frustum of a view and a projection.
+// NOTE : every other field is cleared (no camera, no occlusion buffer, no stats).
+Frustum FrustumFromMatrices( Matrix view , Matrix proj )
+{
+	Frustum frustum = { 0 };
+
+	frustum.camera = NULL ;
+	frustum.occlusion = NULL ;
+
+	frustum.view = view ;
+	frustum.proj = proj ;
+
+	// Hash the projection (FNV-1a), so that the culling caches know when the frustum changed shape :
+
+	const float *m = (const float*)&frustum.proj ;
+
+	frustum.shape = 2166136261u ;
+
+	for( int i = 0 ; i < 16 ; i++ )
+	{
+		uint32_t bits ;
+		memcpy( &bits , &m[i] , sizeof( bits ) );
+
+		frustum.shape = ( frustum.shape ^ bits )*16777619u ;
+	}
+
+	if ( frustum.shape == 0 ) frustum.shape = 1 ;
 
 	Matrix clip = MatrixMultiply( frustum.view , frustum.proj ); // The frustum is calculated in World Space
 
-	frustum.left  = Vector4Normalize( (Vector4){ clip.m3 + clip.m0 , clip.m7 + clip.m4 , clip.m11 + clip.m8 , clip.m15 + clip.m12 } );
-	frustum.right = Vector4Normalize( (Vector4){ clip.m3 - clip.m0 , clip.m7 - clip.m4 , clip.m11 - clip.m8 , clip.m15 - clip.m12 } );
+	frustum.left  = PlaneNormalize( (Vector4){ clip.m3 + clip.m0 , clip.m7 + clip.m4 , clip.m11 + clip.m8 , clip.m15 + clip.m12 } );
+	frustum.right = PlaneNormalize( (Vector4){ clip.m3 - clip.m0 , clip.m7 - clip.m4 , clip.m11 - clip.m8 , clip.m15 - clip.m12 } );
 
-	frustum.down  = Vector4Normalize( (Vector4){ clip.m3 + clip.m1 , clip.m7 + clip.m5 , clip.m11 + clip.m9 , clip.m15 + clip.m13 } );
-	frustum.up    = Vector4Normalize( (Vector4){ clip.m3 - clip.m1 , clip.m7 - clip.m5 , clip.m11 - clip.m9 , clip.m15 - clip.m13  } );
+	frustum.down  = PlaneNormalize( (Vector4){ clip.m3 + clip.m1 , clip.m7 + clip.m5 , clip.m11 + clip.m9 , clip.m15 + clip.m13 } );
+	frustum.up    = PlaneNormalize( (Vector4){ clip.m3 - clip.m1 , clip.m7 - clip.m5 , clip.m11 - clip.m9 , clip.m15 - clip.m13  } );
 
-	frustum.near  = Vector4Normalize( (Vector4){ clip.m3 + clip.m2 , clip.m7 + clip.m6 , clip.m11 + clip.m10 , clip.m15 + clip.m14 } );
-	frustum.far   = Vector4Normalize( (Vector4){ clip.m3 - clip.m2 , clip.m7 - clip.m6 , clip.m11 - clip.m10 , clip.m15 - clip.m14 } );
+	frustum.near  = PlaneNormalize( (Vector4){ clip.m3 + clip.m2 , clip.m7 + clip.m6 , clip.m11 + clip.m10 , clip.m15 + clip.m14 } );
+	frustum.far   = PlaneNormalize( (Vector4){ clip.m3 - clip.m2 , clip.m7 - clip.m6 , clip.m11 - clip.m10 , clip.m15 - clip.m14 } );
 
 	return frustum;
 }
 
+// Scale the plane equation so that its normal is unit length.
+// NOTE : unlike Vector4Normalize(), the distance component is not part of the length,
+// so that the dot product with a point gives the real signed distance.
+Vector4 PlaneNormalize( Vector4 plane )
+{
+	float len = sqrtf( plane.x * plane.x + plane.y * plane.y + plane.z * plane.z );
+
+	if ( len > 0.0f )
+	{
+		float ilen = 1.0f / len ;
+
+		plane.x *= ilen ;
+		plane.y *= ilen ;
+		plane.z *= ilen ;
+		plane.w *= ilen ;
+	}
+
+	return plane ;
+}
+
 // Return the closest (orthogonal) signed distance between a point and a plane.
 // NOTE : A negative distance means the point is under the plane.
 float PlaneDistanceToPoint( Vector4 plane , Vector3 point )
@@ -364,11 +558,14 @@ int CheckCollisionPlaneBoxEx( Vector4 plane , BoundingBox box )
 }
 
 // Return true if any part of the sphere is above all planes :
+// NOTE : the frustum planes are already normalized, so there is no need for PlaneDistanceToPoint() and its sqrt.
 bool FrustumContainsSphere( Frustum *frustum , Vector3 center , float radius )
 {
 	for( int i = 0 ; i < 6 ; i++ )
 	{
-		if ( PlaneDistanceToPoint( frustum->plane[i] , center ) <= -radius ) return false;
+		Vector4 p = frustum->plane[i] ;
+
+		if ( center.x * p.x + center.y * p.y + center.z * p.z + p.w <= -radius ) return false;
 	}
 
 	return true;
@@ -383,14 +580,538 @@ bool FrustumContainsPoint( Frustum *frustum , Vector3 point )
 // Return true if at least one corner is above all planes :
 bool FrustumContainsBox( Frustum *frustum , BoundingBox box )
 {
-	// A box is outside the frustum if all its corners are outside a single plane
+	return FrustumClassifyBox( frustum , box ) != FRUSTUM_OUTSIDE ;
+}
+
+// Tell if the box is outside, intersecting or inside the frustum.
+// NOTE : instead of testing the 8 corners against each plane, we only test the two corners
+// that are the farthest along the plane normal (P-vertex) and against it (N-vertex) :
+// If the P-vertex is touching or under the plane, all the corners are.
+// If the N-vertex is above the plane, all the corners are.
+// Using the center/extents form of the box, their distances are d + r and d - r.
+int FrustumClassifyBox( Frustum *frustum , BoundingBox box )
+{
+	Vector3 c = { ( box.min.x + box.max.x )*0.5f , ( box.min.y + box.max.y )*0.5f , ( box.min.z + box.max.z )*0.5f };
+	Vector3 e = { ( box.max.x - box.min.x )*0.5f , ( box.max.y - box.min.y )*0.5f , ( box.max.z - box.min.z )*0.5f };
+
+	int result = FRUSTUM_INSIDE ;
 
 	for( int i = 0 ; i < 6 ; i++ )
 	{
-		if ( CheckCollisionPlaneBoxEx( frustum->plane[i] , box ) == BOX_ALL_CORNERS ) return false ;
+		Vector4 p = frustum->plane[i] ;
+
+		float d = c.x * p.x + c.y * p.y + c.z * p.z + p.w ; // Distance of the center
+		float r = e.x * fabsf( p.x ) + e.y * fabsf( p.y ) + e.z * fabsf( p.z ); // Projected extents
+
+		if ( d + r <= 0.0f ) return FRUSTUM_OUTSIDE ; // P-vertex is touching or under the plane
+
+		if ( d - r <= 0.0f ) result = FRUSTUM_INTERSECTING ; // N-vertex is touching or under the plane
 	}
 
-	return true;
+	return result ;
+}
+
+// Same as FrustumClassifyBox(), but only the planes selected by *planeMask are tested.
+// The planes the box is fully inside are removed from *planeMask, so that the children of this box
+// don't need to test them again. If *planeMask becomes FRUSTUM_NO_PLANE, the box is fully inside.
+int FrustumClassifyBoxMasked( Frustum *frustum , BoundingBox box , unsigned int *planeMask )
+{
+	unsigned int mask = *planeMask ;
+
+	if ( mask == FRUSTUM_NO_PLANE ) return FRUSTUM_INSIDE ;
+
+	Vector3 c = { ( box.min.x + box.max.x )*0.5f , ( box.min.y + box.max.y )*0.5f , ( box.min.z + box.max.z )*0.5f };
+	Vector3 e = { ( box.max.x - box.min.x )*0.5f , ( box.max.y - box.min.y )*0.5f , ( box.max.z - box.min.z )*0.5f };
+
+	for( int i = 0 ; i < 6 ; i++ )
+	{
+		if ( ( mask & ( 1u << i ) ) == 0 ) continue ;
+
+		Vector4 p = frustum->plane[i] ;
+
+		float d = c.x * p.x + c.y * p.y + c.z * p.z + p.w ;
+		float r = e.x * fabsf( p.x ) + e.y * fabsf( p.y ) + e.z * fabsf( p.z );
+
+		if ( d + r <= 0.0f ) return FRUSTUM_OUTSIDE ;
+
+		if ( d - r > 0.0f ) mask &= ~( 1u << i ); // Fully inside this plane
+	}
+
+	*planeMask = mask ;
+
+	return mask == FRUSTUM_NO_PLANE ? FRUSTUM_INSIDE : FRUSTUM_INTERSECTING ;
+}
+
+// Same as FrustumClassifyBoxMasked(), with temporal coherency helpers :
+// - If *planeHint is a plane of the mask, it is tested first. It receives the plane that rejected the box, or -1.
+//   So, if the box was rejected by a plane last time, it will most likely be rejected by the first test this time.
+// - If insideMargin is not NULL and the box is inside, it receives the smallest distance between the box and the 6 planes,
+//   else -1.0f. As long as the box and the planes move less than this margin, the box remains inside.
+// NOTE : planeHint and insideMargin can be NULL.
+int FrustumClassifyBoxEx( Frustum *frustum , BoundingBox box , unsigned int *planeMask , int *planeHint , float *insideMargin )
+{
+	unsigned int mask = *planeMask ;
+
+	int hint = planeHint != NULL ? *planeHint : -1 ;
+
+	if ( insideMargin != NULL ) *insideMargin = -1.0f ;
+	if ( planeHint != NULL ) *planeHint = -1 ;
+
+	Vector3 c = { ( box.min.x + box.max.x )*0.5f , ( box.min.y + box.max.y )*0.5f , ( box.min.z + box.max.z )*0.5f };
+	Vector3 e = { ( box.max.x - box.min.x )*0.5f , ( box.max.y - box.min.y )*0.5f , ( box.max.z - box.min.z )*0.5f };
+
+	float margin = FLT_MAX ;
+
+	for( int t = -1 ; t < 6 ; t++ )
+	{
+		// The hint plane is tested first, and then skipped :
+
+		int i = t < 0 ? hint : t ;
+
+		if ( i < 0 || ( t >= 0 && i == hint ) ) continue ;
+
+		Vector4 p = frustum->plane[i] ;
+
+		float d = c.x * p.x + c.y * p.y + c.z * p.z + p.w ;
+		float r = e.x * fabsf( p.x ) + e.y * fabsf( p.y ) + e.z * fabsf( p.z );
+
+		if ( ( mask & ( 1u << i ) ) != 0 )
+		{
+			if ( d + r <= 0.0f )
+			{
+				if ( planeHint != NULL ) *planeHint = i ;
+				return FRUSTUM_OUTSIDE ;
+			}
+
+			if ( d - r > 0.0f ) mask &= ~( 1u << i );
+		}
+
+		if ( d - r < margin ) margin = d - r ;
+	}
+
+	*planeMask = mask ;
+
+	if ( mask != FRUSTUM_NO_PLANE ) return FRUSTUM_INTERSECTING ;
+
+	if ( insideMargin != NULL ) *insideMargin = margin ;
+
+	return FRUSTUM_INSIDE ;
+}
+
+FrustumCullCache FrustumCullCacheInit( void )
+{
+	FrustumCullCache cache = { 0 };
+
+	cache.planeHint = -1 ;
+	cache.margin = -1.0f ;
+
+	return cache ;
+}
+
+// Position of the eye of the frustum, from its view matrix.
+// NOTE : not from the camera, which may have moved since the frustum was computed.
+Vector3 FrustumGetEye( Frustum *frustum )
+{
+	Matrix v = frustum->view ;
+
+	return (Vector3){
+		-( v.m0*v.m12 + v.m1*v.m13 + v.m2*v.m14 ) ,
+		-( v.m4*v.m12 + v.m5*v.m13 + v.m6*v.m14 ) ,
+		-( v.m8*v.m12 + v.m9*v.m13 + v.m10*v.m14 ) };
+}
+
+// Tell if a box, found fully inside the frustum some frames ago, is for sure still inside.
+// NOTE : Each corner of the box moved by less than the largest move of its min/max coordinates.
+// Relatively to the frustum planes, a point also moves by less than the eye's move,
+// plus its distance to the eye times the rotation of the frustum, which is less than
+// the displacement of its (unit) Z axis plus the one of its Y axis.
+// As long as the sum is smaller than the inside margin, the box can't reach any plane.
+// This only holds for the same projection, so the margin is only used with the frustum shape it was computed with.
+static bool _FrustumCullCacheStillInside( Frustum *frustum , BoundingBox box , FrustumCullCache *cache )
+{
+	if ( cache->margin <= 0.0f ) return false ;
+
+	if ( frustum->shape == 0 || cache->shape != frustum->shape ) return false ;
+
+	Vector3 dmin = Vector3Subtract( box.min , cache->box.min );
+	Vector3 dmax = Vector3Subtract( box.max , cache->box.max );
+
+	Vector3 boxMove = {
+		fmaxf( fabsf( dmin.x ) , fabsf( dmax.x ) ) ,
+		fmaxf( fabsf( dmin.y ) , fabsf( dmax.y ) ) ,
+		fmaxf( fabsf( dmin.z ) , fabsf( dmax.z ) ) };
+
+	Vector3 eye = FrustumGetEye( frustum );
+
+	float eyeMove = Vector3Distance( eye , cache->eye );
+
+	float rotation = Vector3Distance( (Vector3){ frustum->view.m2 , frustum->view.m6 , frustum->view.m10 } , cache->forward )
+	               + Vector3Distance( (Vector3){ frustum->view.m1 , frustum->view.m5 , frustum->view.m9 } , cache->up );
+
+	// Distance between the camera and the farthest corner of the box :
+
+	Vector3 farthest = {
+		fmaxf( fabsf( box.min.x - eye.x ) , fabsf( box.max.x - eye.x ) ) ,
+		fmaxf( fabsf( box.min.y - eye.y ) , fabsf( box.max.y - eye.y ) ) ,
+		fmaxf( fabsf( box.min.z - eye.z ) , fabsf( box.max.z - eye.z ) ) };
+
+	float move = Vector3Length( boxMove ) + eyeMove + rotation * 1.01f * Vector3Length( farthest ); // 1.01 : the chord is a bit shorter than the angle
+
+	return move < cache->margin ;
+}
+
+// Same as FrustumClassifyBoxMasked(), using the temporal coherency of the cache :
+// - A box that was fully inside is not tested again while it and the camera move less than the inside margin.
+// - A box that was rejected by a plane is tested against this plane first.
+// NOTE : only the frustums of FrustumFromCamera() and FrustumFromMatrices() skip tests (see Frustum.shape). cache and stats can be NULL.
+int FrustumClassifyBoxCached( Frustum *frustum , BoundingBox box , unsigned int *planeMask , FrustumCullCache *cache , FrustumCullStats *stats )
+{
+	if ( *planeMask == FRUSTUM_NO_PLANE ) return FRUSTUM_INSIDE ;
+
+	if ( cache == NULL )
+	{
+		if ( stats != NULL ) stats->tests++ ;
+
+		return FrustumClassifyBoxMasked( frustum , box , planeMask );
+	}
+
+	if ( _FrustumCullCacheStillInside( frustum , box , cache ) )
+	{
+		if ( stats != NULL ) stats->coherentSkips++ ;
+
+		*planeMask = FRUSTUM_NO_PLANE ;
+		return FRUSTUM_INSIDE ;
+	}
+
+	int planeHint = cache->planeHint ;
+
+	int result = FrustumClassifyBoxEx( frustum , box , planeMask , &cache->planeHint , &cache->margin );
+
+	if ( stats != NULL )
+	{
+		stats->tests++ ;
+
+		if ( planeHint >= 0 ) stats->planeHintTests++ ;
+		if ( planeHint >= 0 && planeHint == cache->planeHint ) stats->planeHintRejects++ ;
+	}
+
+	// Remember the state of the box and of the camera for the next frames :
+
+	if ( cache->margin > 0.0f )
+	{
+		cache->box     = box ;
+		cache->eye     = FrustumGetEye( frustum );
+		cache->forward = (Vector3){ frustum->view.m2 , frustum->view.m6 , frustum->view.m10 };
+		cache->up      = (Vector3){ frustum->view.m1 , frustum->view.m5 , frustum->view.m9 };
+		cache->shape   = frustum->shape ;
+	}
+
+	return result ;
+}
+
+// Scalar version of FrustumCullSpheres(), also used for the remaining spheres of the SIMD versions :
+static int _FrustumCullSpheresScalar( Frustum *frustum , const float *cx , const float *cy , const float *cz , const float *r , int count , uint8_t *outVisible )
+{
+	int visibleCount = 0 ;
+
+	for( int i = 0 ; i < count ; i++ )
+	{
+		uint8_t visible = 1 ;
+
+		for( int p = 0 ; p < 6 ; p++ )
+		{
+			Vector4 plane = frustum->plane[p] ;
+
+			if ( cx[i] * plane.x + cy[i] * plane.y + cz[i] * plane.z + plane.w <= -r[i] )
+			{
+				visible = 0 ;
+				break ;
+			}
+		}
+
+		outVisible[i] = visible ;
+		visibleCount += visible ;
+	}
+
+	return visibleCount ;
+}
+
+// Test an array of spheres against the frustum at once.
+// Each outVisible[i] is set to 1 if the sphere i is (at least partially) inside the frustum, or 0 if culled.
+// NOTE : same rule as FrustumContainsSphere(), but 4 (SSE, NEON) or 8 (AVX2) spheres are tested per iteration.
+int FrustumCullSpheres( Frustum *frustum , const float *cx , const float *cy , const float *cz , const float *r , int count , uint8_t *outVisible )
+{
+	int i = 0 ;
+	int visibleCount = 0 ;
+
+#if defined(RFRUSTUM_SIMD_AVX2)
+
+	__m256 px[6] , py[6] , pz[6] , pw[6] ;
+
+	for( int p = 0 ; p < 6 ; p++ )
+	{
+		px[p] = _mm256_set1_ps( frustum->plane[p].x );
+		py[p] = _mm256_set1_ps( frustum->plane[p].y );
+		pz[p] = _mm256_set1_ps( frustum->plane[p].z );
+		pw[p] = _mm256_set1_ps( frustum->plane[p].w );
+	}
+
+	const __m256 signMask = _mm256_set1_ps( -0.0f );
+
+	for( ; i + 8 <= count ; i += 8 )
+	{
+		__m256 x = _mm256_loadu_ps( cx + i );
+		__m256 y = _mm256_loadu_ps( cy + i );
+		__m256 z = _mm256_loadu_ps( cz + i );
+		__m256 nr = _mm256_xor_ps( _mm256_loadu_ps( r + i ) , signMask ); // -radius
+
+		__m256 outside = _mm256_setzero_ps();
+
+		for( int p = 0 ; p < 6 ; p++ )
+		{
+			__m256 d = _mm256_add_ps( _mm256_add_ps( _mm256_mul_ps( x , px[p] ) , _mm256_mul_ps( y , py[p] ) ) , _mm256_add_ps( _mm256_mul_ps( z , pz[p] ) , pw[p] ) );
+			outside = _mm256_or_ps( outside , _mm256_cmp_ps( d , nr , _CMP_LE_OQ ) );
+		}
+
+		int bits = ~_mm256_movemask_ps( outside ) & 0xFF ;
+
+		for( int k = 0 ; k < 8 ; k++ )
+		{
+			outVisible[ i + k ] = ( bits >> k ) & 1 ;
+			visibleCount += outVisible[ i + k ] ;
+		}
+	}
+
+#elif defined(RFRUSTUM_SIMD_SSE)
+
+	__m128 px[6] , py[6] , pz[6] , pw[6] ;
+
+	for( int p = 0 ; p < 6 ; p++ )
+	{
+		px[p] = _mm_set1_ps( frustum->plane[p].x );
+		py[p] = _mm_set1_ps( frustum->plane[p].y );
+		pz[p] = _mm_set1_ps( frustum->plane[p].z );
+		pw[p] = _mm_set1_ps( frustum->plane[p].w );
+	}
+
+	const __m128 signMask = _mm_set1_ps( -0.0f );
+
+	for( ; i + 4 <= count ; i += 4 )
+	{
+		__m128 x = _mm_loadu_ps( cx + i );
+		__m128 y = _mm_loadu_ps( cy + i );
+		__m128 z = _mm_loadu_ps( cz + i );
+		__m128 nr = _mm_xor_ps( _mm_loadu_ps( r + i ) , signMask ); // -radius
+
+		__m128 outside = _mm_setzero_ps();
+
+		for( int p = 0 ; p < 6 ; p++ )
+		{
+			__m128 d = _mm_add_ps( _mm_add_ps( _mm_mul_ps( x , px[p] ) , _mm_mul_ps( y , py[p] ) ) , _mm_add_ps( _mm_mul_ps( z , pz[p] ) , pw[p] ) );
+			outside = _mm_or_ps( outside , _mm_cmple_ps( d , nr ) );
+		}
+
+		int bits = ~_mm_movemask_ps( outside ) & 0xF ;
+
+		outVisible[ i + 0 ] = ( bits >> 0 ) & 1 ;
+		outVisible[ i + 1 ] = ( bits >> 1 ) & 1 ;
+		outVisible[ i + 2 ] = ( bits >> 2 ) & 1 ;
+		outVisible[ i + 3 ] = ( bits >> 3 ) & 1 ;
+
+		visibleCount += outVisible[ i + 0 ] + outVisible[ i + 1 ] + outVisible[ i + 2 ] + outVisible[ i + 3 ] ;
+	}
+
+#elif defined(RFRUSTUM_SIMD_NEON)
+
+	float32x4_t px[6] , py[6] , pz[6] , pw[6] ;
+
+	for( int p = 0 ; p < 6 ; p++ )
+	{
+		px[p] = vdupq_n_f32( frustum->plane[p].x );
+		py[p] = vdupq_n_f32( frustum->plane[p].y );
+		pz[p] = vdupq_n_f32( frustum->plane[p].z );
+		pw[p] = vdupq_n_f32( frustum->plane[p].w );
+	}
+
+	for( ; i + 4 <= count ; i += 4 )
+	{
+		float32x4_t x = vld1q_f32( cx + i );
+		float32x4_t y = vld1q_f32( cy + i );
+		float32x4_t z = vld1q_f32( cz + i );
+		float32x4_t nr = vnegq_f32( vld1q_f32( r + i ) ); // -radius
+
+		uint32x4_t outside = vdupq_n_u32( 0 );
+
+		for( int p = 0 ; p < 6 ; p++ )
+		{
+			float32x4_t d = vmlaq_f32( vmlaq_f32( vmlaq_f32( pw[p] , x , px[p] ) , y , py[p] ) , z , pz[p] );
+			outside = vorrq_u32( outside , vcleq_f32( d , nr ) );
+		}
+
+		outVisible[ i + 0 ] = vgetq_lane_u32( outside , 0 ) ? 0 : 1 ;
+		outVisible[ i + 1 ] = vgetq_lane_u32( outside , 1 ) ? 0 : 1 ;
+		outVisible[ i + 2 ] = vgetq_lane_u32( outside , 2 ) ? 0 : 1 ;
+		outVisible[ i + 3 ] = vgetq_lane_u32( outside , 3 ) ? 0 : 1 ;
+
+		visibleCount += outVisible[ i + 0 ] + outVisible[ i + 1 ] + outVisible[ i + 2 ] + outVisible[ i + 3 ] ;
+	}
+
+#endif
+
+	// Remaining spheres (or all of them without SIMD) :
+
+	visibleCount += _FrustumCullSpheresScalar( frustum , cx + i , cy + i , cz + i , r + i , count - i , outVisible + i );
+
+	return visibleCount ;
+}
+
+// Test an array of boxes against the frustum at once.
+// Each outResult[i] is set to the FrustumCollision of the box i, as FrustumClassifyBox() would.
+// NOTE : the SIMD versions test 4 (SSE, NEON) or 8 (AVX2) planes per instruction,
+// so the boxes can stay in their natural BoundingBox layout.
+int FrustumCullBoxes( Frustum *frustum , const BoundingBox *boxes , int count , uint8_t *outResult )
+{
+	int visibleCount = 0 ;
+
+#if defined(RFRUSTUM_SIMD_AVX2) || defined(RFRUSTUM_SIMD_SSE) || defined(RFRUSTUM_SIMD_NEON)
+
+	// The 6 planes are padded to 8 with a plane that contains everything ( 0*x + 0*y + 0*z + 1 > 0 ) :
+
+	float planeX[8] , planeY[8] , planeZ[8] , planeW[8] ;
+	float absX[8] , absY[8] , absZ[8] ;
+
+	for( int p = 0 ; p < 8 ; p++ )
+	{
+		Vector4 plane = p < 6 ? frustum->plane[p] : (Vector4){ 0.0f , 0.0f , 0.0f , 1.0f };
+
+		planeX[p] = plane.x ; absX[p] = fabsf( plane.x );
+		planeY[p] = plane.y ; absY[p] = fabsf( plane.y );
+		planeZ[p] = plane.z ; absZ[p] = fabsf( plane.z );
+		planeW[p] = plane.w ;
+	}
+
+#endif
+
+#if defined(RFRUSTUM_SIMD_AVX2)
+
+	__m256 px = _mm256_loadu_ps( planeX ) , py = _mm256_loadu_ps( planeY ) , pz = _mm256_loadu_ps( planeZ ) , pw = _mm256_loadu_ps( planeW );
+	__m256 ax = _mm256_loadu_ps( absX ) , ay = _mm256_loadu_ps( absY ) , az = _mm256_loadu_ps( absZ );
+	__m256 half = _mm256_set1_ps( 0.5f );
+	__m256 zero = _mm256_setzero_ps();
+
+	for( int i = 0 ; i < count ; i++ )
+	{
+		__m256 minX = _mm256_set1_ps( boxes[i].min.x ) , maxX = _mm256_set1_ps( boxes[i].max.x );
+		__m256 minY = _mm256_set1_ps( boxes[i].min.y ) , maxY = _mm256_set1_ps( boxes[i].max.y );
+		__m256 minZ = _mm256_set1_ps( boxes[i].min.z ) , maxZ = _mm256_set1_ps( boxes[i].max.z );
+
+		__m256 cx = _mm256_mul_ps( _mm256_add_ps( minX , maxX ) , half ) , ex = _mm256_mul_ps( _mm256_sub_ps( maxX , minX ) , half );
+		__m256 cy = _mm256_mul_ps( _mm256_add_ps( minY , maxY ) , half ) , ey = _mm256_mul_ps( _mm256_sub_ps( maxY , minY ) , half );
+		__m256 cz = _mm256_mul_ps( _mm256_add_ps( minZ , maxZ ) , half ) , ez = _mm256_mul_ps( _mm256_sub_ps( maxZ , minZ ) , half );
+
+		__m256 d = _mm256_add_ps( _mm256_add_ps( _mm256_mul_ps( cx , px ) , _mm256_mul_ps( cy , py ) ) , _mm256_add_ps( _mm256_mul_ps( cz , pz ) , pw ) );
+		__m256 r = _mm256_add_ps( _mm256_add_ps( _mm256_mul_ps( ex , ax ) , _mm256_mul_ps( ey , ay ) ) , _mm256_mul_ps( ez , az ) );
+
+		int outside  = _mm256_movemask_ps( _mm256_cmp_ps( _mm256_add_ps( d , r ) , zero , _CMP_LE_OQ ) );
+		int crossing = _mm256_movemask_ps( _mm256_cmp_ps( _mm256_sub_ps( d , r ) , zero , _CMP_LE_OQ ) );
+
+		outResult[i] = outside ? FRUSTUM_OUTSIDE : ( crossing ? FRUSTUM_INTERSECTING : FRUSTUM_INSIDE );
+		visibleCount += outside ? 0 : 1 ;
+	}
+
+#elif defined(RFRUSTUM_SIMD_SSE)
+
+	__m128 px[2] , py[2] , pz[2] , pw[2] , ax[2] , ay[2] , az[2] ;
+
+	for( int g = 0 ; g < 2 ; g++ )
+	{
+		px[g] = _mm_loadu_ps( planeX + g*4 ); py[g] = _mm_loadu_ps( planeY + g*4 );
+		pz[g] = _mm_loadu_ps( planeZ + g*4 ); pw[g] = _mm_loadu_ps( planeW + g*4 );
+		ax[g] = _mm_loadu_ps( absX + g*4 ); ay[g] = _mm_loadu_ps( absY + g*4 ); az[g] = _mm_loadu_ps( absZ + g*4 );
+	}
+
+	__m128 zero = _mm_setzero_ps();
+
+	for( int i = 0 ; i < count ; i++ )
+	{
+		BoundingBox box = boxes[i] ;
+
+		__m128 cx = _mm_set1_ps( ( box.min.x + box.max.x )*0.5f ) , ex = _mm_set1_ps( ( box.max.x - box.min.x )*0.5f );
+		__m128 cy = _mm_set1_ps( ( box.min.y + box.max.y )*0.5f ) , ey = _mm_set1_ps( ( box.max.y - box.min.y )*0.5f );
+		__m128 cz = _mm_set1_ps( ( box.min.z + box.max.z )*0.5f ) , ez = _mm_set1_ps( ( box.max.z - box.min.z )*0.5f );
+
+		__m128 outside = zero ;
+		__m128 crossing = zero ;
+
+		for( int g = 0 ; g < 2 ; g++ )
+		{
+			__m128 d = _mm_add_ps( _mm_add_ps( _mm_mul_ps( cx , px[g] ) , _mm_mul_ps( cy , py[g] ) ) , _mm_add_ps( _mm_mul_ps( cz , pz[g] ) , pw[g] ) );
+			__m128 r = _mm_add_ps( _mm_add_ps( _mm_mul_ps( ex , ax[g] ) , _mm_mul_ps( ey , ay[g] ) ) , _mm_mul_ps( ez , az[g] ) );
+
+			outside  = _mm_or_ps( outside  , _mm_cmple_ps( _mm_add_ps( d , r ) , zero ) );
+			crossing = _mm_or_ps( crossing , _mm_cmple_ps( _mm_sub_ps( d , r ) , zero ) );
+		}
+
+		int isOutside = _mm_movemask_ps( outside );
+
+		outResult[i] = isOutside ? FRUSTUM_OUTSIDE : ( _mm_movemask_ps( crossing ) ? FRUSTUM_INTERSECTING : FRUSTUM_INSIDE );
+		visibleCount += isOutside ? 0 : 1 ;
+	}
+
+#elif defined(RFRUSTUM_SIMD_NEON)
+
+	float32x4_t px[2] , py[2] , pz[2] , pw[2] , ax[2] , ay[2] , az[2] ;
+
+	for( int g = 0 ; g < 2 ; g++ )
+	{
+		px[g] = vld1q_f32( planeX + g*4 ); py[g] = vld1q_f32( planeY + g*4 );
+		pz[g] = vld1q_f32( planeZ + g*4 ); pw[g] = vld1q_f32( planeW + g*4 );
+		ax[g] = vld1q_f32( absX + g*4 ); ay[g] = vld1q_f32( absY + g*4 ); az[g] = vld1q_f32( absZ + g*4 );
+	}
+
+	float32x4_t zero = vdupq_n_f32( 0.0f );
+
+	for( int i = 0 ; i < count ; i++ )
+	{
+		BoundingBox box = boxes[i] ;
+
+		float32x4_t cx = vdupq_n_f32( ( box.min.x + box.max.x )*0.5f ) , ex = vdupq_n_f32( ( box.max.x - box.min.x )*0.5f );
+		float32x4_t cy = vdupq_n_f32( ( box.min.y + box.max.y )*0.5f ) , ey = vdupq_n_f32( ( box.max.y - box.min.y )*0.5f );
+		float32x4_t cz = vdupq_n_f32( ( box.min.z + box.max.z )*0.5f ) , ez = vdupq_n_f32( ( box.max.z - box.min.z )*0.5f );
+
+		uint32x4_t outside = vdupq_n_u32( 0 );
+		uint32x4_t crossing = vdupq_n_u32( 0 );
+
+		for( int g = 0 ; g < 2 ; g++ )
+		{
+			float32x4_t d = vmlaq_f32( vmlaq_f32( vmlaq_f32( pw[g] , cx , px[g] ) , cy , py[g] ) , cz , pz[g] );
+			float32x4_t r = vmlaq_f32( vmlaq_f32( vmulq_f32( ex , ax[g] ) , ey , ay[g] ) , ez , az[g] );
+
+			outside  = vorrq_u32( outside  , vcleq_f32( vaddq_f32( d , r ) , zero ) );
+			crossing = vorrq_u32( crossing , vcleq_f32( vsubq_f32( d , r ) , zero ) );
+		}
+
+		uint32x2_t o = vorr_u32( vget_low_u32( outside ) , vget_high_u32( outside ) );
+		uint32x2_t c = vorr_u32( vget_low_u32( crossing ) , vget_high_u32( crossing ) );
+
+		int isOutside = ( vget_lane_u32( o , 0 ) | vget_lane_u32( o , 1 ) ) != 0 ;
+		int isCrossing = ( vget_lane_u32( c , 0 ) | vget_lane_u32( c , 1 ) ) != 0 ;
+
+		outResult[i] = isOutside ? FRUSTUM_OUTSIDE : ( isCrossing ? FRUSTUM_INTERSECTING : FRUSTUM_INSIDE );
+		visibleCount += isOutside ? 0 : 1 ;
+	}
+
+#else
+
+	for( int i = 0 ; i < count ; i++ )
+	{
+		outResult[i] = (uint8_t)FrustumClassifyBox( frustum , boxes[i] );
+		visibleCount += outResult[i] != FRUSTUM_OUTSIDE ? 1 : 0 ;
+	}
+
+#endif
+
+	return visibleCount ;
 }
 
 #endif //RFRUSTUM_IMPLEMENTATION
@@ -7,6 +7,9 @@
 #include "rcamera.h"
 
 #include "rfrustum.h"
+#include "rocclusion.h"
+#include "rtransforms.h"
+#include "rskinning.h"
 
 
 typedef enum
@@ -30,6 +33,7 @@ typedef struct AnimationsList
 {
 	ModelAnimation *list ;
 	int count ;
+	AnimationClip *clips ; // Compressed animations, one per animation of the list (NULL if not compressed, see AnimationsListCompress())
 } AnimationsList;
 
 typedef struct Node3D 
@@ -43,9 +47,11 @@ typedef struct Node3D
 	// Relative node's transforms 
 	// Note : they are in node's local space, ie, relative to the parent's transform.
 
+	// Note : 40 bytes in a row, the quaternion doesn't drift as a rotation matrix does, and interpolates well.
+
 	Vector3    position ;
 	Vector3    scale    ;
-	Matrix     rotation ; // Contains the rotation matrix only (ie, the 3 axis normals) // TODO use Quaternion instead ?
+	Quaternion rotation ; // Unit quaternion (use QuaternionToMatrix() to get the 3 axis normals)
 
 	// If set, above transform are then relative to this parent's bone :
 
@@ -58,6 +64,20 @@ typedef struct Node3D
 
 	Matrix transform ; 
 
+	// Dirty flags :
+	// Note : only the dirty nodes and their descendants are recomputed by NodeTreeUpdateTransforms().
+	// The setters below set them, but NodeSetDirty() must be called after changing position, scale or rotation directly.
+
+	Matrix3x4 localTransform ; // Cached scale*rotation*translation, in parent's space (affine, see rtransforms.h)
+	bool localDirty ;       // position, scale or rotation changed : the localTransform must be rebuilt
+	bool worldDirty ;       // The parent's transform changed : the transform must be recomputed
+
+	// Cached inverse of the transform :
+	// Note : only computed when asked by NodeGetInverseTransform(), and invalidated each time the transform is recomputed.
+
+	Matrix3x4 inverseTransform ;
+	bool inverseTransformValid ;
+
 	// Untransformed boundings :
 	// They are in model's space and are computed once in LoadNodeFromModel()
 
@@ -72,6 +92,20 @@ typedef struct Node3D
 	Vector3 transformedCenter ;
 	float transformedRadius ;
 
+	// Subtree boundings :
+	// Note : they enclose the transformedBox of the node and of all its descendants, in World's space.
+	// They are updated by NodeTreeUpdateTransforms() and are used to cull whole branches at once.
+
+	BoundingBox subtreeBox ;
+	bool subtreeBoxValid ; // False if something changed in the branch since the last NodeTreeUpdateTransforms()
+
+	// Static branch :
+	// Note : set by NodeBakeStatic() on the whole branch, whose transforms and boundings are then frozen :
+	// the updates skip it, and so do the animation timelines. Any change of the node or of one of its
+	// descendants (setters, NodeSetDirty(), attach, detach...) or a move of an ancestor clears it.
+
+	bool baked ;
+
 	// Basic scenegraph bindings :
 
 	Node3D *parent;
@@ -79,19 +113,21 @@ typedef struct Node3D
 	Node3D *nextSibling;
 	Node3D *prevSibling;
 
+	unsigned int hierarchyVersion ; // Last change of the hierarchy in this branch : the one of the root is the version of the tree (see NodeGetHierarchyVersion())
+
 	// Frustum visibility :
+	// Note : the visibility, distance to camera, active LOD and culling caches are stored
+	// per view (see NodeView), at this index, so that several views can be culled at once.
 
-	Frustum * lastFrustum ; // Points the last frustum relative to which the node was drawn
-	bool insideFrustum ; // Tells if the node was visible in the frustum
-	float distanceToCamera ; // Tells at which distance the node was from the camera
+	int slot ; // Index of the node in the views' buffers (-1 if not tracked). Scene nodes use their scene slot.
+
+	bool occluder ; // Rasterized into the occlusion buffer of the frustum by NodeTreeRasterizeOccluders(), and never occlusion tested
 
 	// Level Of Details chain :
 
 	Node3D *nextLOD ;
 	float nextDistance ;
 
-	Node3D *activeLOD ; // Tells which LOD is active in relation to current frustum's camera
-
 	// Animation management :
 
 	AnimationsList animations ;
@@ -103,12 +139,153 @@ typedef struct Node3D
 
 	NodeAnimationEventCallback animEventCallback ; // If set, will be called on animation events
 
+	// Skinning matrices of the model on the current frame :
+	// Note : sampled by the transforms update, and applied to the shared meshes of the model when the node is drawn (see rskinning.h).
+	// They are allocated the first time, and freed by NodeUnloadPose().
+
+	AnimationPose pose ;
+
 	// Pointer to user data :
 	void *userData ;
 
 } Node3D;
 
 
+// Animation LOD :
+// NOTE : how often the animation of a node is updated, chosen from its visibility and its distance in a view,
+// as they were when the view was last drawn (see NodeTreeUpdateAnimationTimelineInView()).
+typedef enum
+{
+	NODE_ANIMATION_LOD_FULL = 0 , // The timeline advances and the pose is updated every frame
+	NODE_ANIMATION_LOD_REDUCED ,  // The timeline advances every frame, but the pose is only updated every reducedPeriod frames
+	NODE_ANIMATION_LOD_TIMELINE , // The timeline advances (and the events are called), but the pose is not updated, so the node is not skinned again
+	NODE_ANIMATION_LOD_FROZEN ,   // Nothing is updated
+
+	NODE_ANIMATION_LOD_COUNT
+
+} NodeAnimationLOD;
+
+typedef struct NodeAnimationLODSettings
+{
+	float fullDistance ;    // Visible nodes closer than this are in NODE_ANIMATION_LOD_FULL
+	float reducedDistance ; // Visible nodes closer than this are in NODE_ANIMATION_LOD_REDUCED, farther ones in NODE_ANIMATION_LOD_TIMELINE
+	int reducedPeriod ;     // Number of frames between two pose updates in NODE_ANIMATION_LOD_REDUCED
+	float frozenDistance ;  // Nodes farther than this are in NODE_ANIMATION_LOD_FROZEN, visible or not
+
+	NodeAnimationLOD hiddenLOD ; // LOD of the nodes outside the view, closer than frozenDistance
+
+} NodeAnimationLODSettings;
+
+#ifndef NODE_ANIMATION_LOD_FULL_DISTANCE
+#define NODE_ANIMATION_LOD_FULL_DISTANCE 25.0f
+#endif
+#ifndef NODE_ANIMATION_LOD_REDUCED_DISTANCE
+#define NODE_ANIMATION_LOD_REDUCED_DISTANCE 100.0f
+#endif
+#ifndef NODE_ANIMATION_LOD_REDUCED_PERIOD
+#define NODE_ANIMATION_LOD_REDUCED_PERIOD 3
+#endif
+#ifndef NODE_ANIMATION_LOD_FROZEN_DISTANCE
+#define NODE_ANIMATION_LOD_FROZEN_DISTANCE 500.0f
+#endif
+
+typedef struct NodeAnimationLODStats
+{
+	int nodes[ NODE_ANIMATION_LOD_COUNT ] ; // Animated nodes in each LOD during the last timeline update
+	int posed ; // Animated nodes whose pose will be updated
+
+} NodeAnimationLODStats;
+
+
+typedef struct NodeStackEntry
+{
+	Node3D *node ;
+	unsigned int state ;
+	bool entered ; // Visited in pre-order : its children are being visited
+} NodeStackEntry;
+
+// NodeStack
+// NOTE : ancestors of the visited node. It grows as needed, and can be reused by all the traversals,
+// even by a traversal started from the callback of another.
+typedef struct NodeStack
+{
+	NodeStackEntry *entries ;
+	int count ;
+	int capacity ;
+} NodeStack;
+
+// NodeViewSlot
+// NOTE : state of a node in a view
+typedef struct NodeViewSlot
+{
+	bool insideFrustum ;     // Tells if the node was visible in the view
+	float distanceToCamera ; // Tells at which distance the node was from the camera
+	Node3D *activeLOD ;      // Tells which LOD is active in relation to the view's camera
+
+	FrustumCullCache cullCache ;        // Temporal coherency of the tests of the transformedBox
+	FrustumCullCache subtreeCullCache ; // Temporal coherency of the tests of the subtreeBox
+
+} NodeViewSlot;
+
+// NodeView
+// NOTE : visibility buffers of a camera, indexed by Node3D.slot.
+// Drawing in a view only writes into that view, so views can be culled in parallel.
+typedef struct NodeView
+{
+	Frustum *frustum ;     // Frustum of the view (set it before drawing)
+
+	NodeViewSlot *slots ;
+	int slotsCount ;
+
+	FrustumCullStats stats ; // Culling counters of this view
+
+	NodeAnimationLODSettings animationLOD ; // How the animations are updated from this view (set to the defaults by NodeViewCreate())
+	NodeAnimationLODStats animationStats ;  // Set by the timeline updates in this view
+	unsigned int animationFrame ;           // Counts the timeline updates, to stagger the pose updates of the reduced nodes
+
+	NodeStack stack ; // Used by the traversals in this view, instead of the shared one
+
+} NodeView;
+
+// VisibleEntry
+// NOTE : a node that passed the culling, with what must be drawn for it
+typedef struct VisibleEntry
+{
+	Node3D *node ;  // Node whose transform is used
+	Node3D *lod ;   // Active LOD, whose model and tint are used
+	int firstMesh ; // Range of meshes of the LOD's model to draw
+	int meshCount ;
+	float depth ;   // Distance from the node to the camera
+} VisibleEntry;
+
+// VisibleList
+// NOTE : filled by the *Cull*() functions, then submitted by VisibleListDraw().
+// The entries point to the nodes, so the nodes must not change between the culling and the submission.
+typedef struct VisibleList
+{
+	VisibleEntry *entries ;
+	int count ;
+	int capacity ; // Grows as needed, and is kept by VisibleListClear() so the buffer is reused each frame
+} VisibleList;
+
+// Tree traversal :
+// NOTE : the traversals are depth-first and iterative. An explicit stack holds the ancestors of the visited node,
+// so a deep or wide tree can't overflow the call stack.
+
+#define NODE_VISIT_PRE_ORDER  1 // The node is visited before its children
+#define NODE_VISIT_POST_ORDER 2 // The node is visited after its children
+
+typedef enum
+{
+	NODE_VISIT_CONTINUE = 0 , // Visit the children of the node
+	NODE_VISIT_PRUNE ,        // Skip the children of the node (its post-order visit is still done)
+	NODE_VISIT_STOP           // End the traversal at once
+} NodeVisitResult;
+
+// The state is inherited from the parent before the pre-order visit, and the children inherit it as the visit left it.
+typedef NodeVisitResult (*NodeVisitCallback)( Node *node , int order , unsigned int *state , void *userData );
+
+
 #if defined(__cplusplus)
 extern "C" {            // Prevents name mangling of functions
 #endif
@@ -128,6 +305,7 @@ RLAPI void NodeSetName( Node *node , char *name );
 
 RLAPI void NodeAttachChild( Node *parent , Node *child ); // The child keeps its relative transforms
 RLAPI void NodeTakeChild( Node *parent , Node *child ); // Attach and preserve global transforms
+RLAPI void NodeTakeChildren( Node *parent , Node **children , int count ); // Same for several children, the inverse of the parent's transform is computed once for all
 
 RLAPI void NodeAttachChildToBone( Node *parent , Node *child , char *boneName ); // The child relative transforms are replaced with the bone's
 
@@ -141,14 +319,31 @@ RLAPI void NodeRemove( Node *node ); // Remove the node from its tree so that it
 RLAPI void NodeAbandon( Node *node ); // Remove the node and preserve its global transforms
 #define AbandonNode NodeAbandon
 
+#define NodeIsDrawable( node ) ( (node)->model != NULL || (node)->nextLOD != NULL ) // True if the node has something to draw, and thus meaningful boundings
+
 typedef void (*NodeTreeTraversalCallback)( Node *node , void *userData );
 
-RLAPI void NodeTreeTraversal( Node *root , NodeTreeTraversalCallback callback , void *userData );
+RLAPI void NodeTreeTraversal( Node *root , NodeTreeTraversalCallback callback , void *userData ); // Call the callback once for each node of the tree, parents first
 #define TraverseNodeTree NodeTreeTraversal
 
+RLAPI NodeVisitResult NodeBranchVisit( Node *branch , int orders , unsigned int state , NodeVisitCallback callback , void *userData , NodeStack *stack ); // Depth-first traversal of the branch, visiting the nodes in the orders (NODE_VISIT_PRE_ORDER | NODE_VISIT_POST_ORDER). The branch inherits the state. If stack is NULL, a shared one is used (not thread safe). Return NODE_VISIT_STOP if stopped by the callback.
+#define VisitNodeBranch NodeBranchVisit
+RLAPI NodeVisitResult NodeTreeVisit( Node *root , int orders , unsigned int state , NodeVisitCallback callback , void *userData , NodeStack *stack ); // Same for the root and its siblings
+#define VisitNodeTree NodeTreeVisit
+
+RLAPI NodeStack *NodeStackCreate( int capacity );
+#define CreateNodeStack NodeStackCreate
+RLAPI NodeStack *NodeStackRelease( NodeStack *stack ); // Return NULL
+#define ReleaseNodeStack NodeStackRelease
+RLAPI void NodeStackPush( NodeStack *stack , Node *node , unsigned int state ); // Push an entry above the ones already there, growing the stack as needed
+#define PushNodeStack NodeStackPush
+
 RLAPI void NodeInsertLOD( Node *node , Node *lod , float distance ); // TODO explain
 RLAPI void NodeRemoveLOD( Node *node , Node *lod );
 
+RLAPI unsigned int NodeGetHierarchyVersion( Node *node ); // Version of the tree of the node : changes each time a node of this tree is attached, detached or removed, so that copies of the tree know they are outdated
+RLAPI unsigned int NodePeekHierarchyVersion( Node *node ); // Same, to compare with a version got before (doesn't modify anything, unlike NodeGetHierarchyVersion())
+
 // Node's transforms :
 
 RLAPI void NodeTreeUpdateTransforms( Node *root ); // Update the transform matrix of every nodes in the tree at once
@@ -160,6 +355,21 @@ RLAPI void NodeUpdateTransforms( Node *node ); // Update the transform matrix of
 RLAPI void NodeUnpackTransforms( Node *node ); // Decompose the transform matrix back into position, scale and rotation.
 #define UnpackNodeTransforms NodeUnpackTransforms
 
+RLAPI Matrix3x4 NodeGetInverseTransform( Node *node ); // Inverse of the up to date transform matrix, cached till the transform changes
+#define GetNodeInverseTransform NodeGetInverseTransform
+
+RLAPI void NodeUpdateAnimationPose( Node *node ); // Sample the pose of the model on the current animation frame, and pose the node on its parent's bone (done by the transforms update)
+RLAPI void NodeUnloadPose( Node *node ); // Free the skinning matrices of the node (see Node3D.pose)
+#define UnloadNodePose NodeUnloadPose
+
+RLAPI void NodeSetDirty( Node *node ); // Tell that position, scale or rotation were changed directly, so the node and its descendants must be updated
+#define SetNodeDirty NodeSetDirty
+
+RLAPI int NodeBakeStatic( Node *branch ); // Update the transforms of the branch, then freeze it (see Node3D.baked), animations included. Return how many nodes were baked.
+#define BakeNodeStatic NodeBakeStatic
+RLAPI int NodeTreeBakeStatic( Node *root ); // Update the transforms of the tree, then freeze the branches without animation playing nor bone attachment. Return how many nodes were baked.
+#define BakeNodeTreeStatic NodeTreeBakeStatic
+
 
 // NOTE : the transforms below are not immediately effective, till the transform matrix is updated.
 
@@ -203,8 +413,18 @@ RLAPI void NodeMoveSideward( Node *node , float distance ); // Move in direction
 
 // Node animations :
 
-RLAPI AnimationsList AnimationsListLoad( char *fileName );
+RLAPI AnimationsList AnimationsListLoad( char *fileName ); // Load the animations, and compress them if enabled (see AnimationsListSetCompression())
 #define LoadAnimationsList AnimationsListLoad
+RLAPI void AnimationsListUnload( AnimationsList *anims ); // Unload the animations and their compressed clips
+#define UnloadAnimationsList AnimationsListUnload
+RLAPI AnimationCompressionReport AnimationsListCompress( AnimationsList *anims , AnimationCompression compression ); // Compress the animations into clips, free their frame poses, and return the sizes and errors
+#define CompressAnimationsList AnimationsListCompress
+RLAPI void AnimationsListSetCompression( AnimationCompression compression ); // Compression of the animations loaded by AnimationsListLoad() (disabled by default, see AnimationCompressionDefaults())
+#define SetAnimationsListCompression AnimationsListSetCompression
+RLAPI AnimationCompressionReport AnimationsListGetCompressionReport( void ); // Return the sizes and errors accumulated by AnimationsListCompress()
+#define GetAnimationsListCompressionReport AnimationsListGetCompressionReport
+RLAPI Transform AnimationsListSampleBone( AnimationsList *anims , int index , int frame , int bone ); // Return the transform of a bone on a frame (wrapped) of an animation, compressed or not
+#define SampleAnimationsListBone AnimationsListSampleBone
 RLAPI void NodeSetAnimationsList( Node *node , AnimationsList *anims );
 #define SetNodeAnimationsList NodeSetAnimationsList
 RLAPI void NodeLoadAnimationsList( Node *node , char *fileName );
@@ -224,13 +444,74 @@ RLAPI void NodeUpdateAnimationTimeline( Node *node , float delta );
 RLAPI void NodeTreeUpdateAnimationTimeline( Node *root , float delta );
 #define UpdateNodeTreeAnimationTimeline NodeTreeUpdateAnimationTimeline
 
+RLAPI NodeAnimationLOD NodeGetAnimationLOD( Node *node , NodeView *view ); // Return the animation LOD of the node from its state in the view (NODE_ANIMATION_LOD_FULL if not tracked by the view)
+#define GetNodeAnimationLOD NodeGetAnimationLOD
+RLAPI void NodeTreeUpdateAnimationTimelineInView( Node *root , float delta , NodeView *view ); // Same as NodeTreeUpdateAnimationTimeline(), but each node is updated as its animation LOD in the view tells, and view->animationStats counts them
+#define UpdateNodeTreeAnimationTimelineInView NodeTreeUpdateAnimationTimelineInView
+RLAPI NodeAnimationLODSettings NodeAnimationLODDefaults( void ); // Return the default settings (see NODE_ANIMATION_LOD_*_DISTANCE)
+
+// Node views :
+
+RLAPI NodeView *NodeViewCreate( int slotsCount );
+#define CreateNodeView NodeViewCreate
+RLAPI NodeView *NodeViewRelease( NodeView *view ); // Return NULL
+#define ReleaseNodeView NodeViewRelease
+RLAPI void NodeViewResize( NodeView *view , int slotsCount ); // Keep the existing slots, and reset the new ones
+RLAPI void NodeViewReset( NodeView *view ); // Forget the visibility of all the nodes, and the culling caches
+RLAPI NodeViewSlot *NodeViewGetSlot( NodeView *view , Node *node ); // Return the state of the node in the view, or NULL if not tracked
+#define GetNodeViewSlot NodeViewGetSlot
+
+RLAPI int NodeTreeAssignSlots( Node *root , int firstSlot ); // Number the nodes of a tree that is not part of a scene. Return the next free slot.
+
 // Node drawing :
+// NOTE : the *InFrustum() functions don't record anything, the *InView() ones record the results into the view.
 
 RLAPI bool NodeDrawInFrustum( Node *node , Frustum *frustum ); // Draw the single node if visible inside the frustum and return true, else false
 #define DrawNodeInFrustum NodeDrawInFrustum
+RLAPI bool NodeDrawInFrustumEx( Node *node , Frustum *frustum , unsigned int planeMask ); // Same, but only test the frustum planes of the mask
 RLAPI int NodeTreeDrawInFrustum( Node *root , Frustum *frustum ); // Draw the node's tree hierachy that is visible inside the frustum, and return how mùany nodes were drawn
 #define DrawNodeTreeInFrustum NodeTreeDrawInFrustum 
 
+RLAPI bool NodeDrawInView( Node *node , NodeView *view ); // Same as NodeDrawInFrustum(), with the frustum of the view
+#define DrawNodeInView NodeDrawInView
+RLAPI bool NodeDrawInViewEx( Node *node , NodeView *view , unsigned int planeMask );
+RLAPI int NodeTreeDrawInView( Node *root , NodeView *view );
+#define DrawNodeTreeInView NodeTreeDrawInView
+
+// Node culling :
+// NOTE : same as the drawing functions above, but the visible nodes are appended to the list instead of being drawn.
+
+RLAPI bool NodeCullInFrustum( Node *node , Frustum *frustum , VisibleList *list );
+#define CullNodeInFrustum NodeCullInFrustum
+RLAPI bool NodeCullInFrustumEx( Node *node , Frustum *frustum , unsigned int planeMask , VisibleList *list );
+RLAPI int NodeTreeCullInFrustum( Node *root , Frustum *frustum , VisibleList *list ); // Return how many nodes were appended
+#define CullNodeTreeInFrustum NodeTreeCullInFrustum
+
+RLAPI bool NodeCullInView( Node *node , NodeView *view , VisibleList *list );
+#define CullNodeInView NodeCullInView
+RLAPI bool NodeCullInViewEx( Node *node , NodeView *view , unsigned int planeMask , VisibleList *list );
+RLAPI int NodeTreeCullInView( Node *root , NodeView *view , VisibleList *list );
+#define CullNodeTreeInView NodeTreeCullInView
+
+// Visible lists :
+
+RLAPI VisibleList *VisibleListCreate( int capacity );
+#define CreateVisibleList VisibleListCreate
+RLAPI VisibleList *VisibleListRelease( VisibleList *list ); // Return NULL
+#define ReleaseVisibleList VisibleListRelease
+RLAPI void VisibleListClear( VisibleList *list ); // Empty the list, but keep its buffer
+#define ClearVisibleList VisibleListClear
+RLAPI VisibleEntry *VisibleListAppend( VisibleList *list ); // Return a new entry at the end of the list, growing it if needed
+RLAPI void VisibleListSortByDepth( VisibleList *list , bool backToFront ); // Front to back for opaque meshes, back to front for transparent ones
+#define SortVisibleListByDepth VisibleListSortByDepth
+RLAPI int VisibleListDraw( VisibleList *list ); // Submit the entries to the renderer, and return how many meshes were drawn
+#define DrawVisibleList VisibleListDraw
+RLAPI int VisibleListSkin( VisibleList *list , SkinBatch *batch , WorkerPool *pool ); // Skin the poses of the animated entries into the skin cache on the pool (see SkinBatchRun()), before VisibleListDraw() uploads them. Return how many poses were skinned.
+#define SkinVisibleList VisibleListSkin
+
+RLAPI int NodeTreeRasterizeOccluders( Node *root , Frustum *frustum ); // Rasterize the occluders of the tree that are inside the frustum into its occlusion buffer, and return how many
+#define RasterizeNodeTreeOccluders NodeTreeRasterizeOccluders
+
 #if defined(__cplusplus)
 }
 #endif
@@ -239,6 +520,28 @@ RLAPI int NodeTreeDrawInFrustum( Node *root , Frustum *frustum ); // Draw the no
 
 #if defined(RNODES_IMPLEMENTATION)
 
+#include <stdlib.h> // Required for: qsort()
+
+void _NodeComputeTransforms( Node *node );
+void _NodeInvalidateSubtreeBox( Node *node );
+void _NodeSetWorldDirty( Node *node );
+bool _NodeRefreshTransforms( Node *node );
+void _NodeUnpackMatrix( Node *node , Matrix3x4 m );
+void _NodeBranchUpdateTransforms( Node *branch , bool siblings , bool parentMoved );
+void _NodeTreeChanged( Node *node );
+NodeVisitResult _NodeVisit( Node *branch , bool siblings , int orders , unsigned int state , NodeVisitCallback callback , void *userData , NodeStack *stack );
+bool _NodeDraw( Node *node , Frustum *frustum , NodeView *view , unsigned int planeMask , VisibleList *list );
+bool _NodeCull( Node *node , Frustum *frustum , NodeView *view , unsigned int planeMask , VisibleEntry *entry );
+int _NodeDrawEntry( VisibleEntry *entry );
+bool _NodeIsAnimated( Node *node );
+void _NodeAdvanceAnimation( Node *node , float delta , bool pose );
+
+unsigned int _nodeHierarchyVersion = 1 ; // Version given to the trees that change, until one of them is read (see NodeGetHierarchyVersion())
+
+NodeStack _nodeStack = { 0 }; // Used by the traversals that are not given a stack
+
+AnimationCompression _animationsCompression = { false , true , ANIMATION_COMPRESSION_TRANSLATION_ERROR , ANIMATION_COMPRESSION_ROTATION_ERROR , ANIMATION_COMPRESSION_SCALE_ERROR };
+AnimationCompressionReport _animationsCompressionReport = { 0 };
 
 void NodeSetName( Node *node , char *name )
 {
@@ -273,7 +576,7 @@ Node3D NodeAsGroup( char * name )
 	node.tint = WHITE ;
 
 	node.position = Vector3Zero();
-	node.rotation = MatrixIdentity();
+	node.rotation = QuaternionIdentity();
 	node.scale    = Vector3One();
 
 	node.positionRelativeToParentBoneId = -1 ;
@@ -281,23 +584,36 @@ Node3D NodeAsGroup( char * name )
 
 	node.transform = MatrixIdentity();
 
+	node.localTransform = Matrix3x4FromMatrix( MatrixIdentity() );
+	node.localDirty = true ;
+	node.worldDirty = true ;
+
+	node.inverseTransformValid = false ;
+
 	node.untransformedBox.min = Vector3Zero();
 	node.untransformedBox.max = Vector3Zero();
 
 	node.untransformedCenter = Vector3Zero();
 	node.untransformedRadius = 0.0f;
 
+	node.subtreeBox = BoundingBoxEmpty();
+	node.subtreeBoxValid = false ;
+
+	node.baked = false ;
+
 	node.parent = NULL ;
 	node.firstChild = NULL ;
 	node.nextSibling = NULL ;
 	node.prevSibling = NULL ;
 
+	node.hierarchyVersion = 0 ;
+
 	node.nextLOD = NULL ;
 	node.nextDistance = 0.0f ;
-	node.activeLOD = NULL ;
 
-	node.lastFrustum = NULL ;
-	node.insideFrustum = false ;
+	node.slot = -1 ;
+
+	node.occluder = false ;
 
 	node.animations.list = NULL ;
 	node.animations.count = 0 ;
@@ -307,6 +623,8 @@ Node3D NodeAsGroup( char * name )
 	node.animRemainingLoops = -1 ;
 	node.animEventCallback = NULL ;
 
+	node.pose = (AnimationPose){ 0 };
+
 	node.userData = NULL ;
 
 	return node;
@@ -326,6 +644,10 @@ Node3D NodeReplaceModel( Node3D node , Model *model )
 {
 	node.model = model ;
 
+	// The pose was sampled for the bind pose of the previous model :
+
+	node.pose.animation = NULL ;
+
 	// Get the untransformed boundings :
 
 	if ( model != NULL )
@@ -369,6 +691,10 @@ void NodeRemoveLOD( Node *node , Node *lod )
 	}
 
 	lod->nextLOD = NULL ;
+
+	// The node may not be drawable anymore :
+
+	_NodeInvalidateSubtreeBox( node );
 }
 
 void NodeInsertLOD( Node *node , Node *lod , float distance )
@@ -426,19 +752,80 @@ void NodeInsertLOD( Node *node , Node *lod , float distance )
 
 	// Unless there is a bug in my algorithm
 	// the new LOD should be in place
+
+	// The node may be drawable now :
+
+	_NodeInvalidateSubtreeBox( node );
 }
 
 void NodeUnpackTransforms( Node *node )
 {
-	node->position = (Vector3){ node->transform.m12 , node->transform.m13 , node->transform.m14 };
+	_NodeUnpackMatrix( node , Matrix3x4FromMatrix( node->transform ) );
+}
+
+// Decompose an affine matrix into the position, scale and rotation of the node.
+// NOTE : the axis are divided by the scales instead of being normalized again.
+void _NodeUnpackMatrix( Node *node , Matrix3x4 m )
+{
+	node->position = (Vector3){ m.m12 , m.m13 , m.m14 };
 
 	node->scale = (Vector3){
-		sqrtf( node->transform.m0*node->transform.m0 + node->transform.m1*node->transform.m1 + node->transform.m2*node->transform.m2 ),
-		sqrtf( node->transform.m4*node->transform.m4 + node->transform.m5*node->transform.m5 + node->transform.m6*node->transform.m6 ),
-		sqrtf( node->transform.m8*node->transform.m8 + node->transform.m9*node->transform.m9 + node->transform.m10*node->transform.m10 )
+		sqrtf( m.m0*m.m0 + m.m1*m.m1 + m.m2*m.m2 ),
+		sqrtf( m.m4*m.m4 + m.m5*m.m5 + m.m6*m.m6 ),
+		sqrtf( m.m8*m.m8 + m.m9*m.m9 + m.m10*m.m10 )
 	};
 
-	node->rotation = MatrixRotation( node->transform );
+	Matrix rotation = MatrixIdentity();
+
+	rotation.m0 = m.m0/node->scale.x ; rotation.m1 = m.m1/node->scale.x ; rotation.m2  = m.m2/node->scale.x ;
+	rotation.m4 = m.m4/node->scale.y ; rotation.m5 = m.m5/node->scale.y ; rotation.m6  = m.m6/node->scale.y ;
+	rotation.m8 = m.m8/node->scale.z ; rotation.m9 = m.m9/node->scale.z ; rotation.m10 = m.m10/node->scale.z ;
+
+	node->rotation = QuaternionFromMatrix( rotation );
+
+	NodeSetDirty( node );
+}
+
+// Recompute the transform of the node if it, or one of its ancestors, is dirty. Return true if recomputed.
+// NOTE : the ancestors are pushed on the shared stack, then updated from the root down (no recursion, as the traversals).
+bool _NodeRefreshTransforms( Node *node )
+{
+	NodeStack *stack = &_nodeStack ;
+
+	int base = stack->count ;
+
+	for( Node3D *ancestor = node ; ancestor != NULL ; ancestor = ancestor->parent )
+	{
+		NodeStackPush( stack , ancestor , 0 );
+	}
+
+	bool moved = false ;
+
+	while( stack->count > base )
+	{
+		Node3D *ancestor = stack->entries[ --stack->count ].node ;
+
+		if ( moved || ancestor->localDirty || ancestor->worldDirty )
+		{
+			NodeUpdateTransforms( ancestor );
+			moved = true ;
+		}
+	}
+
+	return moved ;
+}
+
+Matrix3x4 NodeGetInverseTransform( Node *node )
+{
+	_NodeRefreshTransforms( node );
+
+	if ( ! node->inverseTransformValid )
+	{
+		node->inverseTransform = Matrix3x4Invert( Matrix3x4FromMatrix( node->transform ) );
+		node->inverseTransformValid = true ;
+	}
+
+	return node->inverseTransform ;
 }
 
 // Detach a node's branch from its parent
@@ -446,7 +833,7 @@ void NodeDetachBranch( Node *node )
 {
 	// Node's branch is the node and its own childrens.
 	// We want to detach this branch from the parent.
-	// If the node has siblings, we must also extract it from the siblings chain /!\
+	// /!\ If the node has siblings, we must also extract it from the siblings chain.
 
 	Node3D *prev = node->prevSibling ;
 	Node3D *next = node->nextSibling ;
@@ -464,6 +851,11 @@ void NodeDetachBranch( Node *node )
 	//                                [       ]
 	//                                [ child ]
 
+	// The branch won't be part of the parent's subtree anymore :
+
+	_NodeInvalidateSubtreeBox( node->parent );
+	_NodeTreeChanged( node->parent );
+
 	// Extraction from the siblings chain :
 
 	if ( prev != NULL ) prev->nextSibling = next ;
@@ -487,6 +879,12 @@ void NodeDetachBranch( Node *node )
 	node->prevSibling = NULL ;
 	node->positionRelativeToParentBoneId = -1 ;
 	node->positionRelativeToParentBoneName = NULL ;
+
+	// Its transforms are not relative to the parent anymore :
+
+	_NodeSetWorldDirty( node );
+
+	_NodeTreeChanged( node );
 }
 
 // Remove a node from its parent, siblings and children
@@ -540,6 +938,9 @@ void NodeRemove( Node *node )
 	}
 	else // If the node has no child, we just remove it :
 	{
+		_NodeInvalidateSubtreeBox( node->parent );
+		_NodeTreeChanged( node->parent );
+
 		// Shortcircuit the node in the siblings chain :
 		if ( prev != NULL ) prev->nextSibling = next ;
 		if ( next != NULL )	next->prevSibling = prev ;
@@ -563,24 +964,46 @@ void NodeRemove( Node *node )
 	node->firstChild  = NULL ;
 	node->positionRelativeToParentBoneId = -1 ;
 	node->positionRelativeToParentBoneName = NULL ;
+
+	_NodeSetWorldDirty( node );
+
+	_NodeTreeChanged( node );
 }
 
 // Same as NodeAttachChild except that the child remains in same global space location
 void NodeTakeChild( Node *parent , Node *child )
 {
-	if ( child->parent != NULL )
+	NodeTakeChildren( parent , &child , 1 );
+}
+
+void NodeTakeChildren( Node *parent , Node **children , int count )
+{
+	// The inverse is cached by the parent, so it is computed once for all the children (and the next calls) :
+
+	Matrix3x4 inverse = NodeGetInverseTransform( parent );
+
+	for( int i = 0 ; i < count ; i++ )
 	{
-		NodeAbandonBranch( child ); 
-	}
+		Node *child = children[i] ;
 
-	NodeUpdateTransforms( parent );
-	NodeUpdateTransforms( child );
+		_NodeRefreshTransforms( child );
 
-	child->transform = MatrixMultiply( child->transform , MatrixInvert( parent->transform ) );
-	
-	NodeUnpackTransforms( child );
+		// Global transform into parent's space :
+
+		Matrix3x4 global = Matrix3x4FromMatrix( child->transform );
+		Matrix3x4 relative ;
+
+		MatrixMultiplyAffineBatch( &global , &inverse , &relative , 1 );
 
-	NodeAttachChild( parent , child );
+		if ( child->parent != NULL )
+		{
+			NodeDetachBranch( child );
+		}
+
+		_NodeUnpackMatrix( child , relative );
+
+		NodeAttachChild( parent , child );
+	}
 }
 
 
@@ -613,7 +1036,7 @@ void NodeAttachChildToBone( Node *parent , Node *child , char *boneName )
 			{
 				child->position = parent->model->bindPose[i].translation ;
 				child->scale    = parent->model->bindPose[i].scale ;
-				child->rotation = QuaternionToMatrix( parent->model->bindPose[i].rotation );
+				child->rotation = parent->model->bindPose[i].rotation ;
 				child->positionRelativeToParentBoneId = i ;
 				child->positionRelativeToParentBoneName = parent->model->bones[i].name ;
 				NodeUpdateTransforms( child );
@@ -655,6 +1078,9 @@ void NodeAttachChild( Node *parent, Node *child )
 
 	child->parent = parent ;
 
+	_NodeTreeChanged( child );
+	_NodeTreeChanged( parent );
+
 	if ( parent != NULL )
 	{
 		if ( parent->firstChild == NULL )
@@ -670,31 +1096,111 @@ void NodeAttachChild( Node *parent, Node *child )
 			parent->firstChild->prevSibling = child ;
 			parent->firstChild = child ;
 		}
+	}
 
-		// Move child's transforms to parent's space :
+	// The child keeps its relative transforms, only its transform must be recomputed in parent's space :
 
-		NodeUpdateTransforms( child );
-		child->transform = MatrixMultiply( child->transform , MatrixInvert( parent->transform ));
-		NodeUnpackTransforms( child );
-	}
+	_NodeSetWorldDirty( child );
 }
 
 
 AnimationsList AnimationsListLoad( char *fileName )
 {
-	AnimationsList anims ;
+	AnimationsList anims = { 0 };
 
 	anims.list = LoadModelAnimations( fileName , &anims.count );
 
+	if ( _animationsCompression.enabled && anims.count > 0 )
+	{
+		AnimationCompressionReport report = AnimationsListCompress( &anims , _animationsCompression );
+
+		TRACELOG( LOG_INFO , "ANIMATIONS: `%s` compressed from %d KB to %d KB (%d of %d tracks constant, %d raw, %d keys removed)." , fileName ,
+			(int)( report.rawSize/1024 ) , (int)( report.compressedSize/1024 ) , report.constantTracks , report.tracks , report.rawTracks , report.removedKeys );
+	}
+
 	return anims ;
 }
 
+void AnimationsListUnload( AnimationsList *anims )
+{
+	if ( anims->clips != NULL )
+	{
+		for( int i = 0 ; i < anims->count ; i++ ) AnimationClipUnload( &anims->clips[i] );
+
+		MemFree( anims->clips );
+	}
+
+	// NOTE : the frame poses freed by the compression are NULL, which UnloadModelAnimations() accepts.
+
+	if ( anims->list != NULL ) UnloadModelAnimations( anims->list , anims->count );
+
+	*anims = (AnimationsList){ 0 };
+}
+
+AnimationCompressionReport AnimationsListCompress( AnimationsList *anims , AnimationCompression compression )
+{
+	AnimationCompressionReport report = { 0 };
+
+	if ( anims->clips == NULL ) anims->clips = (AnimationClip*)MemAlloc( sizeof( AnimationClip )*anims->count );
+
+	for( int i = 0 ; i < anims->count ; i++ )
+	{
+		ModelAnimation *animation = &anims->list[i] ;
+
+		if ( anims->clips[i].tracks != NULL ) continue ; // Compressed already
+
+		anims->clips[i] = AnimationClipCompress( animation , compression , &report );
+
+		if ( anims->clips[i].tracks == NULL ) continue ;
+
+		for( int f = 0 ; f < animation->frameCount ; f++ )
+		{
+			MemFree( animation->framePoses[f] );
+			animation->framePoses[f] = NULL ;
+		}
+	}
+
+	AnimationCompressionReport *total = &_animationsCompressionReport ;
+
+	total->clips += report.clips ;
+	total->tracks += report.tracks ;
+	total->constantTracks += report.constantTracks ;
+	total->rawTracks += report.rawTracks ;
+	total->keys += report.keys ;
+	total->removedKeys += report.removedKeys ;
+	total->rawSize += report.rawSize ;
+	total->compressedSize += report.compressedSize ;
+	total->translationError = fmaxf( total->translationError , report.translationError );
+	total->rotationError = fmaxf( total->rotationError , report.rotationError );
+	total->scaleError = fmaxf( total->scaleError , report.scaleError );
+
+	return report ;
+}
+
+void AnimationsListSetCompression( AnimationCompression compression )
+{
+	_animationsCompression = compression ;
+}
+
+AnimationCompressionReport AnimationsListGetCompressionReport( void )
+{
+	return _animationsCompressionReport ;
+}
+
+Transform AnimationsListSampleBone( AnimationsList *anims , int index , int frame , int bone )
+{
+	if ( anims->clips != NULL ) return AnimationClipSampleBone( &anims->clips[ index ] , frame , bone );
+
+	ModelAnimation *animation = &anims->list[ index ] ;
+
+	return animation->framePoses[ frame < 0 ? 0 : frame % animation->frameCount ][ bone ] ;
+}
+
 void NodeSetAnimationsList( Node *node , AnimationsList *anims )
 {
 	if ( anims == NULL )
 	{
-		node->animations.list = NULL ;
-		node->animations.count = 0 ;
+		node->animations = (AnimationsList){ 0 };
 	}
 	else
 	{
@@ -712,6 +1218,8 @@ void NodePlayAnimationIndex( Node *node , int index )
 {
 	node->currentAnimationIndex = index ;
 	node->animPosition = 0.0f ;
+
+	NodeSetDirty( node );
 }
 
 void NodePlayAnimationName( Node *node , char *name )
@@ -731,27 +1239,117 @@ void NodeSetAnimationEventCallback( Node *node , NodeAnimationEventCallback call
 	node->animEventCallback = callback ;
 }
 
+// NOTE : the animations of a baked branch are frozen (see NodeBakeStatic()).
+NodeVisitResult _NodeTimelineVisit( Node *node , int order , unsigned int *state , void *userData )
+{
+	if ( node->baked ) return NODE_VISIT_PRUNE ;
+
+	NodeUpdateAnimationTimeline( node , *(float*)userData );
+
+	return NODE_VISIT_CONTINUE ;
+}
+
 void NodeTreeUpdateAnimationTimeline( Node *root , float delta )
 {
-	Node3D *sibling ;
-	Node3D *node = root ;
+	NodeTreeVisit( root , NODE_VISIT_PRE_ORDER , 0 , _NodeTimelineVisit , &delta , NULL );
+}
 
-	while( node )
-	{
-		NodeUpdateAnimationTimeline( node , delta );
+typedef struct _NodeTimelineTraversal
+{
+	float delta ;
+	NodeView *view ;
 
-		sibling = node ;
-		while( sibling = sibling->nextSibling )
-		{
-			NodeUpdateAnimationTimeline( sibling , delta);
-		}
+} _NodeTimelineTraversal;
+
+// Same, with the animation LOD of the node in the view :
+NodeVisitResult _NodeTimelineInViewVisit( Node *node , int order , unsigned int *state , void *userData )
+{
+	_NodeTimelineTraversal *timeline = (_NodeTimelineTraversal*)userData ;
+	NodeView *view = timeline->view ;
+
+	if ( node->baked ) return NODE_VISIT_PRUNE ;
+
+	if ( ! _NodeIsAnimated( node ) ) return NODE_VISIT_CONTINUE ;
+
+	NodeAnimationLOD lod = NodeGetAnimationLOD( node , view );
+
+	// NOTE : the reduced nodes are spread over the frames by their slot.
+
+	bool pose = lod == NODE_ANIMATION_LOD_FULL
+		|| ( lod == NODE_ANIMATION_LOD_REDUCED && ( view->animationLOD.reducedPeriod <= 1 || ( view->animationFrame + (unsigned int)node->slot ) % (unsigned int)view->animationLOD.reducedPeriod == 0 ) );
 
-		node = node->firstChild ;
+	if ( lod != NODE_ANIMATION_LOD_FROZEN ) _NodeAdvanceAnimation( node , timeline->delta , pose );
+
+	view->animationStats.nodes[ lod ]++ ;
+	if ( pose ) view->animationStats.posed++ ;
+
+	return NODE_VISIT_CONTINUE ;
+}
+
+void NodeTreeUpdateAnimationTimelineInView( Node *root , float delta , NodeView *view )
+{
+	if ( view == NULL )
+	{
+		NodeTreeUpdateAnimationTimeline( root , delta );
+		return ;
 	}
+
+	_NodeTimelineTraversal timeline = { delta , view };
+
+	view->animationStats = (NodeAnimationLODStats){ 0 };
+
+	NodeTreeVisit( root , NODE_VISIT_PRE_ORDER , 0 , _NodeTimelineInViewVisit , &timeline , &view->stack );
+
+	view->animationFrame++ ;
+}
+
+NodeAnimationLODSettings NodeAnimationLODDefaults( void )
+{
+	NodeAnimationLODSettings settings ;
+
+	settings.fullDistance = NODE_ANIMATION_LOD_FULL_DISTANCE ;
+	settings.reducedDistance = NODE_ANIMATION_LOD_REDUCED_DISTANCE ;
+	settings.reducedPeriod = NODE_ANIMATION_LOD_REDUCED_PERIOD ;
+	settings.frozenDistance = NODE_ANIMATION_LOD_FROZEN_DISTANCE ;
+	settings.hiddenLOD = NODE_ANIMATION_LOD_TIMELINE ;
+
+	return settings ;
+}
+
+// NOTE : the distance of a node outside the view is the one of the last draw too, even if its branch was culled at once.
+NodeAnimationLOD NodeGetAnimationLOD( Node *node , NodeView *view )
+{
+	NodeViewSlot *slot = NodeViewGetSlot( view , node );
+
+	if ( slot == NULL ) return NODE_ANIMATION_LOD_FULL ;
+
+	NodeAnimationLODSettings *settings = &view->animationLOD ;
+
+	if ( slot->distanceToCamera >= settings->frozenDistance ) return NODE_ANIMATION_LOD_FROZEN ;
+
+	if ( ! slot->insideFrustum ) return settings->hiddenLOD ;
+
+	if ( slot->distanceToCamera < settings->fullDistance ) return NODE_ANIMATION_LOD_FULL ;
+	if ( slot->distanceToCamera < settings->reducedDistance ) return NODE_ANIMATION_LOD_REDUCED ;
+
+	return NODE_ANIMATION_LOD_TIMELINE ;
+}
+
+// True if the node has an animation playing.
+bool _NodeIsAnimated( Node *node )
+{
+	return node->animations.list != NULL && node->currentAnimationIndex >= 0 && node->currentAnimationIndex < node->animations.count
+		&& node->animPosition >= 0.0f && node->animRemainingLoops != 0 ;
 }
 
 // Update the current animation timeline and call the event callback if set.
 void NodeUpdateAnimationTimeline( Node *node , float delta )
+{
+	_NodeAdvanceAnimation( node , delta , true );
+}
+
+// Advance the timeline, and if pose is true, mark the node dirty so that its pose is sampled by the next transforms update.
+void _NodeAdvanceAnimation( Node *node , float delta , bool pose )
 {
 	// TODO? Update the timeline of the active lod only ? of the main LOD only ? or of all lods ?
 	//if ( node->activeLOD ) node = node->activeLOD ; 
@@ -768,6 +1366,10 @@ void NodeUpdateAnimationTimeline( Node *node , float delta )
 
 	node->animPosition += delta * node->animSpeed ;
 
+	// The model and the nodes attached to its bones must be updated :
+
+	if ( pose ) NodeSetDirty( node );
+
 	// Calculate the frame :
 	
 	int frame = (int)node->animPosition;
@@ -812,43 +1414,145 @@ void NodeUpdateAnimationTimeline( Node *node , float delta )
 	}
 }
 
+// Update the transforms of a single node.
+// NOTE : the subtree boundings of the node and its ancestors are not valid anymore
+// till the next NodeTreeUpdateTransforms().
 void NodeUpdateTransforms( Node *node )
 {
-	// Update animations :
+	_NodeComputeTransforms( node );
+	_NodeInvalidateSubtreeBox( node );
 
-	if ( node->model != NULL && node->animations.list != NULL && node->currentAnimationIndex >= 0 && node->currentAnimationIndex < node->animations.count )
+	// The children were computed with the previous transform :
+
+	for( Node3D *child = node->firstChild ; child != NULL ; child = child->nextSibling )
 	{
-		if ( node->activeLOD == NULL || node->activeLOD == node )
-		{
-			UpdateModelAnimation( *node->model , node->animations.list[ node->currentAnimationIndex ] , (int)node->animPosition );
+		_NodeSetWorldDirty( child );
+	}
+}
 
-		}
+// Give the current version to the node and its ancestors, up to the root of its tree (NULL : nothing to do).
+// NOTE : the ancestors of a node that has the current version have it too, so the walk stops there,
+// and building a deep tree doesn't walk up to the root on each attach.
+void _NodeTreeChanged( Node *node )
+{
+	for( ; node != NULL && node->hierarchyVersion != _nodeHierarchyVersion ; node = node->parent )
+	{
+		node->hierarchyVersion = _nodeHierarchyVersion ;
 	}
+}
 
-	// Update position relative to parent's animated bone :
+// NOTE : doesn't modify anything, so that it can be compared while culling on several threads.
+unsigned int NodePeekHierarchyVersion( Node *node )
+{
+	if ( node == NULL ) return 0 ;
 
-	if ( node->parent != NULL && node->positionRelativeToParentBoneId >= 0 && node->positionRelativeToParentBoneId < node->parent->model->boneCount && node->parent->currentAnimationIndex < node->parent->animations.count && node->parent->animations.list != NULL )
-	{
-		int boneId = node->positionRelativeToParentBoneId ;
-		int frame  = (int)node->parent->animPosition ;
+	while( node->parent != NULL ) node = node->parent ;
 
-		ModelAnimation anim = node->parent->animations.list[ node->parent->currentAnimationIndex ] ;
+	return node->hierarchyVersion ;
+}
 
-		node->position = anim.framePoses[frame][boneId].translation; ;
-		node->scale    = anim.framePoses[frame][boneId].scale ;
-		node->rotation = QuaternionToMatrix( anim.framePoses[frame][boneId].rotation );
-	}
+unsigned int NodeGetHierarchyVersion( Node *node )
+{
+	unsigned int version = NodePeekHierarchyVersion( node );
 
-	// Calculate node's transformation matrix
-	// Get transform matrix (rotation -> scale -> translation)
+	// The next changes of this tree must give it another version than the one returned :
 
-	Matrix matScale       = MatrixScale( node->scale.x , node->scale.y , node->scale.z );
-	Matrix matTranslation = MatrixTranslate( node->position.x , node->position.y , node->position.z );
+	if ( version == _nodeHierarchyVersion ) _nodeHierarchyVersion++ ;
 
-	node->transform = MatrixMultiply( MatrixMultiply( matScale , node->rotation ) , matTranslation );
+	return version ;
+}
 
-/*	if ( node->model ) TODO ???
-	{
+void NodeSetDirty( Node *node )
+{
+	node->localDirty = true ;
+
+	_NodeInvalidateSubtreeBox( node );
+}
+
+// The transform of the node must be recomputed, but not its localTransform.
+void _NodeSetWorldDirty( Node *node )
+{
+	node->worldDirty = true ;
+
+	_NodeInvalidateSubtreeBox( node );
+}
+
+// Mark the subtree boundings of the node and its ancestors as invalid, and un-bake them.
+// NOTE : if a node is invalid, all its ancestors are invalid too, so we can stop at the first one that already is.
+// A baked node is always valid, so its baked ancestors are reached too. Its baked descendants are un-baked
+// by the next update, if the node moved.
+void _NodeInvalidateSubtreeBox( Node *node )
+{
+	if ( node == NULL ) return ;
+
+	node->subtreeBoxValid = false ;
+	node->baked = false ;
+
+	for( node = node->parent ; node != NULL && node->subtreeBoxValid ; node = node->parent )
+	{
+		node->subtreeBoxValid = false ;
+		node->baked = false ;
+	}
+}
+
+// Sample the pose of the model on the current frame of its animation, and pose the node on its parent's bone if attached to one.
+// NOTE : called by the transforms update on the nodes that moved, before their local transform is rebuilt.
+// The model itself is skinned when the node is drawn, so the nodes sharing it don't overwrite each other.
+void NodeUpdateAnimationPose( Node *node )
+{
+	// Update animations :
+
+	// NOTE : the active LOD depends on the view now, so the main model is always animated.
+
+	if ( node->model != NULL && node->animations.list != NULL && node->currentAnimationIndex >= 0 && node->currentAnimationIndex < node->animations.count )
+	{
+		if ( node->animations.clips != NULL )
+		{
+			AnimationPoseSampleClip( &node->pose , node->model , &node->animations.clips[ node->currentAnimationIndex ] , (int)node->animPosition );
+		}
+		else
+		{
+			AnimationPoseSample( &node->pose , node->model , &node->animations.list[ node->currentAnimationIndex ] , (int)node->animPosition );
+		}
+	}
+
+	// Update position relative to parent's animated bone :
+
+	if ( node->parent != NULL && node->positionRelativeToParentBoneId >= 0 && node->positionRelativeToParentBoneId < node->parent->model->boneCount && node->parent->currentAnimationIndex < node->parent->animations.count && node->parent->animations.list != NULL )
+	{
+		int boneId = node->positionRelativeToParentBoneId ;
+		int frame  = (int)node->parent->animPosition ;
+
+		Transform bone = AnimationsListSampleBone( &node->parent->animations , node->parent->currentAnimationIndex , frame , boneId );
+
+		node->position = bone.translation ;
+		node->scale    = bone.scale ;
+		node->rotation = bone.rotation ;
+
+		node->localDirty = true ;
+	}
+}
+
+void NodeUnloadPose( Node *node )
+{
+	AnimationPoseUnload( &node->pose );
+}
+
+void _NodeComputeTransforms( Node *node )
+{
+	NodeUpdateAnimationPose( node );
+
+	// Calculate node's transformation matrix
+	// Get transform matrix (rotation -> scale -> translation)
+	// NOTE : it is cached, so a node that only moved with its parent skips it.
+
+	if ( node->localDirty )
+	{
+		node->localTransform = TransformCompose( node->position , node->scale , node->rotation );
+	}
+
+/*	if ( node->model ) TODO ???
+	{
 		print_Matrix( node->transform , "node->transform (before)" );
 		print_Matrix( node->model->transform , "node->model->transform" );
 
@@ -858,86 +1562,418 @@ void NodeUpdateTransforms( Node *node )
 		print_Matrix( node->transform , "node->transform (after)" );
 	}
 */
-	if ( node->parent )
-	{
-		node->transform = MatrixMultiply( node->transform , node->parent->transform );
-	}
+	// Combine with parent's transforms, and update transformed boundings in the same pass :
+
+	Matrix3x4 parentTransform ;
 
-	// Update transformed boundings :
-	node->transformedBox = BoundingBoxTransform( node->untransformedBox , node->transform );
+	if ( node->parent ) parentTransform = Matrix3x4FromMatrix( node->parent->transform );
+
+	node->transform = Matrix3x4ToMatrix( TransformComposeWorld( node->localTransform , node->parent ? &parentTransform : NULL , node->untransformedBox , &node->transformedBox ) );
+	node->inverseTransformValid = false ;
 
 	node->transformedCenter.x = ( node->transformedBox.min.x + node->transformedBox.max.x )*0.5f ;
 	node->transformedCenter.y = ( node->transformedBox.min.y + node->transformedBox.max.y )*0.5f ;
 	node->transformedCenter.z = ( node->transformedBox.min.z + node->transformedBox.max.z )*0.5f ;
 
 	node->transformedRadius = Vector3Distance( node->transformedBox.min , node->transformedBox.max )*0.5f ;
+
+	node->localDirty = false ;
+	node->worldDirty = false ;
+}
+
+NodeStack *NodeStackCreate( int capacity )
+{
+	NodeStack *stack = (NodeStack*)MemAlloc( sizeof( NodeStack ) );
+
+	if ( capacity < 1 ) capacity = 1 ;
+
+	stack->entries = (NodeStackEntry*)MemAlloc( sizeof( NodeStackEntry )*capacity );
+	stack->count = 0 ;
+	stack->capacity = capacity ;
+
+	return stack ;
+}
+
+NodeStack *NodeStackRelease( NodeStack *stack )
+{
+	if ( stack == NULL ) return NULL ;
+
+	MemFree( stack->entries );
+	MemFree( stack );
+
+	return NULL ;
+}
+
+void NodeStackPush( NodeStack *stack , Node3D *node , unsigned int state )
+{
+	if ( stack->count >= stack->capacity )
+	{
+		stack->capacity = stack->capacity > 0 ? stack->capacity*2 : 64 ;
+		stack->entries = (NodeStackEntry*)MemRealloc( stack->entries , sizeof( NodeStackEntry )*stack->capacity );
+	}
+
+	stack->entries[ stack->count++ ] = (NodeStackEntry){ node , state , false };
+}
+
+// Depth-first traversal of the branch, and of its next siblings if asked, without recursion.
+// NOTE : the stack only holds the ancestors of the visited node : when a node is done, its next sibling takes its place.
+// The entries are pushed above the ones already there, so a callback can start another traversal with the same stack.
+NodeVisitResult _NodeVisit( Node *branch , bool siblings , int orders , unsigned int state , NodeVisitCallback callback , void *userData , NodeStack *stack )
+{
+	if ( branch == NULL ) return NODE_VISIT_CONTINUE ;
+
+	if ( stack == NULL ) stack = &_nodeStack ;
+
+	int base = stack->count ;
+
+	NodeStackPush( stack , branch , state );
+
+	while( stack->count > base )
+	{
+		// NOTE : the entries move when the stack grows (even during the callback), so they are accessed by index.
+
+		int top = stack->count - 1 ;
+
+		Node3D *node = stack->entries[ top ].node ;
+		unsigned int nodeState = stack->entries[ top ].state ;
+
+		if ( ! stack->entries[ top ].entered )
+		{
+			NodeVisitResult result = NODE_VISIT_CONTINUE ;
+
+			stack->entries[ top ].entered = true ;
+
+			if ( orders & NODE_VISIT_PRE_ORDER )
+			{
+				result = callback( node , NODE_VISIT_PRE_ORDER , &nodeState , userData );
+
+				stack->entries[ top ].state = nodeState ;
+			}
+
+			if ( result == NODE_VISIT_STOP )
+			{
+				stack->count = base ;
+				return NODE_VISIT_STOP ;
+			}
+
+			if ( result == NODE_VISIT_CONTINUE && node->firstChild != NULL )
+			{
+				NodeStackPush( stack , node->firstChild , nodeState );
+				continue ;
+			}
+		}
+
+		// The children are done :
+
+		if ( ( orders & NODE_VISIT_POST_ORDER ) && callback( node , NODE_VISIT_POST_ORDER , &nodeState , userData ) == NODE_VISIT_STOP )
+		{
+			stack->count = base ;
+			return NODE_VISIT_STOP ;
+		}
+
+		stack->count-- ;
+
+		// The next sibling takes its place, with the state of their parent :
+
+		if ( node->nextSibling != NULL && ( stack->count > base || siblings ) )
+		{
+			NodeStackPush( stack , node->nextSibling , stack->count > base ? stack->entries[ stack->count - 1 ].state : state );
+		}
+	}
+
+	return NODE_VISIT_CONTINUE ;
+}
+
+NodeVisitResult NodeBranchVisit( Node *branch , int orders , unsigned int state , NodeVisitCallback callback , void *userData , NodeStack *stack )
+{
+	return _NodeVisit( branch , false , orders , state , callback , userData , stack );
+}
+
+NodeVisitResult NodeTreeVisit( Node *root , int orders , unsigned int state , NodeVisitCallback callback , void *userData , NodeStack *stack )
+{
+	return _NodeVisit( root , true , orders , state , callback , userData , stack );
+}
+
+typedef struct _NodeTraversal
+{
+	NodeTreeTraversalCallback callback ;
+	void *userData ;
+
+} _NodeTraversal;
+
+NodeVisitResult _NodeTraversalVisit( Node *node , int order , unsigned int *state , void *userData )
+{
+	_NodeTraversal *traversal = (_NodeTraversal*)userData ;
+
+	traversal->callback( node , traversal->userData );
+
+	return NODE_VISIT_CONTINUE ;
 }
 
 void NodeTreeTraversal( Node *root , NodeTreeTraversalCallback callback , void *userData )
 {
-	Node3D *sibling ;
-	Node3D *node = root ;
+	_NodeTraversal traversal = { callback , userData };
+
+	NodeTreeVisit( root , NODE_VISIT_PRE_ORDER , 0 , _NodeTraversalVisit , &traversal , NULL );
+}
 
-	while( node )
+// Update the transforms of the dirty nodes and of their descendants, then the subtree boundings.
+// NOTE : the state tells if the parent moved. Marking a node dirty invalidates the subtree boundings of its ancestors,
+// so a valid branch whose parent didn't move has nothing to update, and is pruned at once.
+// userData is the parent of the traversed branch, whose subtree boundings are not updated.
+NodeVisitResult _NodeUpdateVisit( Node *node , int order , unsigned int *state , void *userData )
+{
+	if ( order == NODE_VISIT_PRE_ORDER )
 	{
-		callback( node , userData );
+		bool moved = *state != 0 || node->localDirty || node->worldDirty ;
+
+		if ( ! moved && node->subtreeBoxValid ) return NODE_VISIT_PRUNE ;
 
-		sibling = node ;
-		while( sibling = sibling->nextSibling )
+		if ( moved )
 		{
-			NodeTreeTraversal( sibling , callback , userData );
+			// An ancestor moved, so the branch is not static anymore :
+
+			node->baked = false ;
+
+			_NodeComputeTransforms( node );
 		}
 
-		node = node->firstChild ;
+		// Only the nodes that can be drawn are part of the subtree boundings :
+
+		node->subtreeBox = NodeIsDrawable( node ) ? node->transformedBox : BoundingBoxEmpty();
+
+		*state = moved ;
 	}
+	else
+	{
+		// The children merged their subtree boundings into the node, so it is complete :
+
+		node->subtreeBoxValid = true ;
+
+		if ( node->parent != (Node*)userData )
+		{
+			node->parent->subtreeBox = BoundingBoxMerge( node->parent->subtreeBox , node->subtreeBox );
+		}
+	}
+
+	return NODE_VISIT_CONTINUE ;
+}
+
+void _NodeBranchUpdateTransforms( Node *branch , bool siblings , bool parentMoved )
+{
+	_NodeVisit( branch , siblings , NODE_VISIT_PRE_ORDER | NODE_VISIT_POST_ORDER , parentMoved , _NodeUpdateVisit , branch->parent , NULL );
 }
 
 void NodeTreeUpdateTransforms( Node *root )
 {
-	Node3D *sibling ;
-	Node3D *node = root ;
+	if ( root == NULL ) return ;
+
+	// NOTE : the ancestors of the root are not updated, so the root is recomputed in case they moved.
+
+	_NodeBranchUpdateTransforms( root , true , root->parent != NULL );
+
+	// The ancestors of the root were not updated, so their subtree boundings may be wrong now :
+
+	_NodeInvalidateSubtreeBox( root->parent );
+}
+
+// Freeze the whole branch.
+// NOTE : its transforms and subtree boundings must be up to date. userData counts the baked nodes.
+NodeVisitResult _NodeBakeVisit( Node *node , int order , unsigned int *state , void *userData )
+{
+	node->baked = true ;
+
+	(*(int*)userData)++ ;
+
+	return NODE_VISIT_CONTINUE ;
+}
+
+// A node is static if its transforms don't change by themselves : no animation playing, and not posed on a parent's bone.
+bool _NodeIsStatic( Node *node )
+{
+	return ! _NodeIsAnimated( node ) && node->positionRelativeToParentBoneId < 0 ;
+}
+
+// Bake the node if its whole branch is static.
+// NOTE : post-order, so its children are already baked if their own branch is static.
+NodeVisitResult _NodeBakeStaticVisit( Node *node , int order , unsigned int *state , void *userData )
+{
+	bool branchStatic = node->baked || _NodeIsStatic( node );
+
+	for( Node3D *child = node->firstChild ; child != NULL && branchStatic ; child = child->nextSibling )
+	{
+		branchStatic = child->baked ;
+	}
+
+	if ( branchStatic )
+	{
+		node->baked = true ;
+
+		(*(int*)userData)++ ;
+	}
+
+	return NODE_VISIT_CONTINUE ;
+}
+
+int NodeBakeStatic( Node *branch )
+{
+	if ( branch == NULL ) return 0 ;
+
+	// The ancestors of the branch may be dirty too :
+
+	_NodeRefreshTransforms( branch );
+	_NodeBranchUpdateTransforms( branch , false , false );
+
+	int count = 0 ;
+
+	NodeBranchVisit( branch , NODE_VISIT_PRE_ORDER , 0 , _NodeBakeVisit , &count , NULL );
+
+	return count ;
+}
 
-	while( node )
+int NodeTreeBakeStatic( Node *root )
+{
+	if ( root == NULL ) return 0 ;
+
+	NodeTreeUpdateTransforms( root );
+
+	int count = 0 ;
+
+	NodeTreeVisit( root , NODE_VISIT_POST_ORDER , 0 , _NodeBakeStaticVisit , &count , NULL );
+
+	return count ;
+}
+
+// Tell the nodes of a culled branch that they are outside the view (userData) :
+// NOTE : their distance is refreshed too, as their animation LOD depends on it.
+NodeVisitResult _NodeOutsideViewVisit( Node *node , int order , unsigned int *state , void *userData )
+{
+	NodeView *view = (NodeView*)userData ;
+	NodeViewSlot *slot = NodeViewGetSlot( view , node );
+
+	if ( slot != NULL )
 	{
-		NodeUpdateTransforms( node );
+		slot->insideFrustum = false ;
+		slot->distanceToCamera = Vector3Distance( node->transformedCenter , FrustumGetEye( view->frustum ) );
+	}
 
-		sibling = node ;
-		while( sibling = sibling->nextSibling )
+	return NODE_VISIT_CONTINUE ;
+}
+
+typedef struct _NodeDrawTraversal
+{
+	Frustum *frustum ;
+	NodeView *view ;
+	VisibleList *list ;
+	int nodeDrawn ;
+
+} _NodeDrawTraversal;
+
+// Draw the node, using its subtree boundings to cull its branch at once.
+// NOTE : the state is the planeMask, with the planes that the ancestors were not fully inside.
+// If the list is not NULL, the visible nodes are appended to it instead of being drawn.
+NodeVisitResult _NodeDrawVisit( Node *node , int order , unsigned int *planeMask , void *userData )
+{
+	_NodeDrawTraversal *draw = (_NodeDrawTraversal*)userData ;
+
+	// NOTE : the subtree box of a leaf is its own box, that _NodeDraw() will test anyway.
+
+	if ( node->subtreeBoxValid && ( node->firstChild != NULL || BoundingBoxIsEmpty( node->subtreeBox ) ) )
+	{
+		NodeViewSlot *slot = NodeViewGetSlot( draw->view , node );
+
+		FrustumCullCache *cache = slot != NULL ? &slot->subtreeCullCache : NULL ;
+		FrustumCullStats *stats = draw->view != NULL ? &draw->view->stats : &draw->frustum->stats ;
+
+		if ( BoundingBoxIsEmpty( node->subtreeBox ) || FrustumClassifyBoxCached( draw->frustum , node->subtreeBox , planeMask , cache , stats ) == FRUSTUM_OUTSIDE
+		  || ( draw->frustum->occlusion != NULL && ! OcclusionBufferTestBox( draw->frustum->occlusion , node->subtreeBox ) ) )
 		{
-			NodeTreeUpdateTransforms( sibling );
-		}
+			if ( draw->view != NULL ) NodeBranchVisit( node , NODE_VISIT_PRE_ORDER , 0 , _NodeOutsideViewVisit , draw->view , &draw->view->stack );
 
-		node = node->firstChild ;
+			return NODE_VISIT_PRUNE ;
+		}
 	}
+
+	if ( _NodeDraw( node , draw->frustum , draw->view , *planeMask , draw->list ) ) draw->nodeDrawn++ ;
+
+	return NODE_VISIT_CONTINUE ;
+}
+
+int _NodeTreeDraw( Node *root , Frustum *frustum , NodeView *view , VisibleList *list )
+{
+	_NodeDrawTraversal draw = { frustum , view , list , 0 };
+
+	// NOTE : the traversals in a view use its own stack, so views can be culled in parallel.
+
+	NodeTreeVisit( root , NODE_VISIT_PRE_ORDER , FRUSTUM_ALL_PLANES , _NodeDrawVisit , &draw , view != NULL ? &view->stack : NULL );
+
+	return draw.nodeDrawn ;
 }
 
 int NodeTreeDrawInFrustum( Node *root , Frustum *frustum )
 {
-	Node3D *sibling ;
-	Node3D *node = root ;
-	int nodeDrawn = 0 ;
+	return _NodeTreeDraw( root , frustum , NULL , NULL );
+}
 
-	while( node )
-	{
-		if ( NodeDrawInFrustum( node , frustum ) ) nodeDrawn++;
+int NodeTreeDrawInView( Node *root , NodeView *view )
+{
+	return _NodeTreeDraw( root , view->frustum , view , NULL );
+}
 
-		sibling = node ;
-		while( sibling = sibling->nextSibling )
+int NodeTreeCullInFrustum( Node *root , Frustum *frustum , VisibleList *list )
+{
+	return _NodeTreeDraw( root , frustum , NULL , list );
+}
+
+int NodeTreeCullInView( Node *root , NodeView *view , VisibleList *list )
+{
+	return _NodeTreeDraw( root , view->frustum , view , list );
+}
+
+typedef struct _NodeOccludersTraversal
+{
+	Frustum *frustum ;
+	int occluders ;
+
+} _NodeOccludersTraversal;
+
+// Rasterize the meshes of the occluder.
+// NOTE : the occluders use their own model, not their active LOD, so that the occlusion doesn't pop.
+NodeVisitResult _NodeOccludersVisit( Node *node , int order , unsigned int *state , void *userData )
+{
+	_NodeOccludersTraversal *traversal = (_NodeOccludersTraversal*)userData ;
+
+	Frustum *frustum = traversal->frustum ;
+
+	if ( node->occluder && node->model != NULL && FrustumContainsBox( frustum , node->transformedBox ) )
+	{
+		for( int i = 0 ; i < node->model->meshCount ; i++ )
 		{
-			nodeDrawn += NodeTreeDrawInFrustum( sibling , frustum );
+			OcclusionBufferRasterizeMesh( frustum->occlusion , node->model->meshes[i] , node->transform );
 		}
 
-		node = node->firstChild ;
+		traversal->occluders++ ;
 	}
 
-	return nodeDrawn;
+	return NODE_VISIT_CONTINUE ;
+}
+
+int NodeTreeRasterizeOccluders( Node *root , Frustum *frustum )
+{
+	if ( frustum->occlusion == NULL ) return 0 ;
+
+	_NodeOccludersTraversal traversal = { frustum , 0 };
+
+	NodeTreeVisit( root , NODE_VISIT_PRE_ORDER , 0 , _NodeOccludersVisit , &traversal , NULL );
+
+	return traversal.occluders ;
 }
 
 void NodeSetPosition( Node *node , Vector3 pos )
 {
-	node->transform.m12 = pos.x ;
-	node->transform.m13 = pos.y ;
-	node->transform.m14 = pos.z ;
+	node->position = pos ;
+
+	NodeSetDirty( node );
 }
 
 
@@ -958,7 +1994,11 @@ void NodeRotateZ( Node *node , float angle )
 
 void NodeRotate( Node *node , Vector3 axis , float angle )
 {
-	node->rotation = MatrixMultiply( node->rotation , MatrixRotate( axis , angle ) );
+	// NOTE : same as rotation*MatrixRotate( axis , angle ) with matrices, renormalized against the drift.
+
+	node->rotation = QuaternionNormalize( QuaternionMultiply( QuaternionFromAxisAngle( axis , angle ) , node->rotation ) );
+
+	NodeSetDirty( node );
 }
 
 void NodePitch( Node *node , float angle )
@@ -996,6 +2036,8 @@ void NodeMoveSideward( Node *node , float distance )
 	node->position.x += node->transform.m0 * distance ;
 	node->position.y += node->transform.m1 * distance ;
 	node->position.z += node->transform.m2 * distance ;
+
+	NodeSetDirty( node );
 }
 
 void NodeMoveUpward( Node *node , float distance )
@@ -1003,6 +2045,8 @@ void NodeMoveUpward( Node *node , float distance )
 	node->position.x += node->transform.m4 * distance ;
 	node->position.y += node->transform.m5 * distance ;
 	node->position.z += node->transform.m6 * distance ;
+
+	NodeSetDirty( node );
 }
 
 
@@ -1011,58 +2055,329 @@ void NodeMoveForward( Node *node , float distance )
 	node->position.x += node->transform.m8 * distance ;
 	node->position.y += node->transform.m9 * distance ;
 	node->position.z += node->transform.m10 * distance ;
+
+	NodeSetDirty( node );
 }
 
 bool NodeDrawInFrustum( Node *node , Frustum *frustum )
 {
-	node->lastFrustum = frustum ;
-	node->insideFrustum = false ;
+	return _NodeDraw( node , frustum , NULL , FRUSTUM_ALL_PLANES , NULL );
+}
+
+// Same as NodeDrawInFrustum() but only the planes of the mask are tested.
+// NOTE : FRUSTUM_NO_PLANE means the node is already known to be inside the frustum.
+bool NodeDrawInFrustumEx( Node *node , Frustum *frustum , unsigned int planeMask )
+{
+	return _NodeDraw( node , frustum , NULL , planeMask , NULL );
+}
+
+bool NodeDrawInView( Node *node , NodeView *view )
+{
+	return _NodeDraw( node , view->frustum , view , FRUSTUM_ALL_PLANES , NULL );
+}
+
+bool NodeDrawInViewEx( Node *node , NodeView *view , unsigned int planeMask )
+{
+	return _NodeDraw( node , view->frustum , view , planeMask , NULL );
+}
+
+bool NodeCullInFrustum( Node *node , Frustum *frustum , VisibleList *list )
+{
+	return _NodeDraw( node , frustum , NULL , FRUSTUM_ALL_PLANES , list );
+}
+
+bool NodeCullInFrustumEx( Node *node , Frustum *frustum , unsigned int planeMask , VisibleList *list )
+{
+	return _NodeDraw( node , frustum , NULL , planeMask , list );
+}
+
+bool NodeCullInView( Node *node , NodeView *view , VisibleList *list )
+{
+	return _NodeDraw( node , view->frustum , view , FRUSTUM_ALL_PLANES , list );
+}
+
+bool NodeCullInViewEx( Node *node , NodeView *view , unsigned int planeMask , VisibleList *list )
+{
+	return _NodeDraw( node , view->frustum , view , planeMask , list );
+}
+
+// Cull the node, then draw it, or append it to the list if any :
+bool _NodeDraw( Node *node , Frustum *frustum , NodeView *view , unsigned int planeMask , VisibleList *list )
+{
+	VisibleEntry entry ;
+
+	if ( ! _NodeCull( node , frustum , view , planeMask , &entry ) ) return false ;
+
+	if ( list != NULL )
+	{
+		*VisibleListAppend( list ) = entry ;
+	}
+	else
+	{
+		_NodeDrawEntry( &entry );
+	}
 
-	node->distanceToCamera = Vector3Distance( node->position , frustum->camera->position );
+	return true ;
+}
+
+// Select the LOD and cull the node. If visible, fill the entry and return true.
+// NOTE : if the view is NULL, or doesn't track the node, nothing is recorded and the culling caches are not used.
+bool _NodeCull( Node *node , Frustum *frustum , NodeView *view , unsigned int planeMask , VisibleEntry *entry )
+{
+	NodeViewSlot *slot = NodeViewGetSlot( view , node );
+
+	if ( slot != NULL ) slot->insideFrustum = false ;
+
+	// NOTE : node->position is relative to the parent, so measure from the world-space center,
+	// and from the eye of the frustum, as the camera may be NULL or may have moved since.
+
+	float distanceToCamera = Vector3Distance( node->transformedCenter , FrustumGetEye( frustum ) );
 
 	// Find the active LOD :
 
-	node->activeLOD = node ;
-	while( node->activeLOD->nextLOD != NULL && node->activeLOD->nextDistance < node->distanceToCamera )
+	Node3D *lod = node ;
+	while( lod->nextLOD != NULL && lod->nextDistance < distanceToCamera )
+	{
+		lod = lod->nextLOD ;
+	}
+
+	if ( slot != NULL )
+	{
+		slot->distanceToCamera = distanceToCamera ;
+		slot->activeLOD = lod ;
+	}
+
+	// Nothing to draw if the active LOD has no model :
+
+	if ( lod->model == NULL ) return false ;
+
+	// Frustum clipping using the main boundings of the node (not of the activeLOD ):
+	// NOTE : the box is tighter than the sphere, and the P/N-vertex test is as cheap.
+
+	FrustumCullCache *cache = slot != NULL ? &slot->cullCache : NULL ;
+	FrustumCullStats *stats = view != NULL ? &view->stats : &frustum->stats ;
+
+	if ( FrustumClassifyBoxCached( frustum , node->transformedBox , &planeMask , cache , stats ) == FRUSTUM_OUTSIDE ) return false ;
+
+	// Occlusion culling, if the frustum has an occlusion buffer :
+	// NOTE : the occluders are in the buffer, so they would only hide themselves.
+
+	if ( frustum->occlusion != NULL && ! node->occluder && ! OcclusionBufferTestBox( frustum->occlusion , node->transformedBox ) ) return false ;
+
+	if ( slot != NULL ) slot->insideFrustum = true ;
+
+	entry->node = node ;
+	entry->lod = lod ;
+	entry->firstMesh = 0 ;
+	entry->meshCount = lod->model->meshCount ;
+	entry->depth = distanceToCamera ;
+
+	return true ;
+}
+
+// Draw the meshes of the entry, and return how many.
+int _NodeDrawEntry( VisibleEntry *entry )
+{
+	Node3D *lod = entry->lod ;
+
+	// The meshes of a skinned model are shared, so they must hold the pose of this node :
+	// NOTE : only the main model is animated (see NodeUpdateAnimationPose()). A node without pose is drawn in the bind pose.
+
+	if ( lod == entry->node && lod->model->boneCount > 0 ) ModelSkin( lod->model , &lod->pose );
+
+	for ( int i = entry->firstMesh ; i < entry->firstMesh + entry->meshCount ; i++ )
 	{
-		node->activeLOD = node->activeLOD->nextLOD ;
+		Color color = lod->model->materials[ lod->model->meshMaterial[i] ].maps[MATERIAL_MAP_DIFFUSE].color ;
+
+		Color colorTint = WHITE;
+		colorTint.r = (unsigned char)( ( (int)color.r*(int)lod->tint.r )/255 );
+		colorTint.g = (unsigned char)( ( (int)color.g*(int)lod->tint.g )/255 );
+		colorTint.b = (unsigned char)( ( (int)color.b*(int)lod->tint.b )/255 );
+		colorTint.a = (unsigned char)( ( (int)color.a*(int)lod->tint.a )/255 );
+		
+		lod->model->materials[ lod->model->meshMaterial[i] ].maps[MATERIAL_MAP_DIFFUSE].color = colorTint ;
+
+		// Draw lod's mesh using node's transform :
+		DrawMesh( lod->model->meshes[i] , lod->model->materials[ lod->model->meshMaterial[i] ] , entry->node->transform );
+
+		lod->model->materials[ lod->model->meshMaterial[i] ].maps[MATERIAL_MAP_DIFFUSE].color = color;
 	}
 
-	// Draw the active LOD meshes if inside the frustum :
+	return entry->meshCount ;
+}
+
+//------------------------------------------------------------------------------------
+// Node views
+//------------------------------------------------------------------------------------
+
+NodeViewSlot _NodeViewSlotInit( void )
+{
+	NodeViewSlot slot ;
+
+	slot.insideFrustum = false ;
+	slot.distanceToCamera = 0.0f ;
+	slot.activeLOD = NULL ;
+	slot.cullCache = FrustumCullCacheInit();
+	slot.subtreeCullCache = FrustumCullCacheInit();
+
+	return slot ;
+}
+
+NodeView *NodeViewCreate( int slotsCount )
+{
+	NodeView *view = (NodeView*)MemAlloc( sizeof( NodeView ) );
+
+	view->frustum = NULL ;
+	view->slots = NULL ;
+	view->slotsCount = 0 ;
+	view->stats = (FrustumCullStats){ 0 };
+
+	view->animationLOD = NodeAnimationLODDefaults();
+	view->animationStats = (NodeAnimationLODStats){ 0 };
+	view->animationFrame = 0 ;
+
+	view->stack = (NodeStack){ NULL , 0 , 0 };
+
+	NodeViewResize( view , slotsCount );
+
+	return view ;
+}
+
+NodeView *NodeViewRelease( NodeView *view )
+{
+	if ( view == NULL ) return NULL ;
+
+	MemFree( view->slots );
+	MemFree( view->stack.entries );
+	MemFree( view );
+
+	return NULL ;
+}
+
+void NodeViewResize( NodeView *view , int slotsCount )
+{
+	if ( slotsCount == view->slotsCount ) return ;
+
+	view->slots = (NodeViewSlot*)MemRealloc( view->slots , sizeof( NodeViewSlot )*( slotsCount > 0 ? slotsCount : 1 ) );
+
+	for( int i = view->slotsCount ; i < slotsCount ; i++ ) view->slots[i] = _NodeViewSlotInit();
+
+	view->slotsCount = slotsCount ;
+}
+
+void NodeViewReset( NodeView *view )
+{
+	for( int i = 0 ; i < view->slotsCount ; i++ ) view->slots[i] = _NodeViewSlotInit();
+
+	view->stats = (FrustumCullStats){ 0 };
+	view->animationStats = (NodeAnimationLODStats){ 0 };
+}
 
-	Node3D *lod = node->activeLOD ;
-	if ( lod->model )
+NodeViewSlot *NodeViewGetSlot( NodeView *view , Node *node )
+{
+	if ( view == NULL || node->slot < 0 || node->slot >= view->slotsCount ) return NULL ;
+
+	return &view->slots[ node->slot ] ;
+}
+
+NodeVisitResult _NodeAssignSlotVisit( Node *node , int order , unsigned int *state , void *userData )
+{
+	node->slot = (*(int*)userData)++ ;
+
+	return NODE_VISIT_CONTINUE ;
+}
+
+int NodeTreeAssignSlots( Node *root , int firstSlot )
+{
+	NodeTreeVisit( root , NODE_VISIT_PRE_ORDER , 0 , _NodeAssignSlotVisit , &firstSlot , NULL );
+
+	return firstSlot ;
+}
+
+//------------------------------------------------------------------------------------
+// Visible lists
+//------------------------------------------------------------------------------------
+
+VisibleList *VisibleListCreate( int capacity )
+{
+	VisibleList *list = (VisibleList*)MemAlloc( sizeof( VisibleList ) );
+
+	if ( capacity < 1 ) capacity = 1 ;
+
+	list->entries = (VisibleEntry*)MemAlloc( sizeof( VisibleEntry )*capacity );
+	list->count = 0 ;
+	list->capacity = capacity ;
+
+	return list ;
+}
+
+VisibleList *VisibleListRelease( VisibleList *list )
+{
+	if ( list == NULL ) return NULL ;
+
+	MemFree( list->entries );
+	MemFree( list );
+
+	return NULL ;
+}
+
+void VisibleListClear( VisibleList *list )
+{
+	list->count = 0 ;
+}
+
+VisibleEntry *VisibleListAppend( VisibleList *list )
+{
+	if ( list->count >= list->capacity )
 	{
-		// Frustum clipping using the main boundings of the node (not of the activeLOD ):
+		list->capacity *= 2 ;
+		list->entries = (VisibleEntry*)MemRealloc( list->entries , sizeof( VisibleEntry )*list->capacity );
+	}
 
-		if ( ! FrustumContainsSphere( frustum , node->transformedCenter , node->transformedRadius ) ) return false ;
+	return &list->entries[ list->count++ ] ;
+}
 
-		// Draw the meshes of the active LOD :
+int _VisibleEntryCompareFrontToBack( const void *a , const void *b )
+{
+	float da = ((const VisibleEntry*)a)->depth ;
+	float db = ((const VisibleEntry*)b)->depth ;
 
-		for ( int i = 0 ; i < lod->model->meshCount ; i++ )
-		{
-			Color color = lod->model->materials[ lod->model->meshMaterial[i] ].maps[MATERIAL_MAP_DIFFUSE].color ;
+	return ( da > db ) - ( da < db );
+}
 
-			Color colorTint = WHITE;
-			colorTint.r = (unsigned char)( ( (int)color.r*(int)lod->tint.r )/255 );
-			colorTint.g = (unsigned char)( ( (int)color.g*(int)lod->tint.g )/255 );
-			colorTint.b = (unsigned char)( ( (int)color.b*(int)lod->tint.b )/255 );
-			colorTint.a = (unsigned char)( ( (int)color.a*(int)lod->tint.a )/255 );
-			
-			lod->model->materials[ lod->model->meshMaterial[i] ].maps[MATERIAL_MAP_DIFFUSE].color = colorTint ;
+int _VisibleEntryCompareBackToFront( const void *a , const void *b )
+{
+	return _VisibleEntryCompareFrontToBack( b , a );
+}
 
-			// Draw lod's mesh using node's transform :
-			DrawMesh( lod->model->meshes[i] , lod->model->materials[ lod->model->meshMaterial[i] ] , node->transform );
+void VisibleListSortByDepth( VisibleList *list , bool backToFront )
+{
+	qsort( list->entries , list->count , sizeof( VisibleEntry ) , backToFront ? _VisibleEntryCompareBackToFront : _VisibleEntryCompareFrontToBack );
+}
 
-			lod->model->materials[ lod->model->meshMaterial[i] ].maps[MATERIAL_MAP_DIFFUSE].color = color;
-		}
+int VisibleListDraw( VisibleList *list )
+{
+	int meshDrawn = 0 ;
 
-		node->insideFrustum = true ;
+	for( int i = 0 ; i < list->count ; i++ )
+	{
+		meshDrawn += _NodeDrawEntry( &list->entries[i] );
 	}
 
-	// Did we draw something ?
+	return meshDrawn ;
+}
+
+// NOTE : same entries as those skinned by _NodeDrawEntry().
+int VisibleListSkin( VisibleList *list , SkinBatch *batch , WorkerPool *pool )
+{
+	for( int i = 0 ; i < list->count ; i++ )
+	{
+		Node3D *lod = list->entries[i].lod ;
+
+		if ( lod == list->entries[i].node && lod->model->boneCount > 0 ) SkinBatchAdd( batch , lod->model , &lod->pose );
+	}
 
-	return node->insideFrustum ; 
+	return SkinBatchRun( batch , pool );
 }
 
 #endif //RNODES_IMPLEMENTATION
@@ -0,0 +1,492 @@
+#ifndef ROCCLUSION_H
+#define ROCCLUSION_H
+
+#include "raylib.h"
+#include "raymath.h"
+
+#include "rfrustum.h"
+
+// NOTE : the SIMD code path is the one selected by rfrustum.h (see RFRUSTUM_NO_SIMD).
+
+#ifndef OCCLUSION_MAX_LEVELS
+#define OCCLUSION_MAX_LEVELS 8 // Maximum number of levels of the Hi-Z pyramid (including the depth buffer)
+#endif
+
+
+// OcclusionBuffer
+// NOTE : low resolution software depth buffer where the occluders are rasterized on the CPU,
+// and its hierarchical (Hi-Z) pyramid used to test the boxes of the other nodes.
+// Depths are stored as 1/w (0 means infinitely far), so that they are linear in screen space,
+// and so that a cleared buffer occludes nothing.
+typedef struct OcclusionBuffer
+{
+	int width ;  // Always a multiple of 8
+	int height ;
+
+	float *depth ; // Nearest occluder of each pixel (largest 1/w)
+
+	int levels ;
+	float *hiz[ OCCLUSION_MAX_LEVELS ] ; // Farthest occluder (smallest 1/w) of each texel. hiz[0] is the depth buffer, and each level halves the previous one.
+	int levelWidth[ OCCLUSION_MAX_LEVELS ] ;
+	int levelHeight[ OCCLUSION_MAX_LEVELS ] ;
+
+	Matrix viewProj ;
+
+	Vector4 *clipVertices ; // Scratch buffer for the transformed vertices of the occluders
+	int clipVerticesSize ;
+
+	// Counters since OcclusionBufferBegin() :
+
+	int occluders ; // Meshes rasterized
+	int triangles ; // Triangles rasterized (the ones crossing the near plane are skipped)
+	int tests ;     // Boxes tested
+	int occluded ;  // Boxes found hidden
+
+} OcclusionBuffer;
+
+
+#if defined(__cplusplus)
+extern "C" {            // Prevents name mangling of functions
+#endif
+
+RLAPI OcclusionBuffer *OcclusionBufferCreate( int width , int height ); // The width is rounded up to a multiple of 8
+#define CreateOcclusionBuffer OcclusionBufferCreate
+RLAPI OcclusionBuffer *OcclusionBufferRelease( OcclusionBuffer *buffer ); // Return NULL
+#define ReleaseOcclusionBuffer OcclusionBufferRelease
+
+RLAPI void OcclusionBufferBegin( OcclusionBuffer *buffer , Frustum *frustum ); // Clear the buffer, use the view and projection of the frustum, and attach the buffer to the frustum
+RLAPI void OcclusionBufferEnd( OcclusionBuffer *buffer ); // Build the Hi-Z pyramid. Must be called after the occluders are rasterized, and before the tests.
+
+RLAPI void OcclusionBufferRasterizeTriangles( OcclusionBuffer *buffer , const float *vertices , int vertexCount , const unsigned short *indices , int triangleCount , Matrix transform ); // indices can be NULL
+RLAPI void OcclusionBufferRasterizeMesh( OcclusionBuffer *buffer , Mesh mesh , Matrix transform ); // Only use the CPU side vertices and indices of the mesh
+
+RLAPI bool OcclusionBufferTestBox( OcclusionBuffer *buffer , BoundingBox box ); // False if the box is completely hidden behind the occluders
+#define CheckOcclusionBox OcclusionBufferTestBox
+
+#if defined(__cplusplus)
+}
+#endif
+
+#endif // ROCCLUSION_H
+
+#if defined(ROCCLUSION_IMPLEMENTATION)
+
+#if defined(RFRUSTUM_SIMD_AVX2)
+	#include <immintrin.h>
+#elif defined(RFRUSTUM_SIMD_SSE)
+	#include <emmintrin.h>
+#elif defined(RFRUSTUM_SIMD_NEON)
+	#include <arm_neon.h>
+#endif
+
+void _OcclusionRasterizeTriangle( OcclusionBuffer *buffer , Vector4 v0 , Vector4 v1 , Vector4 v2 );
+bool _OcclusionTestRect( OcclusionBuffer *buffer , int l , int x0 , int y0 , int x1 , int y1 , float nearest );
+
+OcclusionBuffer *OcclusionBufferCreate( int width , int height )
+{
+	OcclusionBuffer *buffer = (OcclusionBuffer*)MemAlloc( sizeof( OcclusionBuffer ) );
+
+	if ( width < 8 ) width = 8 ;
+	if ( height < 1 ) height = 1 ;
+
+	buffer->width = ( width + 7 ) & ~7 ; // So that the SIMD rasterizer never writes outside of a row
+	buffer->height = height ;
+
+	// Size of the levels of the pyramid :
+
+	int total = 0 ;
+
+	int w = buffer->width ;
+	int h = buffer->height ;
+
+	buffer->levels = 0 ;
+
+	while( buffer->levels < OCCLUSION_MAX_LEVELS )
+	{
+		buffer->levelWidth[ buffer->levels ] = w ;
+		buffer->levelHeight[ buffer->levels ] = h ;
+		buffer->levels++ ;
+
+		total += w*h ;
+
+		if ( w == 1 && h == 1 ) break ;
+
+		w = ( w + 1 )/2 ;
+		h = ( h + 1 )/2 ;
+	}
+
+	// All the levels are stored in a single allocation :
+
+	buffer->depth = (float*)MemAlloc( sizeof( float )*total );
+
+	float *level = buffer->depth ;
+
+	for( int l = 0 ; l < buffer->levels ; l++ )
+	{
+		buffer->hiz[l] = level ;
+		level += buffer->levelWidth[l]*buffer->levelHeight[l] ;
+	}
+
+	buffer->viewProj = MatrixIdentity();
+
+	buffer->clipVertices = NULL ;
+	buffer->clipVerticesSize = 0 ;
+
+	return buffer ;
+}
+
+OcclusionBuffer *OcclusionBufferRelease( OcclusionBuffer *buffer )
+{
+	if ( buffer == NULL ) return NULL ;
+
+	MemFree( buffer->depth );
+	MemFree( buffer->clipVertices );
+	MemFree( buffer );
+
+	return NULL ;
+}
+
+void OcclusionBufferBegin( OcclusionBuffer *buffer , Frustum *frustum )
+{
+	for( int i = 0 ; i < buffer->width*buffer->height ; i++ ) buffer->depth[i] = 0.0f ;
+
+	buffer->viewProj = MatrixMultiply( frustum->view , frustum->proj );
+
+	buffer->occluders = 0 ;
+	buffer->triangles = 0 ;
+	buffer->tests = 0 ;
+	buffer->occluded = 0 ;
+
+	frustum->occlusion = buffer ;
+}
+
+void OcclusionBufferEnd( OcclusionBuffer *buffer )
+{
+	// Each texel keeps the farthest depth of the 2x2 texels below it :
+	// NOTE : odd sizes are handled by clamping, so each texel still covers all its pixels.
+
+	for( int l = 1 ; l < buffer->levels ; l++ )
+	{
+		float *src = buffer->hiz[ l-1 ];
+		float *dst = buffer->hiz[ l ];
+
+		int sw = buffer->levelWidth[ l-1 ];
+		int sh = buffer->levelHeight[ l-1 ];
+
+		for( int y = 0 ; y < buffer->levelHeight[l] ; y++ )
+		{
+			int y0 = 2*y ;
+			int y1 = 2*y + 1 < sh ? 2*y + 1 : sh - 1 ;
+
+			for( int x = 0 ; x < buffer->levelWidth[l] ; x++ )
+			{
+				int x0 = 2*x ;
+				int x1 = 2*x + 1 < sw ? 2*x + 1 : sw - 1 ;
+
+				float d = fminf( fminf( src[ y0*sw + x0 ] , src[ y0*sw + x1 ] ) , fminf( src[ y1*sw + x0 ] , src[ y1*sw + x1 ] ) );
+
+				dst[ y*buffer->levelWidth[l] + x ] = d ;
+			}
+		}
+	}
+}
+
+Vector4 _OcclusionTransform( Matrix m , float x , float y , float z )
+{
+	return (Vector4){
+		m.m0*x + m.m4*y + m.m8*z + m.m12 ,
+		m.m1*x + m.m5*y + m.m9*z + m.m13 ,
+		m.m2*x + m.m6*y + m.m10*z + m.m14 ,
+		m.m3*x + m.m7*y + m.m11*z + m.m15 };
+}
+
+void OcclusionBufferRasterizeTriangles( OcclusionBuffer *buffer , const float *vertices , int vertexCount , const unsigned short *indices , int triangleCount , Matrix transform )
+{
+	if ( vertices == NULL || vertexCount <= 0 ) return ;
+
+	if ( buffer->clipVerticesSize < vertexCount )
+	{
+		buffer->clipVertices = (Vector4*)MemRealloc( buffer->clipVertices , sizeof( Vector4 )*vertexCount );
+		buffer->clipVerticesSize = vertexCount ;
+	}
+
+	// Transform the vertices once, to clip space :
+
+	Matrix m = MatrixMultiply( transform , buffer->viewProj );
+
+	for( int i = 0 ; i < vertexCount ; i++ )
+	{
+		buffer->clipVertices[i] = _OcclusionTransform( m , vertices[ i*3 + 0 ] , vertices[ i*3 + 1 ] , vertices[ i*3 + 2 ] );
+	}
+
+	for( int t = 0 ; t < triangleCount ; t++ )
+	{
+		int i0 = indices ? indices[ t*3 + 0 ] : t*3 + 0 ;
+		int i1 = indices ? indices[ t*3 + 1 ] : t*3 + 1 ;
+		int i2 = indices ? indices[ t*3 + 2 ] : t*3 + 2 ;
+
+		if ( i0 >= vertexCount || i1 >= vertexCount || i2 >= vertexCount ) continue ;
+
+		_OcclusionRasterizeTriangle( buffer , buffer->clipVertices[ i0 ] , buffer->clipVertices[ i1 ] , buffer->clipVertices[ i2 ] );
+	}
+
+	buffer->occluders++ ;
+}
+
+void OcclusionBufferRasterizeMesh( OcclusionBuffer *buffer , Mesh mesh , Matrix transform )
+{
+	OcclusionBufferRasterizeTriangles( buffer , mesh.vertices , mesh.vertexCount , mesh.indices , mesh.triangleCount , transform );
+}
+
+// Rasterize a clip space triangle, keeping the nearest depth of each pixel whose center is inside.
+// NOTE : triangles crossing the near plane are skipped. Drawing less occluders is always safe.
+void _OcclusionRasterizeTriangle( OcclusionBuffer *buffer , Vector4 v0 , Vector4 v1 , Vector4 v2 )
+{
+	if ( v0.z < -v0.w || v1.z < -v1.w || v2.z < -v2.w ) return ;
+	if ( v0.w <= 0.0f || v1.w <= 0.0f || v2.w <= 0.0f ) return ;
+
+	// To screen space :
+
+	float iw0 = 1.0f/v0.w ;
+	float iw1 = 1.0f/v1.w ;
+	float iw2 = 1.0f/v2.w ;
+
+	float x0 = ( 0.5f + 0.5f*v0.x*iw0 )*buffer->width ;
+	float y0 = ( 0.5f - 0.5f*v0.y*iw0 )*buffer->height ;
+	float x1 = ( 0.5f + 0.5f*v1.x*iw1 )*buffer->width ;
+	float y1 = ( 0.5f - 0.5f*v1.y*iw1 )*buffer->height ;
+	float x2 = ( 0.5f + 0.5f*v2.x*iw2 )*buffer->width ;
+	float y2 = ( 0.5f - 0.5f*v2.y*iw2 )*buffer->height ;
+
+	float area = ( x1 - x0 )*( y2 - y0 ) - ( x2 - x0 )*( y1 - y0 );
+
+	if ( area == 0.0f || isnan( area ) ) return ;
+
+	// Both windings are rasterized, so make the edge functions positive inside :
+
+	if ( area < 0.0f )
+	{
+		float t ;
+		t = x1 ; x1 = x2 ; x2 = t ;
+		t = y1 ; y1 = y2 ; y2 = t ;
+		t = iw1 ; iw1 = iw2 ; iw2 = t ;
+		area = -area ;
+	}
+
+	// Bounding rectangle, clipped to the screen :
+
+	float fminX = floorf( fminf( x0 , fminf( x1 , x2 ) ) );
+	float fmaxX = ceilf( fmaxf( x0 , fmaxf( x1 , x2 ) ) );
+	float fminY = floorf( fminf( y0 , fminf( y1 , y2 ) ) );
+	float fmaxY = ceilf( fmaxf( y0 , fmaxf( y1 , y2 ) ) );
+
+	if ( fmaxX < 0.0f || fmaxY < 0.0f || fminX >= buffer->width || fminY >= buffer->height ) return ;
+
+	int minX = fminX < 0.0f ? 0 : (int)fminX ;
+	int minY = fminY < 0.0f ? 0 : (int)fminY ;
+	int maxX = fmaxX > buffer->width - 1 ? buffer->width - 1 : (int)fmaxX ;
+	int maxY = fmaxY > buffer->height - 1 ? buffer->height - 1 : (int)fmaxY ;
+
+	// Edge functions e = a*x + b*y + c , evaluated at the pixel centers :
+
+	float a0 = y1 - y2 , b0 = x2 - x1 , c0 = x1*y2 - x2*y1 ; // Edge v1 v2, weight of v0
+	float a1 = y2 - y0 , b1 = x0 - x2 , c1 = x2*y0 - x0*y2 ; // Edge v2 v0, weight of v1
+	float a2 = y0 - y1 , b2 = x1 - x0 , c2 = x0*y1 - x1*y0 ; // Edge v0 v1, weight of v2
+
+	// The depth is a linear function of the screen position too :
+
+	float invArea = 1.0f/area ;
+
+	float za = ( iw0*a0 + iw1*a1 + iw2*a2 )*invArea ;
+	float zb = ( iw0*b0 + iw1*b1 + iw2*b2 )*invArea ;
+	float zc = ( iw0*c0 + iw1*c1 + iw2*c2 )*invArea ;
+
+	buffer->triangles++ ;
+
+	for( int y = minY ; y <= maxY ; y++ )
+	{
+		float py = (float)y + 0.5f ;
+
+		float e0row = b0*py + c0 ;
+		float e1row = b1*py + c1 ;
+		float e2row = b2*py + c2 ;
+		float zrow  = zb*py + zc ;
+
+		float *row = buffer->depth + y*buffer->width ;
+
+#if defined(RFRUSTUM_SIMD_AVX2)
+
+		// 8 pixels at a time :
+		// NOTE : the width is a multiple of 8, so the aligned spans are always inside the row.
+
+		const __m256 offsets = _mm256_setr_ps( 0.5f , 1.5f , 2.5f , 3.5f , 4.5f , 5.5f , 6.5f , 7.5f );
+		const __m256 zero = _mm256_setzero_ps();
+
+		for( int x = minX & ~7 ; x <= maxX ; x += 8 )
+		{
+			__m256 px = _mm256_add_ps( _mm256_set1_ps( (float)x ) , offsets );
+
+			__m256 e0 = _mm256_add_ps( _mm256_mul_ps( _mm256_set1_ps( a0 ) , px ) , _mm256_set1_ps( e0row ) );
+			__m256 e1 = _mm256_add_ps( _mm256_mul_ps( _mm256_set1_ps( a1 ) , px ) , _mm256_set1_ps( e1row ) );
+			__m256 e2 = _mm256_add_ps( _mm256_mul_ps( _mm256_set1_ps( a2 ) , px ) , _mm256_set1_ps( e2row ) );
+
+			__m256 inside = _mm256_and_ps( _mm256_and_ps( _mm256_cmp_ps( e0 , zero , _CMP_GE_OQ ) , _mm256_cmp_ps( e1 , zero , _CMP_GE_OQ ) ) , _mm256_cmp_ps( e2 , zero , _CMP_GE_OQ ) );
+
+			if ( _mm256_movemask_ps( inside ) == 0 ) continue ;
+
+			__m256 z = _mm256_add_ps( _mm256_mul_ps( _mm256_set1_ps( za ) , px ) , _mm256_set1_ps( zrow ) );
+			__m256 old = _mm256_loadu_ps( row + x );
+
+			_mm256_storeu_ps( row + x , _mm256_blendv_ps( old , _mm256_max_ps( old , z ) , inside ) );
+		}
+
+#elif defined(RFRUSTUM_SIMD_SSE)
+
+		// 4 pixels at a time :
+
+		const __m128 offsets = _mm_setr_ps( 0.5f , 1.5f , 2.5f , 3.5f );
+		const __m128 zero = _mm_setzero_ps();
+
+		for( int x = minX & ~3 ; x <= maxX ; x += 4 )
+		{
+			__m128 px = _mm_add_ps( _mm_set1_ps( (float)x ) , offsets );
+
+			__m128 e0 = _mm_add_ps( _mm_mul_ps( _mm_set1_ps( a0 ) , px ) , _mm_set1_ps( e0row ) );
+			__m128 e1 = _mm_add_ps( _mm_mul_ps( _mm_set1_ps( a1 ) , px ) , _mm_set1_ps( e1row ) );
+			__m128 e2 = _mm_add_ps( _mm_mul_ps( _mm_set1_ps( a2 ) , px ) , _mm_set1_ps( e2row ) );
+
+			__m128 inside = _mm_and_ps( _mm_and_ps( _mm_cmpge_ps( e0 , zero ) , _mm_cmpge_ps( e1 , zero ) ) , _mm_cmpge_ps( e2 , zero ) );
+
+			if ( _mm_movemask_ps( inside ) == 0 ) continue ;
+
+			__m128 z = _mm_add_ps( _mm_mul_ps( _mm_set1_ps( za ) , px ) , _mm_set1_ps( zrow ) );
+			__m128 old = _mm_loadu_ps( row + x );
+			__m128 nearest = _mm_max_ps( old , z );
+
+			_mm_storeu_ps( row + x , _mm_or_ps( _mm_and_ps( inside , nearest ) , _mm_andnot_ps( inside , old ) ) );
+		}
+
+#elif defined(RFRUSTUM_SIMD_NEON)
+
+		// 4 pixels at a time :
+
+		const float offsetsArray[4] = { 0.5f , 1.5f , 2.5f , 3.5f };
+		const float32x4_t offsets = vld1q_f32( offsetsArray );
+		const float32x4_t zero = vdupq_n_f32( 0.0f );
+
+		for( int x = minX & ~3 ; x <= maxX ; x += 4 )
+		{
+			float32x4_t px = vaddq_f32( vdupq_n_f32( (float)x ) , offsets );
+
+			float32x4_t e0 = vmlaq_f32( vdupq_n_f32( e0row ) , vdupq_n_f32( a0 ) , px );
+			float32x4_t e1 = vmlaq_f32( vdupq_n_f32( e1row ) , vdupq_n_f32( a1 ) , px );
+			float32x4_t e2 = vmlaq_f32( vdupq_n_f32( e2row ) , vdupq_n_f32( a2 ) , px );
+
+			uint32x4_t inside = vandq_u32( vandq_u32( vcgeq_f32( e0 , zero ) , vcgeq_f32( e1 , zero ) ) , vcgeq_f32( e2 , zero ) );
+
+			float32x4_t z = vmlaq_f32( vdupq_n_f32( zrow ) , vdupq_n_f32( za ) , px );
+			float32x4_t old = vld1q_f32( row + x );
+
+			vst1q_f32( row + x , vbslq_f32( inside , vmaxq_f32( old , z ) , old ) );
+		}
+
+#else
+
+		for( int x = minX ; x <= maxX ; x++ )
+		{
+			float px = (float)x + 0.5f ;
+
+			if ( a0*px + e0row < 0.0f || a1*px + e1row < 0.0f || a2*px + e2row < 0.0f ) continue ;
+
+			float z = za*px + zrow ;
+
+			if ( z > row[x] ) row[x] = z ;
+		}
+
+#endif
+	}
+}
+
+// Test if any pixel of the rectangle [x0,x1]x[y0,y1] may be farther than the nearest depth.
+// NOTE : a texel of a coarse level also covers pixels outside of the rectangle,
+// so only the texels that fail are refined, down to the pixels.
+bool _OcclusionTestRect( OcclusionBuffer *buffer , int l , int x0 , int y0 , int x1 , int y1 , float nearest )
+{
+	float *level = buffer->hiz[l] ;
+	int levelWidth = buffer->levelWidth[l] ;
+
+	for( int y = y0 >> l ; y <= y1 >> l ; y++ )
+	{
+		for( int x = x0 >> l ; x <= x1 >> l ; x++ )
+		{
+			// Hidden there if the farthest occluder of the texel is nearer than the box :
+
+			if ( level[ y*levelWidth + x ] > nearest ) continue ;
+
+			if ( l == 0 ) return true ;
+
+			// Refine the part of the rectangle that the texel covers :
+
+			int tx0 = x << l , tx1 = ( ( x + 1 ) << l ) - 1 ;
+			int ty0 = y << l , ty1 = ( ( y + 1 ) << l ) - 1 ;
+
+			if ( _OcclusionTestRect( buffer , l - 1 , tx0 > x0 ? tx0 : x0 , ty0 > y0 ? ty0 : y0 , tx1 < x1 ? tx1 : x1 , ty1 < y1 ? ty1 : y1 , nearest ) ) return true ;
+		}
+	}
+
+	return false ;
+}
+
+// Test the screen rectangle of the box against the Hi-Z level where it covers about 2x2 texels.
+// NOTE : the test is conservative : the nearest corner of the box is compared to the farthest occluder of the rectangle.
+bool OcclusionBufferTestBox( OcclusionBuffer *buffer , BoundingBox box )
+{
+	buffer->tests++ ;
+
+	float minX = FLT_MAX , minY = FLT_MAX ;
+	float maxX = -FLT_MAX , maxY = -FLT_MAX ;
+	float nearest = 0.0f ;
+
+	for( int c = 0 ; c < 8 ; c++ )
+	{
+		Vector4 v = _OcclusionTransform( buffer->viewProj ,
+			c & 1 ? box.max.x : box.min.x ,
+			c & 2 ? box.max.y : box.min.y ,
+			c & 4 ? box.max.z : box.min.z );
+
+		// Crossing the near plane : the box may cover the whole screen.
+
+		if ( v.z < -v.w || v.w <= 0.0f ) return true ;
+
+		float iw = 1.0f/v.w ;
+
+		float x = ( 0.5f + 0.5f*v.x*iw )*buffer->width ;
+		float y = ( 0.5f - 0.5f*v.y*iw )*buffer->height ;
+
+		minX = fminf( minX , x ); maxX = fmaxf( maxX , x );
+		minY = fminf( minY , y ); maxY = fmaxf( maxY , y );
+
+		nearest = fmaxf( nearest , iw );
+	}
+
+	// Outside of the screen, it is the job of the frustum :
+
+	if ( maxX < 0.0f || maxY < 0.0f || minX >= buffer->width || minY >= buffer->height ) return true ;
+
+	int x0 = minX < 0.0f ? 0 : (int)minX ;
+	int y0 = minY < 0.0f ? 0 : (int)minY ;
+	int x1 = maxX > buffer->width - 1 ? buffer->width - 1 : (int)maxX ;
+	int y1 = maxY > buffer->height - 1 ? buffer->height - 1 : (int)maxY ;
+
+	int l = 0 ;
+
+	while( l < buffer->levels - 1 && ( ( x1 >> l ) - ( x0 >> l ) > 1 || ( y1 >> l ) - ( y0 >> l ) > 1 ) ) l++ ;
+
+	if ( _OcclusionTestRect( buffer , l , x0 , y0 , x1 , y1 , nearest ) ) return true ;
+
+	buffer->occluded++ ;
+
+	return false ;
+}
+
+#endif //ROCCLUSION_IMPLEMENTATION
@@ -7,6 +7,8 @@
 #include "rcamera.h"
 
 #include "rfrustum.h"
+#include "rtransforms.h"
+#include "rworkers.h"
 #include "rnodes.h"
 
 #ifndef SCENE3D_NAME_SIZE_MAX
@@ -18,6 +20,154 @@ typedef Model* SceneModel ;
 typedef AnimationsList* SceneAnimationsList ;
 
 
+// Spatial indexes :
+// NOTE : they tell how SceneDrawInFrustum() and the SceneQuery*() functions find the nodes.
+
+typedef enum
+{
+	SCENE_INDEX_TREE = 0 , // Walk the nodes hierarchy from the root, using the subtree boundings (default)
+	SCENE_INDEX_BVH  = 1 , // Bounding Volume Hierarchy over the world boundings of the nodes (see SceneBVH)
+	SCENE_INDEX_OCTREE = 2 , // Loose octree, for scenes where many nodes move every frame (see SceneOctree)
+
+} SceneSpatialIndex;
+
+#ifndef SCENE_BVH_BINS
+#define SCENE_BVH_BINS 12 // Number of candidate splits tested by the SAH builder
+#endif
+
+#ifndef SCENE_BVH_LEAF_SIZE
+#define SCENE_BVH_LEAF_SIZE 4 // Maximum number of nodes in a BVH leaf (unless they can't be split)
+#endif
+
+#ifndef SCENE_BVH_MAX_DEPTH
+#define SCENE_BVH_MAX_DEPTH 64 // Maximum depth of the BVH, so that it is traversed with a stack on the C stack
+#endif
+
+typedef struct SceneBVHNode
+{
+	BoundingBox box ;
+
+	int parent ; // -1 for the BVH root
+	int left ;   // -1 for the leaves
+	int right ;
+
+	int first ;  // Index of the first item of this BVH subtree in SceneBVH.items
+	int count ;  // Number of items in this BVH subtree
+
+} SceneBVHNode;
+
+typedef struct SceneBVH
+{
+	SceneBVHNode *nodes ; // NOTE : a parent is always stored before its children
+	int nodesCount ;
+
+	Node3D **items ;      // The drawable nodes of the tree, grouped by BVH subtree
+	int itemsCount ;
+
+	int *itemLeaf ;       // BVH leaf of each item
+	int *slotItem ;       // Item of each node slot (-1 if none), so that a refit finds the leaves of the moved nodes
+
+	float buildCost ;     // SAH cost right after the build
+	float cost ;          // SAH cost after the last refit
+	float areaSum ;       // Sum of the SAH terms of the BVH nodes, updated for the refitted nodes only
+	int refitsSinceBuild ;
+
+	float rebuildCostRatio ; // Rebuild when cost > buildCost*rebuildCostRatio (0 : never)
+	int rebuildPeriod ;      // Rebuild every rebuildPeriod refits (0 : never)
+
+	int builtNodeSlotsIndex ;        // Number of node slots when built, so that new nodes trigger a rebuild
+	unsigned int hierarchyVersion ;  // NodeGetHierarchyVersion() of the root when built, so that attached and detached nodes trigger a rebuild
+	bool invalid ;                   // Rebuild on next update (see SceneInvalidateSpatialIndex())
+
+} SceneBVH;
+
+#ifndef SCENE_OCTREE_MAX_DEPTH
+#define SCENE_OCTREE_MAX_DEPTH 8 // Smallest cells are 2^SCENE_OCTREE_MAX_DEPTH times smaller than the root
+#endif
+
+typedef struct SceneOctreeCell
+{
+	Vector3 center ;
+	float halfSize ;   // The cell is center +/- halfSize, but its nodes may overflow up to center +/- 2*halfSize (loose bounds)
+
+	int parent ;       // -1 for the root
+	int children[8] ;  // -1 if not created yet. Octant index bits : 1 = +x, 2 = +y, 4 = +z
+
+	int firstItem ;    // Linked list of the items stored in this cell (-1 if none)
+	int itemsCount ;
+	int subtreeItemsCount ; // Items stored in this cell and in all its descendants
+
+} SceneOctreeCell;
+
+typedef struct SceneOctree
+{
+	SceneOctreeCell *cells ; // cells[0] is the root. NOTE : cells are only freed by a rebuild.
+	int cellsCount ;
+	int cellsSize ;
+
+	Node3D **items ;    // The drawable nodes of the tree
+	int *itemCell ;     // Cell of each item
+	int *itemNext ;     // Linked list of the items of a cell
+	int *itemPrev ;
+	int itemsCount ;
+
+	int reinsertions ;  // Number of items that changed of cell during the last update
+
+	int builtNodeSlotsIndex ;        // Number of node slots when built, so that new nodes trigger a rebuild
+	unsigned int hierarchyVersion ;  // NodeGetHierarchyVersion() of the root when built, so that attached and detached nodes trigger a rebuild
+	int builtRootItemsCount ;        // Items of the root cell when built (the ones too big for its children)
+	bool invalid ;                   // Rebuild on next update (see SceneInvalidateSpatialIndex())
+
+} SceneOctree;
+
+
+// Flattened transforms :
+// NOTE : copy of the hierarchy in topological order, so that SceneUpdateTransforms() is a linear loop
+// over compact arrays instead of a walk through the Node3D pointers. Entries are in depth-first order,
+// so the descendants of an entry are the entries right after it, up to subtreeEnd.
+
+#define SCENE_TRANSFORM_CHANGED 1 // The subtree boundings of the entry must be recomputed
+#define SCENE_TRANSFORM_MOVED   2 // The entry or one of its ancestors was dirty : its world matrix changed, so its children must be recomputed too
+
+#ifndef SCENE_TRANSFORMS_GRAIN
+#define SCENE_TRANSFORMS_GRAIN 256 // Entries per range given to a worker thread (see SceneSetUpdateThreads())
+#endif
+
+typedef struct SceneTransforms
+{
+	int count ;
+	int capacity ;
+
+	int *slot ;       // Node slot of each entry
+	int *parent ;     // Entry of the parent (-1 for the root and its siblings)
+	int *subtreeEnd ; // Entry that follows the last descendant
+	int *depth ;      // Number of ancestors
+
+	Vector3 *position ; // Local TRS, copied from the nodes when they are dirty
+	Vector3 *scale ;
+	Quaternion *rotation ;
+	Matrix3x4 *local ;  // scale*rotation*translation
+	Matrix3x4 *world ;
+
+	BoundingBox *box ;        // Untransformed boundings
+	BoundingBox *worldBox ;   // Transformed boundings
+	BoundingBox *subtreeBox ; // Boundings of the entry and its descendants
+
+	unsigned char *flags ;    // SCENE_TRANSFORM_* (only during an update)
+	int *composed ;           // Entries whose local matrix is recomputed (only during an update)
+	int *moved ;              // Entries whose world matrix is recomputed, in order (only during an update)
+	int *levelOrder ;         // Moved entries sorted by depth, for the parallel update (only during an update)
+	int *levelStart ;         // First entry of each depth in levelOrder, and the end (capacity + 1 items)
+	int *changed ;            // Node slots of the entries whose boundings may have changed (only during an update)
+
+	unsigned int hierarchyVersion ; // NodeGetHierarchyVersion() of the root when built
+	Node3D *root ;                  // Root when built
+	Node3D *nodeSlots ;             // Slots when built
+	bool flat ;                     // False if the tree can't be flattened (nodes outside the slots, root with a parent) : NodeTreeUpdateTransforms() is used instead
+
+} SceneTransforms;
+
+
 typedef struct Scene3D
 {
 	char name[ SCENE3D_NAME_SIZE_MAX ];
@@ -40,6 +190,18 @@ typedef struct Scene3D
 
 	Node3D *root ;
 
+	SceneSpatialIndex spatialIndex ;
+	SceneBVH *bvh ;
+	SceneOctree *octree ;
+
+	SceneTransforms *transforms ; // Built by SceneUpdateTransforms()
+	WorkerPool *workers ;         // Parallel SceneUpdateTransforms() and SceneSkinVisible() if not NULL (see SceneSetUpdateThreads())
+	SkinBatch *skinBatch ;        // Reused by SceneSkinVisible()
+	NodeStack *stack ;            // Reused by the traversals of the tree
+
+	struct _SceneFrustaLevel *frustaLevels ; // Reused by SceneCullFrusta()
+	int frustaLevelsCapacity ;
+
 	void *userData ;
 
 } Scene3D ;
@@ -77,7 +239,57 @@ RLAPI Scene3D *SceneRelease( Scene3D *scene );
 #define ReleaseScene SceneRelease
 #define UnloadScene SceneRelease
 
+RLAPI void SceneUpdateTransforms( Scene3D *scene ); // Update the transforms of the whole tree, then the spatial index
+#define UpdateSceneTransforms SceneUpdateTransforms
+RLAPI void SceneSetUpdateThreads( Scene3D *scene , int threadCount ); // Run SceneUpdateTransforms() and SceneSkinVisible() on threadCount threads (0 : one per core, 1 : serial). The results are identical to the serial update.
+#define SetSceneUpdateThreads SceneSetUpdateThreads
+RLAPI int SceneBakeStatic( Scene3D *scene ); // Update the transforms, then freeze the branches without animation playing nor bone attachment, so that the updates and the animation timelines skip them (see NodeBakeStatic()). Return how many nodes were baked.
+#define BakeSceneStatic SceneBakeStatic
+
 RLAPI int SceneDrawInFrustum( Scene3D *scene , Frustum *frustum );
+#define DrawSceneInFrustum SceneDrawInFrustum
+RLAPI int SceneDrawInView( Scene3D *scene , NodeView *view ); // Same, and record the visibility of the nodes into the view (resized to the scene if needed)
+#define DrawSceneInView SceneDrawInView
+
+// Separate culling :
+// NOTE : the list is cleared, then filled with the visible nodes, ready for VisibleListDraw().
+// The results can be sorted, inspected or reused (audio, AI...) without drawing anything.
+
+RLAPI int SceneCull( Scene3D *scene , Frustum *frustum , VisibleList *list ); // Return how many nodes are visible
+#define CullScene SceneCull
+RLAPI int SceneCullInView( Scene3D *scene , NodeView *view , VisibleList *list ); // Same, and record the visibility of the nodes into the view
+#define CullSceneInView SceneCullInView
+RLAPI int SceneSkinVisible( Scene3D *scene , VisibleList *list ); // Skin the animated nodes of the list on the worker threads of the scene, before VisibleListDraw() (see VisibleListSkin()). Return how many poses were skinned.
+#define SkinSceneVisible SceneSkinVisible
+
+// Multi-frustum culling :
+// NOTE : masks are indexed by node slot, and bit f is set if the node is visible in frusta[f].
+
+#define SCENE_MAX_FRUSTA 32
+
+RLAPI int SceneCullFrusta( Scene3D *scene , Frustum *frusta , int frustumCount , uint32_t *outMasks ); // Cull the tree against all the frusta in a single pass, and return how many nodes are visible in at least one
+#define CullSceneFrusta SceneCullFrusta
+RLAPI int SceneDrawVisibleInFrustum( Scene3D *scene , Frustum *frustum , const uint32_t *masks , int frustumIndex ); // Draw the nodes visible in frusta[frustumIndex] without testing the planes again, and return how many were drawn
+RLAPI int SceneDrawVisibleInView( Scene3D *scene , NodeView *view , const uint32_t *masks , int frustumIndex ); // Same, and record the visibility of the nodes into the view
+
+// Spatial index :
+
+RLAPI void SceneSetSpatialIndex( Scene3D *scene , SceneSpatialIndex index ); // Select how the scene finds its visible nodes
+#define SetSceneSpatialIndex SceneSetSpatialIndex
+RLAPI void SceneInvalidateSpatialIndex( Scene3D *scene ); // Force a rebuild on the next update (attach, detach and remove are detected)
+RLAPI void SceneUpdateSpatialIndex( Scene3D *scene ); // Build, refit or rebuild the index from the current boundings (done by SceneUpdateTransforms())
+
+RLAPI int SceneQueryFrustum( Scene3D *scene , Frustum *frustum , Node3D **results , int maxResults ); // Find the drawable nodes whose box touches the frustum. Return how many, even if more than maxResults.
+RLAPI int SceneQueryBox( Scene3D *scene , BoundingBox box , Node3D **results , int maxResults ); // Same, for a box
+RLAPI int SceneQuerySphere( Scene3D *scene , Vector3 center , float radius , Node3D **results , int maxResults ); // Same, for a sphere
+
+RLAPI void SceneBuildBVH( Scene3D *scene ); // Build the BVH from scratch (SAH)
+RLAPI bool SceneRefitBVH( Scene3D *scene ); // Update the BVH boxes of the nodes that moved, and their ancestors only. Return true if any changed.
+RLAPI void SceneReleaseBVH( Scene3D *scene );
+
+RLAPI void SceneBuildOctree( Scene3D *scene ); // Build the loose octree from scratch, around the current boundings
+RLAPI int SceneRefitOctree( Scene3D *scene ); // Move the nodes whose center left their cell. Return how many moved.
+RLAPI void SceneReleaseOctree( Scene3D *scene );
 
 RLAPI Node3D *SceneGetNewNodeSlot( Scene3D *scene );
 RLAPI Model *SceneGetNewModelSlot( Scene3D *scene );
@@ -96,7 +308,7 @@ RLAPI Node3D *SceneCreateNodeAsModel( Scene3D *scene , char *name , Model *model
 #define SceneNodeAsModel SceneCreateNodeAsModel
 #define CreateSceneNodeAsModel SceneCreateNodeAsModel
 
-RLAPI Node *SceneFindNode( Scene3D *scene , char *name );
+RLAPI Node *SceneFindNode( Scene3D *scene , const char *name );
 #define FindSceneNode SceneFindNode
 
 RLAPI bool SceneSelectRootAs( Scene3D *scene , char *name );
@@ -107,6 +319,7 @@ RLAPI int SceneFindModelIndex( Scene3D *scene , Model *model );
 RLAPI int SceneFindAnimationsIndex( Scene3D *scene , AnimationsList *anims );
 
 RLAPI void SceneUpdateAnimationsTimeline( Scene3D *scene , float delta );
+RLAPI void SceneUpdateAnimationsTimelineInView( Scene3D *scene , float delta , NodeView *view ); // Same, with the animation LOD of the nodes in the view (see NodeTreeUpdateAnimationTimelineInView())
 
 #if defined(__cplusplus)
 }
@@ -127,6 +340,22 @@ RLAPI void SceneUpdateAnimationsTimeline( Scene3D *scene , float delta );
 void _SceneForceResizeAnimationsSlots( Scene3D *scene , int newSize );
 void _SceneForceResizeModelSlots( Scene3D *scene , int newSize );
 void _SceneForceResizeNodeSlots( Scene3D *scene , int newSize );
+Node3D *_SceneCheckRoot( Scene3D *scene );
+bool _SceneDecodeRotation( const char *val , Quaternion *rotation );
+void _SceneReleaseTransforms( Scene3D *scene );
+void _SceneComposeJob( void *userData , int first , int count );
+void _SceneWorldJob( void *userData , int first , int count );
+void _SceneWriteBackJob( void *userData , int first , int count );
+int _SceneSortByDepth( SceneTransforms *t , int movedCount );
+int _SceneBVHDrawInFrustum( Scene3D *scene , Frustum *frustum , NodeView *view , VisibleList *list );
+int _SceneOctreeDrawInFrustum( Scene3D *scene , Frustum *frustum , NodeView *view , VisibleList *list );
+bool _SceneBVHIsCurrent( Scene3D *scene );
+BoundingBox _SceneOctreeCellLooseBox( SceneOctreeCell *cell );
+void _SceneUpdateSpatialIndex( Scene3D *scene , const int *changed , int changedCount );
+bool _SceneRefitBVH( Scene3D *scene , const int *changed , int changedCount );
+float _SceneBVHNodeArea( SceneBVHNode *bnode );
+float _SceneBVHCostFromSum( SceneBVH *bvh );
+bool _SceneOctreeIsCurrent( Scene3D *scene );
 
 
 bool TextBeginsWith( const char *text , const char *with )
@@ -209,7 +438,7 @@ Scene3D *SceneCreate( char *name , int numberOfSlots , int numberOfNewSlotsOnRes
 	scene->modelSlotsSize = numberOfSlots ;
 	scene->modelSlotsIndex = 0 ;
 
-	scene->animationsSlots = (AnimationsList*)MemAlloc( sizeof( AnimationsList* )*numberOfSlots );
+	scene->animationsSlots = (AnimationsList*)MemAlloc( sizeof( AnimationsList )*numberOfSlots );
 	scene->animationsFileNames = (char**)MemAlloc( sizeof( char* )*numberOfSlots );
 	scene->animationsSlotsSize = numberOfSlots ;
 	scene->animationsSlotsIndex = 0 ;
@@ -218,6 +447,17 @@ Scene3D *SceneCreate( char *name , int numberOfSlots , int numberOfNewSlotsOnRes
 
 	scene->root = NULL ;
 
+	scene->spatialIndex = SCENE_INDEX_TREE ;
+	scene->bvh = NULL ;
+	scene->octree = NULL ;
+
+	scene->transforms = NULL ;
+	scene->workers = NULL ;
+	scene->skinBatch = NULL ;
+	scene->stack = NodeStackCreate( 64 );
+	scene->frustaLevels = NULL ;
+	scene->frustaLevelsCapacity = 0 ;
+
 	scene->userData = NULL ;
 
 	return scene ;
@@ -225,12 +465,26 @@ Scene3D *SceneCreate( char *name , int numberOfSlots , int numberOfNewSlotsOnRes
 
 Scene3D *SceneRelease( Scene3D *scene )
 {
+	SceneReleaseBVH( scene );
+	SceneReleaseOctree( scene );
+	_SceneReleaseTransforms( scene );
+	WorkerPoolRelease( scene->workers );
+	SkinBatchRelease( scene->skinBatch );
+	NodeStackRelease( scene->stack );
+	MemFree( scene->frustaLevels );
+
+	for( int i = 0 ; i < scene->nodeSlotsIndex ; i++ )
+	{
+		NodeUnloadPose( &scene->nodeSlots[ i ] );
+	}
+
 	MemFree( scene->nodeSlots );
 
 	for( int i = 0 ; i < scene->modelSlotsIndex ; i++ )
 	{
 		if ( scene->modelFileNames[ i ] != NULL )
 		{
+			ModelForgetSkin( &scene->modelSlots[ i ] );
 			UnloadModel( scene->modelSlots[ i ] );
 			MemFree( scene->modelFileNames[ i ] );
 		}
@@ -242,7 +496,7 @@ Scene3D *SceneRelease( Scene3D *scene )
 	{
 		if ( scene->animationsFileNames[ i ] != NULL )
 		{
-			UnloadModelAnimations( scene->animationsSlots[ i ].list , scene->animationsSlots[ i ].count );
+			AnimationsListUnload( &scene->animationsSlots[ i ] );
 			MemFree( scene->animationsFileNames[ i ] );
 		}
 	}
@@ -257,6 +511,10 @@ Scene3D *SceneRelease( Scene3D *scene )
 bool SceneSelectRootAs( Scene3D *scene , char *name )
 {
 	scene->root = SceneFindNode( scene , name );
+
+	SceneInvalidateSpatialIndex( scene );
+
+	return scene->root != NULL ;
 }
 
 void SceneSetName( Scene3D *scene , char *name )
@@ -281,7 +539,7 @@ void SceneSetName( Scene3D *scene , char *name )
 	}
 }
 
-Node *SceneFindNode( Scene3D *scene , char *name )
+Node *SceneFindNode( Scene3D *scene , const char *name )
 {
 	// TODO use hash 
 
@@ -363,6 +621,7 @@ AnimationsList *SceneGetNewAnimationsSlot( Scene3D *scene )
 	
 	anims->list = NULL ;
 	anims->count = 0 ;
+	anims->clips = NULL ;
 
 	scene->animationsFileNames[ scene->animationsSlotsIndex ] = NULL ;
 
@@ -392,7 +651,7 @@ AnimationsList *SceneLoadAnimations( Scene3D *scene , char *fileName )
 
 	if ( anims != NULL )
 	{
-		anims->list = LoadModelAnimations( fileName , &anims->count );
+		*anims = AnimationsListLoad( fileName );
 
 		scene->animationsFileNames[ scene->animationsSlotsIndex - 1 ] = (char*)MemAlloc( TextLength( fileName ) + 1 );
 		TextCopy( scene->animationsFileNames[ scene->animationsSlotsIndex - 1 ] , fileName );
@@ -413,6 +672,8 @@ Node3D *SceneCreateNodeAsGroup( Scene3D *scene , char *name )
 		}
 
 		*node = NodeAsGroup( name );
+
+		node->slot = scene->nodeSlotsIndex - 1 ;
 	}
 
 	return node ;
@@ -430,6 +691,8 @@ Node3D *SceneCreateNodeAsModel( Scene3D *scene , char *name , Model *model )
 		}
 
 		*node = NodeAsModel( name , model );
+
+		node->slot = scene->nodeSlotsIndex - 1 ;
 	}
 
 	return node ;
@@ -547,6 +810,34 @@ bool SceneLoad_getKeyVal( char *line , char **keyBuffer , char **valBuffer , int
 	return true ;
 }
 
+// Decode a rotation given either as a unit quaternion (4 floats : x y z w), or as a 3x3 rotation matrix (9 floats : m0 m1 m2 m4 m5 m6 m8 m9 m10).
+bool _SceneDecodeRotation( const char *val , Quaternion *rotation )
+{
+	float v[9] ;
+
+	int count = sscanf( val , "%f %f %f %f %f %f %f %f %f" , &v[0] , &v[1] , &v[2] , &v[3] , &v[4] , &v[5] , &v[6] , &v[7] , &v[8] );
+
+	if ( count == 4 )
+	{
+		*rotation = QuaternionNormalize( (Quaternion){ v[0] , v[1] , v[2] , v[3] } );
+		return true ;
+	}
+
+	if ( count == 9 )
+	{
+		Matrix mat = MatrixIdentity();
+
+		mat.m0 = v[0] ; mat.m1 = v[1] ; mat.m2  = v[2] ;
+		mat.m4 = v[3] ; mat.m5 = v[4] ; mat.m6  = v[5] ;
+		mat.m8 = v[6] ; mat.m9 = v[7] ; mat.m10 = v[8] ;
+
+		*rotation = QuaternionNormalize( QuaternionFromMatrix( mat ) );
+		return true ;
+	}
+
+	return false ;
+}
+
 
 Scene3D *SceneLoad( char *fileName )
 {
@@ -917,6 +1208,7 @@ Scene3D *SceneLoad( char *fileName )
 					if ( 3 == sscanf( val , "%f %f %f" , &(vec.x) , &(vec.y) , &(vec.z) ) )
 					{
 						node->position = vec ;
+						NodeSetDirty( node );
 					}
 					else
 					{
@@ -930,6 +1222,7 @@ Scene3D *SceneLoad( char *fileName )
 					if ( 3 == sscanf( val , "%f %f %f" , &(vec.x) , &(vec.y) , &(vec.z) ) )
 					{
 						node->scale = vec ;
+						NodeSetDirty( node );
 					}
 					else
 					{
@@ -937,16 +1230,17 @@ Scene3D *SceneLoad( char *fileName )
 					}
 				}
 				else
-				if ( TextIsEqual( key , "rotation" ) ) // rotation = %f %f %f %f %f %f %f %f %f
+				if ( TextIsEqual( key , "rotation" ) ) // rotation = %f %f %f %f (quaternion) or rotation = %f %f %f %f %f %f %f %f %f (3x3 matrix)
 				{
-					Matrix mat = MatrixIdentity();
-					if ( 9 == sscanf( val , "%f %f %f %f %f %f %f %f %f" , &(mat.m0) , &(mat.m1) , &(mat.m2) , &(mat.m4) , &(mat.m5) , &(mat.m6) , &(mat.m8) , &(mat.m9) , &(mat.m10) ) )
+					Quaternion q = QuaternionIdentity();
+					if ( _SceneDecodeRotation( val , &q ) )
 					{
-						node->rotation = mat ;
+						node->rotation = q ;
+						NodeSetDirty( node );
 					}
 					else
 					{
-						TRACELOG( LOG_WARNING , "SCENE: `%s`, line %d : could not decode 9 floats values separated by space." , fileName , lineCounter );
+						TRACELOG( LOG_WARNING , "SCENE: `%s`, line %d : could not decode 4 or 9 floats values separated by space." , fileName , lineCounter );
 					}
 				}
 				else
@@ -960,7 +1254,7 @@ Scene3D *SceneLoad( char *fileName )
 						 && ( b >= 0 ) && ( b <= 255 )
 						 && ( a >= 0 ) && ( a <= 255 ) )
 						{
-							node->tint = (Color){ r , g , b , a };
+							node->tint = (Color){ (unsigned char)r , (unsigned char)g , (unsigned char)b , (unsigned char)a };
 						}
 						else
 						{
@@ -1092,16 +1386,16 @@ Scene3D *SceneLoad( char *fileName )
 					}
 				}
 				else
-				if ( TextIsEqual( key , "rotation" ) ) // rotation = %f %f %f %f %f %f %f %f %f
+				if ( TextIsEqual( key , "rotation" ) ) // rotation = %f %f %f %f (quaternion) or rotation = %f %f %f %f %f %f %f %f %f (3x3 matrix)
 				{
-					Matrix mat = MatrixIdentity();
-					if ( 9 == sscanf( val , "%f %f %f %f %f %f %f %f %f" , &(mat.m0) , &(mat.m1) , &(mat.m2) , &(mat.m4) , &(mat.m5) , &(mat.m6) , &(mat.m8) , &(mat.m9) , &(mat.m10) ) )
+					Quaternion q = QuaternionIdentity();
+					if ( _SceneDecodeRotation( val , &q ) )
 					{
-						model->transform = MatrixMultiply( mat , model->transform ); // TODO FIXME
+						model->transform = MatrixMultiply( QuaternionToMatrix( q ) , model->transform ); // TODO FIXME
 					}
 					else
 					{
-						TRACELOG( LOG_WARNING , "SCENE: `%s`, line %d : could not decode 9 floats values separated by space." , fileName , lineCounter );
+						TRACELOG( LOG_WARNING , "SCENE: `%s`, line %d : could not decode 4 or 9 floats values separated by space." , fileName , lineCounter );
 					}
 				}
 				else
@@ -1230,11 +1524,8 @@ bool SceneSave( Scene3D *scene , char *fileName )
 		fprintf( fout , "position = %f %f %f\n" , node->position.x , node->position.y , node->position.z );
 		fprintf( fout , "scale = %f %f %f\n" , node->scale.x , node->scale.y , node->scale.z );
 
-		// Rotation as a 3x3 rotation matrix :
-		fprintf( fout , "rotation = %f %f %f %f %f %f %f %f %f\n" , 
-				node->rotation.m0 , node->rotation.m1 , node->rotation.m2 ,
-				node->rotation.m4 , node->rotation.m5 , node->rotation.m6 ,
-				node->rotation.m8 , node->rotation.m9 , node->rotation.m10 );
+		// Rotation as a unit quaternion (SceneLoad() also accepts a 3x3 rotation matrix) :
+		fprintf( fout , "rotation = %f %f %f %f\n" , node->rotation.x , node->rotation.y , node->rotation.z , node->rotation.w );
 
 		fprintf( fout , "anims = %d\n" , SceneFindAnimationsIndex( scene , &node->animations ) );
 		fprintf( fout , "play = %d\n" , node->currentAnimationIndex );
@@ -1279,9 +1570,10 @@ bool SceneSave( Scene3D *scene , char *fileName )
 	return true ;
 }
 
-void SceneUpdateTransforms( Scene3D *scene )
+// Return the root of the scene, selecting the node named "root" or the first node if not set yet.
+Node3D *_SceneCheckRoot( Scene3D *scene )
 {
-	if ( scene->nodeSlotsIndex == 0 ) return;
+	if ( scene->nodeSlotsIndex == 0 ) return NULL ;
 
 	if ( scene->root == NULL )
 	{
@@ -1293,41 +1585,1857 @@ void SceneUpdateTransforms( Scene3D *scene )
 		}
 	}
 
-	NodeTreeUpdateTransforms( scene->root );
+	return scene->root ;
 }
 
-int SceneDrawInFrustum( Scene3D *scene , Frustum *frustum )
+void _SceneReleaseTransforms( Scene3D *scene )
 {
-	if ( scene->nodeSlotsIndex == 0 ) return 0 ;
+	SceneTransforms *t = scene->transforms ;
+
+	if ( t == NULL ) return ;
+
+	MemFree( t->slot );
+	MemFree( t->parent );
+	MemFree( t->subtreeEnd );
+	MemFree( t->depth );
+	MemFree( t->position );
+	MemFree( t->scale );
+	MemFree( t->rotation );
+	MemFree( t->local );
+	MemFree( t->world );
+	MemFree( t->box );
+	MemFree( t->worldBox );
+	MemFree( t->subtreeBox );
+	MemFree( t->flags );
+	MemFree( t->composed );
+	MemFree( t->moved );
+	MemFree( t->levelOrder );
+	MemFree( t->levelStart );
+	MemFree( t->changed );
+	MemFree( t );
+
+	scene->transforms = NULL ;
+}
 
-	if ( scene->root == NULL )
+// Append the node to the flattened transforms (userData), in depth-first order. Stop if it is not in the slots.
+// NOTE : the state is the entry of the node plus 1 (0 for the parent of the root).
+NodeVisitResult _SceneFlattenVisit( Node3D *node , int order , unsigned int *state , void *userData )
+{
+	Scene3D *scene = (Scene3D*)userData ;
+	SceneTransforms *t = scene->transforms ;
+
+	if ( order == NODE_VISIT_POST_ORDER )
 	{
-		scene->root = SceneFindNode( scene , "root" );
+		t->subtreeEnd[ *state - 1 ] = t->count ;
+		return NODE_VISIT_CONTINUE ;
+	}
 
-		if ( scene->root == NULL ) 
-		{
-			scene->root = &( scene->nodeSlots[0] );
-		}
+	int slot = (int)( node - scene->nodeSlots );
+
+	if ( slot < 0 || slot >= scene->nodeSlotsIndex ) return NODE_VISIT_STOP ;
+
+	if ( t->count >= t->capacity ) return NODE_VISIT_STOP ; // NOTE : a node is in the tree twice
+
+	int parent = (int)*state - 1 ;
+	int i = t->count++ ;
+
+	t->slot[i] = slot ;
+	t->parent[i] = parent ;
+	t->depth[i] = parent >= 0 ? t->depth[ parent ] + 1 : 0 ;
+
+	*state = i + 1 ;
+
+	return NODE_VISIT_CONTINUE ;
+}
+
+// Rebuild the flattened transforms if the hierarchy changed since they were built.
+// NOTE : the entries of the clean nodes are copied from them, so that only the dirty ones are recomputed by the next update.
+void _SceneCheckTransforms( Scene3D *scene )
+{
+	SceneTransforms *t = scene->transforms ;
+
+	if ( t != NULL && t->hierarchyVersion == NodePeekHierarchyVersion( scene->root ) && t->root == scene->root && t->nodeSlots == scene->nodeSlots && t->capacity >= scene->nodeSlotsIndex ) return ;
+
+	if ( t == NULL )
+	{
+		t = (SceneTransforms*)MemAlloc( sizeof( SceneTransforms ) );
+		*t = (SceneTransforms){ 0 };
+		scene->transforms = t ;
 	}
 
-	return NodeTreeDrawInFrustum( scene->root , frustum );
+	if ( t->capacity < scene->nodeSlotsIndex )
+	{
+		int capacity = scene->nodeSlotsSize > scene->nodeSlotsIndex ? scene->nodeSlotsSize : scene->nodeSlotsIndex ;
+
+		t->slot = (int*)MemRealloc( t->slot , sizeof( int )*capacity );
+		t->parent = (int*)MemRealloc( t->parent , sizeof( int )*capacity );
+		t->subtreeEnd = (int*)MemRealloc( t->subtreeEnd , sizeof( int )*capacity );
+		t->depth = (int*)MemRealloc( t->depth , sizeof( int )*capacity );
+		t->position = (Vector3*)MemRealloc( t->position , sizeof( Vector3 )*capacity );
+		t->scale = (Vector3*)MemRealloc( t->scale , sizeof( Vector3 )*capacity );
+		t->rotation = (Quaternion*)MemRealloc( t->rotation , sizeof( Quaternion )*capacity );
+		t->local = (Matrix3x4*)MemRealloc( t->local , sizeof( Matrix3x4 )*capacity );
+		t->world = (Matrix3x4*)MemRealloc( t->world , sizeof( Matrix3x4 )*capacity );
+		t->box = (BoundingBox*)MemRealloc( t->box , sizeof( BoundingBox )*capacity );
+		t->worldBox = (BoundingBox*)MemRealloc( t->worldBox , sizeof( BoundingBox )*capacity );
+		t->subtreeBox = (BoundingBox*)MemRealloc( t->subtreeBox , sizeof( BoundingBox )*capacity );
+		t->flags = (unsigned char*)MemRealloc( t->flags , capacity );
+		t->composed = (int*)MemRealloc( t->composed , sizeof( int )*capacity );
+		t->moved = (int*)MemRealloc( t->moved , sizeof( int )*capacity );
+		t->levelOrder = (int*)MemRealloc( t->levelOrder , sizeof( int )*capacity );
+		t->levelStart = (int*)MemRealloc( t->levelStart , sizeof( int )*( capacity + 1 ) );
+		t->changed = (int*)MemRealloc( t->changed , sizeof( int )*capacity );
+
+		t->capacity = capacity ;
+	}
+
+	t->count = 0 ;
+	t->flat = scene->root->parent == NULL && NodeTreeVisit( scene->root , NODE_VISIT_PRE_ORDER | NODE_VISIT_POST_ORDER , 0 , _SceneFlattenVisit , scene , scene->stack ) != NODE_VISIT_STOP ;
+
+	for( int i = 0 ; i < t->count ; i++ )
+	{
+		Node3D *node = &scene->nodeSlots[ t->slot[i] ] ;
+
+		t->flags[i] = 0 ;
+
+		if ( node->localDirty || node->worldDirty ) continue ;
+
+		t->local[i] = node->localTransform ;
+		t->world[i] = Matrix3x4FromMatrix( node->transform );
+		t->box[i] = node->untransformedBox ;
+		t->worldBox[i] = node->transformedBox ;
+		t->subtreeBox[i] = node->subtreeBox ;
+	}
+
+	t->hierarchyVersion = NodeGetHierarchyVersion( scene->root );
+	t->root = scene->root ;
+	t->nodeSlots = scene->nodeSlots ;
 }
 
-void SceneUpdateAnimationsTimeline( Scene3D *scene , float delta )
+// Ranges of entries processed by the worker threads :
+
+typedef struct _SceneTransformsJob
 {
-	if ( scene->nodeSlotsIndex == 0 ) return ;
+	Scene3D *scene ;
+	SceneTransforms *t ;
+	const int *list ; // Entries to process
 
-	if ( scene->root == NULL )
+} _SceneTransformsJob;
+
+void _SceneComposeJob( void *userData , int first , int count )
+{
+	_SceneTransformsJob *job = (_SceneTransformsJob*)userData ;
+	SceneTransforms *t = job->t ;
+
+	TransformComposeBatch( t->position , t->scale , t->rotation , t->local , job->list + first , count );
+}
+
+void _SceneWorldJob( void *userData , int first , int count )
+{
+	_SceneTransformsJob *job = (_SceneTransformsJob*)userData ;
+	SceneTransforms *t = job->t ;
+
+	TransformComposeWorldBatch( t->local , t->parent , t->world , t->box , t->worldBox , job->list + first , count );
+}
+
+void _SceneWriteBackJob( void *userData , int first , int count )
+{
+	_SceneTransformsJob *job = (_SceneTransformsJob*)userData ;
+	SceneTransforms *t = job->t ;
+
+	for( int m = first ; m < first + count ; m++ )
 	{
-		scene->root = SceneFindNode( scene , "root" );
+		int i = job->list[m] ;
 
-		if ( scene->root == NULL ) 
+		Node3D *node = &job->scene->nodeSlots[ t->slot[i] ] ;
+
+		node->localTransform = t->local[i] ;
+		node->transform = Matrix3x4ToMatrix( t->world[i] );
+		node->inverseTransformValid = false ;
+		node->transformedBox = t->worldBox[i] ;
+
+		node->transformedCenter.x = ( node->transformedBox.min.x + node->transformedBox.max.x )*0.5f ;
+		node->transformedCenter.y = ( node->transformedBox.min.y + node->transformedBox.max.y )*0.5f ;
+		node->transformedCenter.z = ( node->transformedBox.min.z + node->transformedBox.max.z )*0.5f ;
+
+		node->transformedRadius = Vector3Distance( node->transformedBox.min , node->transformedBox.max )*0.5f ;
+
+		node->localDirty = false ;
+		node->worldDirty = false ;
+
+		// An ancestor moved, so the branch is not static anymore :
+		node->baked = false ;
+
+		t->subtreeBox[i] = NodeIsDrawable( node ) ? t->worldBox[i] : BoundingBoxEmpty();
+	}
+}
+
+// Sort the moved entries by depth into levelOrder (counting sort), and return the number of depths.
+int _SceneSortByDepth( SceneTransforms *t , int movedCount )
+{
+	int levels = 0 ;
+
+	for( int m = 0 ; m < movedCount ; m++ )
+	{
+		int d = t->depth[ t->moved[m] ] ;
+
+		if ( d + 1 > levels ) levels = d + 1 ;
+	}
+
+	for( int d = 0 ; d <= levels ; d++ ) t->levelStart[d] = 0 ;
+
+	for( int m = 0 ; m < movedCount ; m++ ) t->levelStart[ t->depth[ t->moved[m] ] + 1 ]++ ;
+
+	for( int d = 0 ; d < levels ; d++ ) t->levelStart[ d + 1 ] += t->levelStart[d] ;
+
+	// NOTE : placing the entries moves each levelStart[d] to the start of the next depth, hence the shift afterwards.
+
+	for( int m = 0 ; m < movedCount ; m++ )
+	{
+		int i = t->moved[m] ;
+
+		t->levelOrder[ t->levelStart[ t->depth[i] ]++ ] = i ;
+	}
+
+	for( int d = levels ; d > 0 ; d-- ) t->levelStart[d] = t->levelStart[ d - 1 ] ;
+
+	t->levelStart[0] = 0 ;
+
+	return levels ;
+}
+
+// Same as NodeTreeUpdateTransforms(), using the flattened transforms :
+// 1) a forward loop lists the entries that are dirty or whose parent moved, and skips the clean branches,
+// 2) the batch kernels of rtransforms.h recompute the listed local and world matrices, and their boundings,
+//    on the worker threads if any (see SceneSetUpdateThreads()),
+// 3) a backward loop merges the subtree boundings of the changed entries into their parents.
+// NOTE : the results are the same as NodeTreeUpdateTransforms(), and are written back into the nodes that changed only.
+// The loops work on the flat arrays : a node is only read for its dirty flags, and for its new TRS when it moved.
+// Return how many node slots were listed in t->changed, for the refit of the spatial index.
+int _SceneUpdateFlatTransforms( Scene3D *scene )
+{
+	SceneTransforms *t = scene->transforms ;
+
+	int composedCount = 0 ;
+	int movedCount = 0 ;
+
+	for( int i = 0 ; i < t->count ; )
+	{
+		int p = t->parent[i] ;
+
+		Node3D *node = &scene->nodeSlots[ t->slot[i] ] ;
+
+		bool moved = ( p >= 0 && ( t->flags[p] & SCENE_TRANSFORM_MOVED ) ) || node->localDirty || node->worldDirty ;
+
+		// Nothing changed in the branch :
+		// NOTE : its subtree boundings are the ones of the node, in case it was updated alone by NodeTreeUpdateTransforms().
+
+		if ( ! moved && node->subtreeBoxValid )
 		{
-			scene->root = &( scene->nodeSlots[0] );
+			t->subtreeBox[i] = node->subtreeBox ;
+			i = t->subtreeEnd[i] ;
+			continue ;
+		}
+
+		unsigned char flags = SCENE_TRANSFORM_CHANGED ;
+
+		if ( moved )
+		{
+			NodeUpdateAnimationPose( node );
+
+			if ( node->localDirty )
+			{
+				t->position[i] = node->position ;
+				t->scale[i] = node->scale ;
+				t->rotation[i] = node->rotation ;
+
+				t->composed[ composedCount++ ] = i ;
+			}
+			else
+			{
+				t->local[i] = node->localTransform ;
+			}
+
+			t->box[i] = node->untransformedBox ;
+			t->moved[ movedCount++ ] = i ;
+
+			flags |= SCENE_TRANSFORM_MOVED ;
+		}
+		else
+		{
+			// NOTE : the node may have been updated alone by NodeUpdateTransforms().
+
+			t->local[i] = node->localTransform ;
+			t->world[i] = Matrix3x4FromMatrix( node->transform );
+			t->worldBox[i] = node->transformedBox ;
+
+			t->subtreeBox[i] = NodeIsDrawable( node ) ? t->worldBox[i] : BoundingBoxEmpty();
 		}
+
+		t->flags[i] = flags ;
+
+		i++ ;
 	}
 
-	NodeTreeUpdateAnimationTimeline( scene->root , delta );
+	// NOTE : the moved entries are listed in order, so the world matrix of a parent is computed before its children.
+	// With several threads, they are computed by depth instead : the entries of a same depth are independent.
+
+	_SceneTransformsJob job = { scene , t , t->composed };
+
+	WorkerPoolRun( scene->workers , composedCount , SCENE_TRANSFORMS_GRAIN , _SceneComposeJob , &job );
+
+	if ( WorkerPoolGetThreadCount( scene->workers ) > 1 )
+	{
+		int levels = _SceneSortByDepth( t , movedCount );
+
+		for( int d = 0 ; d < levels ; d++ )
+		{
+			job.list = t->levelOrder + t->levelStart[d] ;
+
+			// NOTE : a small level (a deep chain) runs on the calling thread.
+			WorkerPoolRun( scene->workers , t->levelStart[ d + 1 ] - t->levelStart[d] , SCENE_TRANSFORMS_GRAIN , _SceneWorldJob , &job );
+		}
+	}
+	else
+	{
+		TransformComposeWorldBatch( t->local , t->parent , t->world , t->box , t->worldBox , t->moved , movedCount );
+	}
+
+	// Write back :
+
+	job.list = t->moved ;
+
+	WorkerPoolRun( scene->workers , movedCount , SCENE_TRANSFORMS_GRAIN , _SceneWriteBackJob , &job );
+
+	// The descendants are after their ancestors, so a backward loop completes the children before their parent :
+	// NOTE : a changed entry has all its ancestors changed too.
+
+	int changedCount = 0 ;
+
+	for( int i = t->count - 1 ; i >= 0 ; i-- )
+	{
+		int p = t->parent[i] ;
+
+		if ( p >= 0 && ( t->flags[p] & SCENE_TRANSFORM_CHANGED ) )
+		{
+			t->subtreeBox[p] = BoundingBoxMerge( t->subtreeBox[p] , t->subtreeBox[i] );
+		}
+
+		if ( t->flags[i] & SCENE_TRANSFORM_CHANGED )
+		{
+			Node3D *node = &scene->nodeSlots[ t->slot[i] ] ;
+
+			node->subtreeBox = t->subtreeBox[i] ;
+			node->subtreeBoxValid = true ;
+
+			t->changed[ changedCount++ ] = t->slot[i] ;
+		}
+
+		t->flags[i] = 0 ;
+	}
+
+	return changedCount ;
+}
+
+void SceneUpdateTransforms( Scene3D *scene )
+{
+	if ( _SceneCheckRoot( scene ) == NULL ) return;
+
+	_SceneCheckTransforms( scene );
+
+	if ( scene->transforms->flat )
+	{
+		int changedCount = _SceneUpdateFlatTransforms( scene );
+
+		_SceneUpdateSpatialIndex( scene , scene->transforms->changed , changedCount );
+	}
+	else
+	{
+		NodeTreeUpdateTransforms( scene->root );
+
+		_SceneUpdateSpatialIndex( scene , NULL , 0 );
+	}
+}
+
+void SceneSetUpdateThreads( Scene3D *scene , int threadCount )
+{
+	scene->workers = WorkerPoolRelease( scene->workers );
+
+	if ( threadCount != 1 ) scene->workers = WorkerPoolCreate( threadCount );
+}
+
+// NOTE : the nodes are un-baked automatically when they, or one of their ancestors, change.
+int SceneBakeStatic( Scene3D *scene )
+{
+	if ( _SceneCheckRoot( scene ) == NULL ) return 0 ;
+
+	SceneUpdateTransforms( scene );
+
+	return NodeTreeBakeStatic( scene->root );
+}
+
+// Draw a node in the view if any, else only in the frustum.
+// NOTE : if the list is not NULL, the node is appended to it instead of being drawn.
+bool _SceneDrawNode( Node3D *node , Frustum *frustum , NodeView *view , unsigned int planeMask , VisibleList *list )
+{
+	if ( list != NULL )
+	{
+		if ( view != NULL ) return NodeCullInViewEx( node , view , planeMask , list );
+
+		return NodeCullInFrustumEx( node , frustum , planeMask , list );
+	}
+
+	if ( view != NULL ) return NodeDrawInViewEx( node , view , planeMask );
+
+	return NodeDrawInFrustumEx( node , frustum , planeMask );
+}
+
+// NOTE : the distance is refreshed too, as the animation LOD of the node depends on it.
+void _SceneSetOutsideView( Node3D *node , NodeView *view )
+{
+	NodeViewSlot *slot = NodeViewGetSlot( view , node );
+
+	if ( slot != NULL )
+	{
+		slot->insideFrustum = false ;
+		slot->distanceToCamera = Vector3Distance( node->transformedCenter , FrustumGetEye( view->frustum ) );
+	}
+}
+
+int _SceneDraw( Scene3D *scene , Frustum *frustum , NodeView *view , VisibleList *list )
+{
+	if ( _SceneCheckRoot( scene ) == NULL ) return 0 ;
+
+	// NOTE : the index is only built by SceneUpdateSpatialIndex(), so that culling never modifies the scene
+	// and several views can be culled at once. Until then, or if the tree changed since, the tree is walked.
+
+	if ( _SceneBVHIsCurrent( scene ) ) return _SceneBVHDrawInFrustum( scene , frustum , view , list );
+	if ( _SceneOctreeIsCurrent( scene ) ) return _SceneOctreeDrawInFrustum( scene , frustum , view , list );
+
+	if ( list != NULL && view != NULL ) return NodeTreeCullInView( scene->root , view , list );
+	if ( list != NULL ) return NodeTreeCullInFrustum( scene->root , frustum , list );
+	if ( view != NULL ) return NodeTreeDrawInView( scene->root , view );
+	return NodeTreeDrawInFrustum( scene->root , frustum );
+}
+
+int SceneDrawInFrustum( Scene3D *scene , Frustum *frustum )
+{
+	return _SceneDraw( scene , frustum , NULL , NULL );
+}
+
+int SceneDrawInView( Scene3D *scene , NodeView *view )
+{
+	if ( view->slotsCount < scene->nodeSlotsIndex ) NodeViewResize( view , scene->nodeSlotsSize );
+
+	return _SceneDraw( scene , view->frustum , view , NULL );
+}
+
+int SceneCull( Scene3D *scene , Frustum *frustum , VisibleList *list )
+{
+	VisibleListClear( list );
+
+	return _SceneDraw( scene , frustum , NULL , list );
+}
+
+int SceneCullInView( Scene3D *scene , NodeView *view , VisibleList *list )
+{
+	if ( view->slotsCount < scene->nodeSlotsIndex ) NodeViewResize( view , scene->nodeSlotsSize );
+
+	VisibleListClear( list );
+
+	return _SceneDraw( scene , view->frustum , view , list );
+}
+
+int SceneSkinVisible( Scene3D *scene , VisibleList *list )
+{
+	if ( scene->skinBatch == NULL ) scene->skinBatch = SkinBatchCreate();
+
+	return VisibleListSkin( list , scene->skinBatch , scene->workers );
+}
+
+// Frusta touched by the ancestors of a node, and their planes that are still crossed :
+
+typedef struct _SceneFrustaLevel
+{
+	uint32_t active ;
+	unsigned int planeMasks[ SCENE_MAX_FRUSTA ];
+	int index ; // BVH node or octree cell, when the spatial index is traversed
+
+} _SceneFrustaLevel;
+
+typedef struct _SceneFrustaTraversal
+{
+	Scene3D *scene ;
+	Frustum *frusta ;
+	int frustumCount ;
+	uint32_t *outMasks ;
+
+	_SceneFrustaLevel *levels ; // levels[d] is inherited by the nodes at depth d (levels[0] : all the frusta). With an index, the stack of its traversal.
+	int levelsCapacity ;        // NOTE : the buffer is kept by the scene between the calls
+
+	int visibleCount ;
+
+} _SceneFrustaTraversal;
+
+// Remove the frusta the box is outside of, or occluded in, from the active ones, and narrow the planes to test in the others.
+uint32_t _SceneFrustaTestBox( _SceneFrustaTraversal *cull , uint32_t active , unsigned int *planeMasks , BoundingBox box )
+{
+	Frustum *frusta = cull->frusta ;
+
+	for( int f = 0 ; f < cull->frustumCount ; f++ )
+	{
+		if ( ( active & ( 1u << f ) ) == 0 ) continue ;
+
+		if ( FrustumClassifyBoxMasked( &frusta[f] , box , &planeMasks[f] ) == FRUSTUM_OUTSIDE
+		  || ( frusta[f].occlusion != NULL && ! OcclusionBufferTestBox( frusta[f].occlusion , box ) ) )
+		{
+			active &= ~( 1u << f );
+		}
+	}
+
+	return active ;
+}
+
+// Write the mask of the frusta, among the active ones, the node is visible in.
+void _SceneFrustaTestNode( _SceneFrustaTraversal *cull , uint32_t active , const unsigned int *planeMasks , Node3D *node )
+{
+	Frustum *frusta = cull->frusta ;
+
+	uint32_t visible = 0 ;
+
+	for( int f = 0 ; f < cull->frustumCount && active != 0 ; f++ )
+	{
+		if ( ( active & ( 1u << f ) ) == 0 ) continue ;
+
+		unsigned int mask = planeMasks[f] ;
+
+		if ( FrustumClassifyBoxMasked( &frusta[f] , node->transformedBox , &mask ) == FRUSTUM_OUTSIDE ) continue ;
+		if ( frusta[f].occlusion != NULL && ! node->occluder && ! OcclusionBufferTestBox( frusta[f].occlusion , node->transformedBox ) ) continue ;
+
+		visible |= 1u << f ;
+	}
+
+	int slot = (int)( node - cull->scene->nodeSlots );
+
+	if ( slot >= 0 && slot < cull->scene->nodeSlotsIndex ) cull->outMasks[ slot ] = visible ;
+
+	if ( visible != 0 ) cull->visibleCount++ ;
+}
+
+// Cull the node against several frusta at once, so its boundings are loaded only once.
+// NOTE : the state is the depth of the node plus 1, so the node reads the level of its parent and writes the level of its children.
+NodeVisitResult _SceneCullFrustaVisit( Node3D *node , int order , unsigned int *state , void *userData )
+{
+	_SceneFrustaTraversal *cull = (_SceneFrustaTraversal*)userData ;
+
+	int frustumCount = cull->frustumCount ;
+
+	int depth = (int)*state ;
+
+	if ( depth + 1 >= cull->levelsCapacity )
+	{
+		cull->levelsCapacity *= 2 ;
+		cull->levels = (_SceneFrustaLevel*)MemRealloc( cull->levels , sizeof( _SceneFrustaLevel )*cull->levelsCapacity );
+	}
+
+	uint32_t active = cull->levels[ depth ].active ;
+	unsigned int *masks = cull->levels[ depth + 1 ].planeMasks ;
+
+	for( int f = 0 ; f < frustumCount ; f++ ) masks[f] = cull->levels[ depth ].planeMasks[f] ;
+
+	// Subtree test :
+	// NOTE : as in NodeTreeDrawInFrustum(), leaves are only tested once, with their own box.
+
+	if ( node->subtreeBoxValid && ( node->firstChild != NULL || BoundingBoxIsEmpty( node->subtreeBox ) ) )
+	{
+		active = BoundingBoxIsEmpty( node->subtreeBox ) ? 0 : _SceneFrustaTestBox( cull , active , masks , node->subtreeBox );
+	}
+
+	cull->levels[ depth + 1 ].active = active ;
+
+	// Node test :
+
+	_SceneFrustaTestNode( cull , NodeIsDrawable( node ) ? active : 0 , masks , node );
+
+	*state = depth + 1 ;
+
+	return NODE_VISIT_CONTINUE ;
+}
+
+// Push a copy of a level on the stack of an index traversal, for the BVH node or octree cell.
+void _SceneFrustaPush( _SceneFrustaTraversal *cull , int *top , _SceneFrustaLevel *level , int index )
+{
+	if ( *top >= cull->levelsCapacity )
+	{
+		cull->levelsCapacity *= 2 ;
+		cull->levels = (_SceneFrustaLevel*)MemRealloc( cull->levels , sizeof( _SceneFrustaLevel )*cull->levelsCapacity );
+	}
+
+	_SceneFrustaLevel *pushed = &cull->levels[ (*top)++ ] ;
+
+	pushed->active = level->active ;
+	for( int f = 0 ; f < cull->frustumCount ; f++ ) pushed->planeMasks[f] = level->planeMasks[f] ;
+	pushed->index = index ;
+}
+
+// Same as _SceneCullFrustaVisit(), with the BVH :
+// NOTE : the stack holds the levels, so that each BVH node has the frusta and planes left by its parent.
+void _SceneBVHCullFrusta( _SceneFrustaTraversal *cull , SceneBVH *bvh )
+{
+	if ( bvh->nodesCount == 0 ) return ;
+
+	int top = 1 ;
+	cull->levels[0].index = 0 ;
+
+	while( top > 0 )
+	{
+		_SceneFrustaLevel level = cull->levels[ --top ] ;
+
+		SceneBVHNode *bnode = &bvh->nodes[ level.index ] ;
+
+		level.active = _SceneFrustaTestBox( cull , level.active , level.planeMasks , bnode->box );
+
+		if ( level.active == 0 ) continue ;
+
+		if ( bnode->left < 0 )
+		{
+			for( int i = bnode->first ; i < bnode->first + bnode->count ; i++ )
+			{
+				_SceneFrustaTestNode( cull , level.active , level.planeMasks , bvh->items[i] );
+			}
+		}
+		else
+		{
+			_SceneFrustaPush( cull , &top , &level , bnode->right );
+			_SceneFrustaPush( cull , &top , &level , bnode->left );
+		}
+	}
+}
+
+// Same, with the octree :
+void _SceneOctreeCullFrusta( _SceneFrustaTraversal *cull , SceneOctree *octree )
+{
+	if ( octree->cellsCount == 0 ) return ;
+
+	int top = 1 ;
+	cull->levels[0].index = 0 ;
+
+	while( top > 0 )
+	{
+		_SceneFrustaLevel level = cull->levels[ --top ] ;
+
+		SceneOctreeCell *cell = &octree->cells[ level.index ] ;
+
+		if ( cell->subtreeItemsCount == 0 ) continue ;
+
+		// NOTE : the root also keeps the nodes that are outside of it, so it is never culled.
+
+		if ( level.index != 0 ) level.active = _SceneFrustaTestBox( cull , level.active , level.planeMasks , _SceneOctreeCellLooseBox( cell ) );
+
+		if ( level.active == 0 ) continue ;
+
+		for( int i = cell->firstItem ; i >= 0 ; i = octree->itemNext[i] )
+		{
+			_SceneFrustaTestNode( cull , level.active , level.planeMasks , octree->items[i] );
+		}
+
+		for( int o = 0 ; o < 8 ; o++ )
+		{
+			if ( cell->children[o] >= 0 ) _SceneFrustaPush( cull , &top , &level , cell->children[o] );
+		}
+	}
+}
+
+int SceneCullFrusta( Scene3D *scene , Frustum *frusta , int frustumCount , uint32_t *outMasks )
+{
+	if ( frustumCount > SCENE_MAX_FRUSTA )
+	{
+		TRACELOG( LOG_WARNING , "SCENE: [%s,%s,%i] Too many frusta (%i). Only the first %i will be culled." , __func__ , __FILE__ , __LINE__ , frustumCount , SCENE_MAX_FRUSTA );
+
+		frustumCount = SCENE_MAX_FRUSTA ;
+	}
+
+	// Nodes that are not in the tree are not visible :
+
+	for( int i = 0 ; i < scene->nodeSlotsIndex ; i++ ) outMasks[i] = 0 ;
+
+	if ( _SceneCheckRoot( scene ) == NULL || frustumCount <= 0 ) return 0 ;
+
+	if ( scene->frustaLevels == NULL )
+	{
+		scene->frustaLevelsCapacity = 64 ;
+		scene->frustaLevels = (_SceneFrustaLevel*)MemAlloc( sizeof( _SceneFrustaLevel )*scene->frustaLevelsCapacity );
+	}
+
+	_SceneFrustaTraversal cull = { scene , frusta , frustumCount , outMasks , scene->frustaLevels , scene->frustaLevelsCapacity , 0 };
+
+	cull.levels[0].active = frustumCount == 32 ? 0xFFFFFFFFu : ( 1u << frustumCount ) - 1u ;
+
+	for( int f = 0 ; f < frustumCount ; f++ ) cull.levels[0].planeMasks[f] = FRUSTUM_ALL_PLANES ;
+
+	// NOTE : as for SceneDrawInFrustum(), the index is used if it is up to date, and the tree is walked otherwise.
+
+	if ( _SceneBVHIsCurrent( scene ) )
+	{
+		_SceneBVHCullFrusta( &cull , scene->bvh );
+	}
+	else
+	if ( _SceneOctreeIsCurrent( scene ) )
+	{
+		_SceneOctreeCullFrusta( &cull , scene->octree );
+	}
+	else
+	{
+		NodeTreeVisit( scene->root , NODE_VISIT_PRE_ORDER , 0 , _SceneCullFrustaVisit , &cull , scene->stack );
+	}
+
+	// The buffer may have grown :
+
+	scene->frustaLevels = cull.levels ;
+	scene->frustaLevelsCapacity = cull.levelsCapacity ;
+
+	return cull.visibleCount ;
+}
+
+int _SceneDrawVisible( Scene3D *scene , Frustum *frustum , NodeView *view , const uint32_t *masks , int frustumIndex )
+{
+	if ( frustumIndex < 0 || frustumIndex >= SCENE_MAX_FRUSTA )
+	{
+		TRACELOG( LOG_WARNING , "SCENE: [%s,%s,%i] Invalid frustum index (%i)." , __func__ , __FILE__ , __LINE__ , frustumIndex );
+
+		return 0 ;
+	}
+
+	int nodeDrawn = 0 ;
+
+	for( int i = 0 ; i < scene->nodeSlotsIndex ; i++ )
+	{
+		Node3D *node = &scene->nodeSlots[i] ;
+
+		if ( masks[i] & ( 1u << frustumIndex ) )
+		{
+			if ( _SceneDrawNode( node , frustum , view , FRUSTUM_NO_PLANE , NULL ) ) nodeDrawn++ ;
+		}
+		else
+		{
+			_SceneSetOutsideView( node , view );
+		}
+	}
+
+	return nodeDrawn ;
+}
+
+int SceneDrawVisibleInFrustum( Scene3D *scene , Frustum *frustum , const uint32_t *masks , int frustumIndex )
+{
+	return _SceneDrawVisible( scene , frustum , NULL , masks , frustumIndex );
+}
+
+int SceneDrawVisibleInView( Scene3D *scene , NodeView *view , const uint32_t *masks , int frustumIndex )
+{
+	if ( view->slotsCount < scene->nodeSlotsIndex ) NodeViewResize( view , scene->nodeSlotsSize );
+
+	return _SceneDrawVisible( scene , view->frustum , view , masks , frustumIndex );
+}
+
+void SceneUpdateAnimationsTimeline( Scene3D *scene , float delta )
+{
+	if ( _SceneCheckRoot( scene ) == NULL ) return ;
+
+	NodeTreeUpdateAnimationTimeline( scene->root , delta );
+}
+
+void SceneUpdateAnimationsTimelineInView( Scene3D *scene , float delta , NodeView *view )
+{
+	if ( _SceneCheckRoot( scene ) == NULL ) return ;
+
+	if ( view != NULL && view->slotsCount < scene->nodeSlotsIndex ) NodeViewResize( view , scene->nodeSlotsSize );
+
+	NodeTreeUpdateAnimationTimelineInView( scene->root , delta , view );
+}
+
+//------------------------------------------------------------------------------------
+// Spatial index
+//------------------------------------------------------------------------------------
+
+void SceneSetSpatialIndex( Scene3D *scene , SceneSpatialIndex index )
+{
+	scene->spatialIndex = index ;
+
+	// Only keep the memory of the selected index :
+
+	if ( index != SCENE_INDEX_BVH ) SceneReleaseBVH( scene );
+	if ( index != SCENE_INDEX_OCTREE ) SceneReleaseOctree( scene );
+
+	SceneInvalidateSpatialIndex( scene );
+}
+
+void SceneInvalidateSpatialIndex( Scene3D *scene )
+{
+	if ( scene->bvh != NULL ) scene->bvh->invalid = true ;
+	if ( scene->octree != NULL ) scene->octree->invalid = true ;
+}
+
+// True if the index is selected, and was built or refitted since the last change of the tree.
+bool _SceneBVHIsCurrent( Scene3D *scene )
+{
+	SceneBVH *bvh = scene->bvh ;
+
+	return scene->spatialIndex == SCENE_INDEX_BVH && bvh != NULL && ! bvh->invalid
+	    && bvh->builtNodeSlotsIndex == scene->nodeSlotsIndex && bvh->hierarchyVersion == NodePeekHierarchyVersion( scene->root );
+}
+
+bool _SceneOctreeIsCurrent( Scene3D *scene )
+{
+	SceneOctree *octree = scene->octree ;
+
+	return scene->spatialIndex == SCENE_INDEX_OCTREE && octree != NULL && ! octree->invalid
+	    && octree->builtNodeSlotsIndex == scene->nodeSlotsIndex && octree->hierarchyVersion == NodePeekHierarchyVersion( scene->root );
+}
+
+void SceneUpdateSpatialIndex( Scene3D *scene )
+{
+	_SceneUpdateSpatialIndex( scene , NULL , 0 );
+}
+
+// Same, knowing the node slots whose boundings may have changed (NULL : unknown, check them all).
+void _SceneUpdateSpatialIndex( Scene3D *scene , const int *changed , int changedCount )
+{
+	if ( scene->spatialIndex == SCENE_INDEX_BVH )
+	{
+		SceneBVH *bvh = scene->bvh ;
+
+		if ( ! _SceneBVHIsCurrent( scene ) )
+		{
+			SceneBuildBVH( scene );
+		}
+		else
+		if ( _SceneRefitBVH( scene , changed , changedCount ) )
+		{
+			// Refitting keeps the topology, so the BVH gets worse as the nodes move around :
+
+			if ( ( bvh->rebuildPeriod > 0 && bvh->refitsSinceBuild >= bvh->rebuildPeriod )
+			  || ( bvh->rebuildCostRatio > 0.0f && bvh->cost > bvh->buildCost * bvh->rebuildCostRatio ) )
+			{
+				SceneBuildBVH( scene );
+			}
+		}
+	}
+	else
+	if ( scene->spatialIndex == SCENE_INDEX_OCTREE )
+	{
+		SceneOctree *octree = scene->octree ;
+
+		// NOTE : also rebuild when too many nodes left the root, or when the moves left too many empty cells behind.
+		// The nodes too big for the children of the root stay in it after a rebuild, so only count the new ones.
+
+		if ( ! _SceneOctreeIsCurrent( scene )
+		  || octree->cells[0].itemsCount > octree->builtRootItemsCount + 16 + octree->itemsCount/4
+		  || octree->cellsCount > 64 + octree->itemsCount*4 )
+		{
+			SceneBuildOctree( scene );
+		}
+		else
+		{
+			SceneRefitOctree( scene );
+		}
+	}
+}
+
+// Query shapes :
+
+typedef enum
+{
+	_SCENE_QUERY_FRUSTUM ,
+	_SCENE_QUERY_BOX ,
+	_SCENE_QUERY_SPHERE ,
+
+} _SceneQueryType;
+
+typedef struct _SceneQuery
+{
+	_SceneQueryType type ;
+
+	Frustum *frustum ;
+	BoundingBox box ;
+	Vector3 center ;
+	float radius ;
+
+	Node3D **results ;
+	int maxResults ;
+	int found ;
+
+} _SceneQuery;
+
+bool _SceneQueryOverlaps( _SceneQuery *query , BoundingBox box )
+{
+	switch( query->type )
+	{
+		case _SCENE_QUERY_FRUSTUM : return FrustumClassifyBox( query->frustum , box ) != FRUSTUM_OUTSIDE ;
+		case _SCENE_QUERY_BOX     : return CheckCollisionBoxes( query->box , box );
+		case _SCENE_QUERY_SPHERE  : return CheckCollisionBoxSphere( box , query->center , query->radius );
+	}
+
+	return false ;
+}
+
+void _SceneQueryAdd( _SceneQuery *query , Node3D *node )
+{
+	if ( query->found < query->maxResults ) query->results[ query->found ] = node ;
+
+	query->found++ ;
+}
+
+// Query the nodes hierarchy, using the subtree boundings :
+NodeVisitResult _SceneQueryVisit( Node3D *node , int order , unsigned int *state , void *userData )
+{
+	_SceneQuery *query = (_SceneQuery*)userData ;
+
+	if ( node->subtreeBoxValid )
+	{
+		if ( BoundingBoxIsEmpty( node->subtreeBox ) ) return NODE_VISIT_PRUNE ;
+		if ( ! _SceneQueryOverlaps( query , node->subtreeBox ) ) return NODE_VISIT_PRUNE ;
+	}
+
+	if ( NodeIsDrawable( node ) && _SceneQueryOverlaps( query , node->transformedBox ) ) _SceneQueryAdd( query , node );
+
+	return NODE_VISIT_CONTINUE ;
+}
+
+void _SceneQueryBVH( _SceneQuery *query , SceneBVH *bvh )
+{
+	if ( bvh->nodesCount == 0 ) return ;
+
+	// NOTE : a local stack, so that several queries can run at once.
+
+	int stack[ SCENE_BVH_MAX_DEPTH + 1 ];
+
+	int top = 0 ;
+	stack[ top++ ] = 0 ;
+
+	while( top > 0 )
+	{
+		SceneBVHNode *bnode = &bvh->nodes[ stack[ --top ] ];
+
+		if ( ! _SceneQueryOverlaps( query , bnode->box ) ) continue ;
+
+		if ( bnode->left < 0 )
+		{
+			for( int i = bnode->first ; i < bnode->first + bnode->count ; i++ )
+			{
+				if ( _SceneQueryOverlaps( query , bvh->items[i]->transformedBox ) ) _SceneQueryAdd( query , bvh->items[i] );
+			}
+		}
+		else
+		{
+			stack[ top++ ] = bnode->right ;
+			stack[ top++ ] = bnode->left ;
+		}
+	}
+}
+
+BoundingBox _SceneOctreeCellLooseBox( SceneOctreeCell *cell )
+{
+	float h = 2.0f*cell->halfSize ;
+
+	return (BoundingBox){ { cell->center.x - h , cell->center.y - h , cell->center.z - h } , { cell->center.x + h , cell->center.y + h , cell->center.z + h } };
+}
+
+void _SceneQueryOctree( _SceneQuery *query , SceneOctree *octree )
+{
+	if ( octree->cellsCount == 0 ) return ;
+
+	int stack[ 7*SCENE_OCTREE_MAX_DEPTH + 8 ];
+	int top = 0 ;
+	stack[ top++ ] = 0 ;
+
+	while( top > 0 )
+	{
+		int c = stack[ --top ];
+		SceneOctreeCell *cell = &octree->cells[c] ;
+
+		if ( cell->subtreeItemsCount == 0 ) continue ;
+
+		// NOTE : the root also keeps the nodes that are outside of it, so it is never culled.
+
+		if ( c != 0 && ! _SceneQueryOverlaps( query , _SceneOctreeCellLooseBox( cell ) ) ) continue ;
+
+		for( int i = cell->firstItem ; i >= 0 ; i = octree->itemNext[i] )
+		{
+			if ( _SceneQueryOverlaps( query , octree->items[i]->transformedBox ) ) _SceneQueryAdd( query , octree->items[i] );
+		}
+
+		for( int o = 0 ; o < 8 ; o++ )
+		{
+			if ( cell->children[o] >= 0 ) stack[ top++ ] = cell->children[o] ;
+		}
+	}
+}
+
+int _SceneRunQuery( Scene3D *scene , _SceneQuery *query )
+{
+	if ( _SceneCheckRoot( scene ) == NULL ) return 0 ;
+
+	// NOTE : as for the culling, the index is not built here (see _SceneDraw()).
+
+	if ( _SceneBVHIsCurrent( scene ) )
+	{
+		_SceneQueryBVH( query , scene->bvh );
+	}
+	else
+	if ( _SceneOctreeIsCurrent( scene ) )
+	{
+		_SceneQueryOctree( query , scene->octree );
+	}
+	else
+	{
+		NodeTreeVisit( scene->root , NODE_VISIT_PRE_ORDER , 0 , _SceneQueryVisit , query , scene->stack );
+	}
+
+	return query->found ;
+}
+
+int SceneQueryFrustum( Scene3D *scene , Frustum *frustum , Node3D **results , int maxResults )
+{
+	_SceneQuery query = { _SCENE_QUERY_FRUSTUM };
+	query.frustum = frustum ;
+	query.results = results ;
+	query.maxResults = maxResults ;
+
+	return _SceneRunQuery( scene , &query );
+}
+
+int SceneQueryBox( Scene3D *scene , BoundingBox box , Node3D **results , int maxResults )
+{
+	_SceneQuery query = { _SCENE_QUERY_BOX };
+	query.box = box ;
+	query.results = results ;
+	query.maxResults = maxResults ;
+
+	return _SceneRunQuery( scene , &query );
+}
+
+int SceneQuerySphere( Scene3D *scene , Vector3 center , float radius , Node3D **results , int maxResults )
+{
+	_SceneQuery query = { _SCENE_QUERY_SPHERE };
+	query.center = center ;
+	query.radius = radius ;
+	query.results = results ;
+	query.maxResults = maxResults ;
+
+	return _SceneRunQuery( scene , &query );
+}
+
+//------------------------------------------------------------------------------------
+// BVH
+//------------------------------------------------------------------------------------
+
+float _BoundingBoxArea( BoundingBox box )
+{
+	if ( BoundingBoxIsEmpty( box ) ) return 0.0f ;
+
+	Vector3 d = Vector3Subtract( box.max , box.min );
+
+	return 2.0f*( d.x*d.y + d.y*d.z + d.z*d.x );
+}
+
+// Surface Area Heuristic cost of the BVH, relative to the area of its root :
+// NOTE : the probability for a ray or a box to hit a BVH node is proportional to its area,
+// so this is the average number of BVH nodes and items tested per query.
+// NOTE : also resets bvh->areaSum, which the refits then update node by node (see _SceneBVHSetBox()).
+float _SceneBVHCost( SceneBVH *bvh )
+{
+	bvh->areaSum = 0.0f ;
+
+	for( int i = 0 ; i < bvh->nodesCount ; i++ )
+	{
+		bvh->areaSum += _SceneBVHNodeArea( &bvh->nodes[i] );
+	}
+
+	return _SceneBVHCostFromSum( bvh );
+}
+
+// SAH term of a BVH node : its area, times the items tested if it is a leaf.
+float _SceneBVHNodeArea( SceneBVHNode *bnode )
+{
+	return _BoundingBoxArea( bnode->box ) * ( bnode->left < 0 ? (float)bnode->count : 1.0f );
+}
+
+float _SceneBVHCostFromSum( SceneBVH *bvh )
+{
+	if ( bvh->nodesCount == 0 ) return 0.0f ;
+
+	float rootArea = _BoundingBoxArea( bvh->nodes[0].box );
+
+	if ( rootArea <= 0.0f ) return 0.0f ;
+
+	return bvh->areaSum / rootArea ;
+}
+
+typedef struct _SceneBVHBuilder
+{
+	SceneBVH *bvh ;
+	BoundingBox *boxes ; // Boxes of the items
+	Vector3 *centers ;   // Centers of the boxes of the items
+
+} _SceneBVHBuilder;
+
+NodeVisitResult _SceneBVHCollectVisit( Node3D *node , int order , unsigned int *state , void *userData )
+{
+	SceneBVH *bvh = (SceneBVH*)userData ;
+
+	if ( NodeIsDrawable( node ) ) bvh->items[ bvh->itemsCount++ ] = node ;
+
+	return NODE_VISIT_CONTINUE ;
+}
+
+void _SceneBVHSwapItems( _SceneBVHBuilder *builder , int a , int b )
+{
+	Node3D *item = builder->bvh->items[a] ; builder->bvh->items[a] = builder->bvh->items[b] ; builder->bvh->items[b] = item ;
+	BoundingBox box = builder->boxes[a] ; builder->boxes[a] = builder->boxes[b] ; builder->boxes[b] = box ;
+	Vector3 center = builder->centers[a] ; builder->centers[a] = builder->centers[b] ; builder->centers[b] = center ;
+}
+
+// Compute the box of a new BVH node, and return where its items are split between its two children (-1 for a leaf).
+// NOTE : past half of SCENE_BVH_MAX_DEPTH, the items are split in halves whatever the SAH says, so the depth stays below SCENE_BVH_MAX_DEPTH.
+int _SceneBVHSplitNode( _SceneBVHBuilder *builder , SceneBVHNode *bnode , int depth )
+{
+	int first = bnode->first ;
+	int count = bnode->count ;
+
+	bnode->box = BoundingBoxEmpty();
+
+	BoundingBox centersBox = BoundingBoxEmpty();
+
+	for( int i = first ; i < first + count ; i++ )
+	{
+		bnode->box = BoundingBoxMerge( bnode->box , builder->boxes[i] );
+		centersBox = BoundingBoxMerge( centersBox , (BoundingBox){ builder->centers[i] , builder->centers[i] } );
+	}
+
+	if ( count <= 1 ) return -1 ;
+
+	// Split along the largest axis of the centers :
+
+	Vector3 extent = Vector3Subtract( centersBox.max , centersBox.min );
+
+	int axis = 0 ;
+	if ( extent.y > extent.x ) axis = 1 ;
+	if ( extent.z > ( axis == 0 ? extent.x : extent.y ) ) axis = 2 ;
+
+	float axisMin  = axis == 0 ? centersBox.min.x : ( axis == 1 ? centersBox.min.y : centersBox.min.z );
+	float axisSize = axis == 0 ? extent.x : ( axis == 1 ? extent.y : extent.z );
+
+	int mid = first + count/2 ; // Fallback : median split
+
+	if ( depth >= SCENE_BVH_MAX_DEPTH/2 )
+	{
+		if ( count <= SCENE_BVH_LEAF_SIZE ) return -1 ;
+	}
+	else
+	if ( axisSize > 0.0f )
+	{
+		// Binned SAH : put the centers into bins, and evaluate the cost of splitting between each bin :
+
+		int binCount[ SCENE_BVH_BINS ] = { 0 };
+		BoundingBox binBox[ SCENE_BVH_BINS ];
+
+		for( int b = 0 ; b < SCENE_BVH_BINS ; b++ ) binBox[b] = BoundingBoxEmpty();
+
+		float scale = (float)SCENE_BVH_BINS / axisSize ;
+
+		for( int i = first ; i < first + count ; i++ )
+		{
+			float c = axis == 0 ? builder->centers[i].x : ( axis == 1 ? builder->centers[i].y : builder->centers[i].z );
+			int b = (int)( ( c - axisMin ) * scale );
+			if ( b >= SCENE_BVH_BINS ) b = SCENE_BVH_BINS - 1 ;
+
+			binCount[b]++ ;
+			binBox[b] = BoundingBoxMerge( binBox[b] , builder->boxes[i] );
+		}
+
+		// Cost of the right side of each split, sweeping from the right :
+
+		float rightCost[ SCENE_BVH_BINS ];
+		BoundingBox rightBox = BoundingBoxEmpty();
+		int rightCount = 0 ;
+
+		for( int b = SCENE_BVH_BINS - 1 ; b > 0 ; b-- )
+		{
+			rightBox = BoundingBoxMerge( rightBox , binBox[b] );
+			rightCount += binCount[b] ;
+			rightCost[b] = _BoundingBoxArea( rightBox ) * rightCount ;
+		}
+
+		// Then sweep from the left to find the cheapest split :
+
+		BoundingBox leftBox = BoundingBoxEmpty();
+		int leftCount = 0 ;
+
+		float bestCost = FLT_MAX ;
+		int bestSplit = -1 ;
+
+		for( int b = 1 ; b < SCENE_BVH_BINS ; b++ )
+		{
+			leftBox = BoundingBoxMerge( leftBox , binBox[b-1] );
+			leftCount += binCount[b-1] ;
+
+			if ( leftCount == 0 || leftCount == count ) continue ;
+
+			float cost = _BoundingBoxArea( leftBox ) * leftCount + rightCost[b] ;
+
+			if ( cost < bestCost )
+			{
+				bestCost = cost ;
+				bestSplit = b ;
+			}
+		}
+
+		// Keep a leaf if splitting doesn't pay for the test of the BVH node it adds :
+
+		float nodeArea = _BoundingBoxArea( bnode->box );
+
+		if ( count <= SCENE_BVH_LEAF_SIZE && ( bestSplit < 0 || nodeArea + bestCost >= nodeArea * count ) ) return -1 ;
+
+		if ( bestSplit > 0 )
+		{
+			// Partition the items on both sides of the split :
+
+			int left = first ;
+			int right = first + count - 1 ;
+
+			while( left <= right )
+			{
+				float c = axis == 0 ? builder->centers[left].x : ( axis == 1 ? builder->centers[left].y : builder->centers[left].z );
+				int b = (int)( ( c - axisMin ) * scale );
+				if ( b >= SCENE_BVH_BINS ) b = SCENE_BVH_BINS - 1 ;
+
+				if ( b < bestSplit )
+				{
+					left++ ;
+				}
+				else
+				{
+					_SceneBVHSwapItems( builder , left , right );
+					right-- ;
+				}
+			}
+
+			if ( left > first && left < first + count ) mid = left ;
+		}
+	}
+	else
+	if ( count <= SCENE_BVH_LEAF_SIZE ) // All the centers are at the same place
+	{
+		return -1 ;
+	}
+
+	return mid ;
+}
+
+typedef struct _SceneBVHBuildTask
+{
+	int first ;
+	int count ;
+	int parent ;
+	int depth ;
+
+} _SceneBVHBuildTask;
+
+// Build the BVH of the items [0, count[, depth first.
+// NOTE : the left child is popped first, so that a BVH subtree is stored right after its parent, as when built recursively.
+void _SceneBVHBuild( _SceneBVHBuilder *builder , int count )
+{
+	SceneBVH *bvh = builder->bvh ;
+
+	_SceneBVHBuildTask stack[ SCENE_BVH_MAX_DEPTH + 1 ];
+	int top = 0 ;
+
+	stack[ top++ ] = (_SceneBVHBuildTask){ 0 , count , -1 , 0 };
+
+	while( top > 0 )
+	{
+		_SceneBVHBuildTask task = stack[ --top ];
+
+		int index = bvh->nodesCount++ ;
+
+		SceneBVHNode *bnode = &bvh->nodes[ index ];
+
+		bnode->parent = task.parent ;
+		bnode->left   = -1 ;
+		bnode->right  = -1 ;
+		bnode->first  = task.first ;
+		bnode->count  = task.count ;
+
+		if ( task.parent >= 0 )
+		{
+			if ( bvh->nodes[ task.parent ].left < 0 ) bvh->nodes[ task.parent ].left = index ;
+			else bvh->nodes[ task.parent ].right = index ;
+		}
+
+		int mid = _SceneBVHSplitNode( builder , bnode , task.depth );
+
+		if ( mid < 0 ) continue ;
+
+		stack[ top++ ] = (_SceneBVHBuildTask){ mid , task.first + task.count - mid , index , task.depth + 1 };
+		stack[ top++ ] = (_SceneBVHBuildTask){ task.first , mid - task.first , index , task.depth + 1 };
+	}
+}
+
+void SceneBuildBVH( Scene3D *scene )
+{
+	SceneBVH *bvh = scene->bvh ;
+
+	if ( bvh == NULL )
+	{
+		bvh = (SceneBVH*)MemAlloc( sizeof( SceneBVH ) );
+
+		bvh->rebuildCostRatio = 1.5f ;
+		bvh->rebuildPeriod = 0 ;
+
+		scene->bvh = bvh ;
+	}
+
+	// Collect the drawable nodes of the tree :
+	// NOTE : a BVH of n items has at most 2n-1 nodes, so the arrays never grow while building.
+
+	int maxItems = scene->nodeSlotsIndex > 0 ? scene->nodeSlotsIndex : 1 ;
+
+	bvh->items = (Node3D**)MemRealloc( bvh->items , sizeof( Node3D* )*maxItems );
+	bvh->itemsCount = 0 ;
+
+	if ( _SceneCheckRoot( scene ) != NULL )
+	{
+		NodeTreeVisit( scene->root , NODE_VISIT_PRE_ORDER , 0 , _SceneBVHCollectVisit , bvh , scene->stack );
+	}
+
+	bvh->nodes = (SceneBVHNode*)MemRealloc( bvh->nodes , sizeof( SceneBVHNode )*( 2*maxItems ) );
+	bvh->itemLeaf = (int*)MemRealloc( bvh->itemLeaf , sizeof( int )*maxItems );
+	bvh->slotItem = (int*)MemRealloc( bvh->slotItem , sizeof( int )*maxItems );
+	bvh->nodesCount = 0 ;
+
+	if ( bvh->itemsCount > 0 )
+	{
+		_SceneBVHBuilder builder ;
+
+		builder.bvh = bvh ;
+		builder.boxes = (BoundingBox*)MemAlloc( sizeof( BoundingBox )*bvh->itemsCount );
+		builder.centers = (Vector3*)MemAlloc( sizeof( Vector3 )*bvh->itemsCount );
+
+		for( int i = 0 ; i < bvh->itemsCount ; i++ )
+		{
+			builder.boxes[i] = bvh->items[i]->transformedBox ;
+			builder.centers[i] = Vector3Scale( Vector3Add( builder.boxes[i].min , builder.boxes[i].max ) , 0.5f );
+		}
+
+		_SceneBVHBuild( &builder , bvh->itemsCount );
+
+		MemFree( builder.boxes );
+		MemFree( builder.centers );
+	}
+
+	// Find the leaf of each item, and the item of each node slot :
+	// NOTE : the nodes outside of the slots are not listed, but SceneRefitBVH() still checks them all.
+
+	for( int i = 0 ; i < bvh->nodesCount ; i++ )
+	{
+		if ( bvh->nodes[i].left >= 0 ) continue ;
+
+		for( int k = bvh->nodes[i].first ; k < bvh->nodes[i].first + bvh->nodes[i].count ; k++ ) bvh->itemLeaf[k] = i ;
+	}
+
+	for( int i = 0 ; i < maxItems ; i++ ) bvh->slotItem[i] = -1 ;
+
+	for( int k = 0 ; k < bvh->itemsCount ; k++ )
+	{
+		int slot = (int)( bvh->items[k] - scene->nodeSlots );
+
+		if ( slot >= 0 && slot < scene->nodeSlotsIndex ) bvh->slotItem[ slot ] = k ;
+	}
+
+	bvh->buildCost = _SceneBVHCost( bvh );
+	bvh->cost = bvh->buildCost ;
+	bvh->refitsSinceBuild = 0 ;
+	bvh->builtNodeSlotsIndex = scene->nodeSlotsIndex ;
+	bvh->hierarchyVersion = NodeGetHierarchyVersion( scene->root );
+	bvh->invalid = false ;
+}
+
+bool _BoundingBoxEquals( BoundingBox a , BoundingBox b )
+{
+	return a.min.x == b.min.x && a.min.y == b.min.y && a.min.z == b.min.z
+	    && a.max.x == b.max.x && a.max.y == b.max.y && a.max.z == b.max.z ;
+}
+
+// Replace the box of a BVH node, and update the SAH sum.
+void _SceneBVHSetBox( SceneBVH *bvh , int index , BoundingBox box )
+{
+	SceneBVHNode *bnode = &bvh->nodes[ index ] ;
+
+	bvh->areaSum -= _SceneBVHNodeArea( bnode );
+	bnode->box = box ;
+	bvh->areaSum += _SceneBVHNodeArea( bnode );
+}
+
+// Recompute the box of a leaf from its items, and then of its ancestors, up to the first one that doesn't change.
+// Return true if the leaf changed.
+bool _SceneBVHRefitLeaf( SceneBVH *bvh , int leaf )
+{
+	SceneBVHNode *bnode = &bvh->nodes[ leaf ] ;
+
+	BoundingBox box = BoundingBoxEmpty();
+
+	for( int k = bnode->first ; k < bnode->first + bnode->count ; k++ )
+	{
+		box = BoundingBoxMerge( box , bvh->items[k]->transformedBox );
+	}
+
+	if ( _BoundingBoxEquals( box , bnode->box ) ) return false ;
+
+	_SceneBVHSetBox( bvh , leaf , box );
+
+	for( int i = bnode->parent ; i >= 0 ; i = bvh->nodes[i].parent )
+	{
+		box = BoundingBoxMerge( bvh->nodes[ bvh->nodes[i].left ].box , bvh->nodes[ bvh->nodes[i].right ].box );
+
+		if ( _BoundingBoxEquals( box , bvh->nodes[i].box ) ) break ;
+
+		_SceneBVHSetBox( bvh , i , box );
+	}
+
+	return true ;
+}
+
+// Check the boxes of all the leaves, and update the ancestors of the changed ones only.
+bool SceneRefitBVH( Scene3D *scene )
+{
+	return _SceneRefitBVH( scene , NULL , 0 );
+}
+
+// Same, for the leaves of the given node slots only (NULL : all the leaves).
+// NOTE : a leaf listed twice stops at once the second time, as its box doesn't change anymore.
+bool _SceneRefitBVH( Scene3D *scene , const int *changed , int changedCount )
+{
+	SceneBVH *bvh = scene->bvh ;
+
+	if ( bvh == NULL ) return false ;
+
+	bool refitted = false ;
+
+	if ( changed == NULL )
+	{
+		for( int i = 0 ; i < bvh->nodesCount ; i++ )
+		{
+			if ( bvh->nodes[i].left < 0 && _SceneBVHRefitLeaf( bvh , i ) ) refitted = true ;
+		}
+	}
+	else
+	{
+		for( int c = 0 ; c < changedCount ; c++ )
+		{
+			int item = changed[c] < bvh->builtNodeSlotsIndex ? bvh->slotItem[ changed[c] ] : -1 ;
+
+			if ( item >= 0 && _SceneBVHRefitLeaf( bvh , bvh->itemLeaf[ item ] ) ) refitted = true ;
+		}
+	}
+
+	bvh->refitsSinceBuild++ ;
+
+	if ( refitted ) bvh->cost = _SceneBVHCostFromSum( bvh );
+
+	return refitted ;
+}
+
+void SceneReleaseBVH( Scene3D *scene )
+{
+	if ( scene->bvh == NULL ) return ;
+
+	MemFree( scene->bvh->nodes );
+	MemFree( scene->bvh->items );
+	MemFree( scene->bvh->itemLeaf );
+	MemFree( scene->bvh->slotItem );
+	MemFree( scene->bvh );
+
+	scene->bvh = NULL ;
+}
+
+// Tell the items of a culled BVH subtree that they are outside the view :
+void _SceneBVHSetOutsideView( SceneBVH *bvh , SceneBVHNode *bnode , NodeView *view )
+{
+	if ( view == NULL ) return ;
+
+	for( int i = bnode->first ; i < bnode->first + bnode->count ; i++ )
+	{
+		_SceneSetOutsideView( bvh->items[i] , view );
+	}
+}
+
+// Draw the visible nodes using the BVH, with the same plane masking as NodeTreeDrawInFrustum().
+int _SceneBVHDrawInFrustum( Scene3D *scene , Frustum *frustum , NodeView *view , VisibleList *list )
+{
+	SceneBVH *bvh = scene->bvh ;
+
+	if ( bvh->nodesCount == 0 ) return 0 ;
+
+	int nodeDrawn = 0 ;
+
+	// The stack contains pairs of ( BVH node , planes mask ) :
+	// NOTE : a local stack, so that several views can be culled at once.
+
+	int stack[ 2*( SCENE_BVH_MAX_DEPTH + 1 ) ];
+
+	int top = 0 ;
+	stack[ top++ ] = 0 ;
+	stack[ top++ ] = FRUSTUM_ALL_PLANES ;
+
+	while( top > 0 )
+	{
+		unsigned int planeMask = (unsigned int)stack[ --top ] ;
+		SceneBVHNode *bnode = &bvh->nodes[ stack[ --top ] ];
+
+		if ( FrustumClassifyBoxMasked( frustum , bnode->box , &planeMask ) == FRUSTUM_OUTSIDE )
+		{
+			_SceneBVHSetOutsideView( bvh , bnode , view );
+			continue ;
+		}
+
+		if ( bnode->left < 0 )
+		{
+			for( int i = bnode->first ; i < bnode->first + bnode->count ; i++ )
+			{
+				if ( _SceneDrawNode( bvh->items[i] , frustum , view , planeMask , list ) ) nodeDrawn++ ;
+			}
+		}
+		else
+		{
+			stack[ top++ ] = bnode->right ;
+			stack[ top++ ] = (int)planeMask ;
+			stack[ top++ ] = bnode->left ;
+			stack[ top++ ] = (int)planeMask ;
+		}
+	}
+
+	return nodeDrawn ;
+}
+
+//------------------------------------------------------------------------------------
+// Loose octree
+//------------------------------------------------------------------------------------
+
+float _BoundingBoxHalfSize( BoundingBox box )
+{
+	float hx = ( box.max.x - box.min.x )*0.5f ;
+	float hy = ( box.max.y - box.min.y )*0.5f ;
+	float hz = ( box.max.z - box.min.z )*0.5f ;
+
+	return fmaxf( hx , fmaxf( hy , hz ) );
+}
+
+// Tell if a point is inside the (strict) bounds of a cell :
+bool _SceneOctreeCellContains( SceneOctreeCell *cell , Vector3 point )
+{
+	return point.x >= cell->center.x - cell->halfSize && point.x < cell->center.x + cell->halfSize
+	    && point.y >= cell->center.y - cell->halfSize && point.y < cell->center.y + cell->halfSize
+	    && point.z >= cell->center.z - cell->halfSize && point.z < cell->center.z + cell->halfSize ;
+}
+
+int _SceneOctreeAddCell( SceneOctree *octree , int parent , int octant )
+{
+	if ( octree->cellsCount == octree->cellsSize )
+	{
+		octree->cellsSize = octree->cellsSize * 2 + 8 ;
+		octree->cells = (SceneOctreeCell*)MemRealloc( octree->cells , sizeof( SceneOctreeCell )*octree->cellsSize );
+	}
+
+	int c = octree->cellsCount++ ;
+
+	SceneOctreeCell *cell = &octree->cells[c] ;
+
+	cell->parent = parent ;
+	for( int o = 0 ; o < 8 ; o++ ) cell->children[o] = -1 ;
+	cell->firstItem = -1 ;
+	cell->itemsCount = 0 ;
+	cell->subtreeItemsCount = 0 ;
+
+	if ( parent >= 0 )
+	{
+		SceneOctreeCell *parentCell = &octree->cells[ parent ] ; // NOTE : after the realloc
+
+		cell->halfSize = parentCell->halfSize*0.5f ;
+		cell->center.x = parentCell->center.x + ( octant & 1 ? cell->halfSize : -cell->halfSize );
+		cell->center.y = parentCell->center.y + ( octant & 2 ? cell->halfSize : -cell->halfSize );
+		cell->center.z = parentCell->center.z + ( octant & 4 ? cell->halfSize : -cell->halfSize );
+
+		parentCell->children[ octant ] = c ;
+	}
+
+	return c ;
+}
+
+// Find the deepest cell that contains the center of the box, and whose loose bounds contain the whole box.
+// Nodes that are outside of the root, or too big for it, are kept in the root.
+int _SceneOctreeFindCell( SceneOctree *octree , BoundingBox box )
+{
+	Vector3 center = Vector3Scale( Vector3Add( box.min , box.max ) , 0.5f );
+	float halfSize = _BoundingBoxHalfSize( box );
+
+	int c = 0 ;
+
+	if ( ! _SceneOctreeCellContains( &octree->cells[0] , center ) ) return c ;
+
+	for( int depth = 0 ; depth < SCENE_OCTREE_MAX_DEPTH ; depth++ )
+	{
+		SceneOctreeCell *cell = &octree->cells[c] ;
+
+		if ( halfSize > cell->halfSize*0.5f ) break ; // Doesn't fit in the loose bounds of the children
+
+		int octant = ( center.x >= cell->center.x ? 1 : 0 )
+		           | ( center.y >= cell->center.y ? 2 : 0 )
+		           | ( center.z >= cell->center.z ? 4 : 0 );
+
+		int child = cell->children[ octant ];
+
+		if ( child < 0 ) child = _SceneOctreeAddCell( octree , c , octant );
+
+		c = child ;
+	}
+
+	return c ;
+}
+
+void _SceneOctreeLink( SceneOctree *octree , int item , int c )
+{
+	SceneOctreeCell *cell = &octree->cells[c] ;
+
+	octree->itemCell[ item ] = c ;
+	octree->itemPrev[ item ] = -1 ;
+	octree->itemNext[ item ] = cell->firstItem ;
+
+	if ( cell->firstItem >= 0 ) octree->itemPrev[ cell->firstItem ] = item ;
+
+	cell->firstItem = item ;
+	cell->itemsCount++ ;
+
+	for( ; c >= 0 ; c = octree->cells[c].parent ) octree->cells[c].subtreeItemsCount++ ;
+}
+
+void _SceneOctreeUnlink( SceneOctree *octree , int item )
+{
+	int c = octree->itemCell[ item ];
+
+	SceneOctreeCell *cell = &octree->cells[c] ;
+
+	if ( octree->itemPrev[ item ] >= 0 ) octree->itemNext[ octree->itemPrev[ item ] ] = octree->itemNext[ item ];
+	else cell->firstItem = octree->itemNext[ item ];
+
+	if ( octree->itemNext[ item ] >= 0 ) octree->itemPrev[ octree->itemNext[ item ] ] = octree->itemPrev[ item ];
+
+	cell->itemsCount-- ;
+
+	for( ; c >= 0 ; c = octree->cells[c].parent ) octree->cells[c].subtreeItemsCount-- ;
+}
+
+NodeVisitResult _SceneOctreeCollectVisit( Node3D *node , int order , unsigned int *state , void *userData )
+{
+	SceneOctree *octree = (SceneOctree*)userData ;
+
+	if ( NodeIsDrawable( node ) ) octree->items[ octree->itemsCount++ ] = node ;
+
+	return NODE_VISIT_CONTINUE ;
+}
+
+void SceneBuildOctree( Scene3D *scene )
+{
+	SceneOctree *octree = scene->octree ;
+
+	if ( octree == NULL )
+	{
+		octree = (SceneOctree*)MemAlloc( sizeof( SceneOctree ) );
+
+		scene->octree = octree ;
+	}
+
+	// Collect the drawable nodes of the tree :
+
+	int maxItems = scene->nodeSlotsIndex > 0 ? scene->nodeSlotsIndex : 1 ;
+
+	octree->items = (Node3D**)MemRealloc( octree->items , sizeof( Node3D* )*maxItems );
+	octree->itemCell = (int*)MemRealloc( octree->itemCell , sizeof( int )*maxItems );
+	octree->itemNext = (int*)MemRealloc( octree->itemNext , sizeof( int )*maxItems );
+	octree->itemPrev = (int*)MemRealloc( octree->itemPrev , sizeof( int )*maxItems );
+	octree->itemsCount = 0 ;
+
+	if ( _SceneCheckRoot( scene ) != NULL )
+	{
+		NodeTreeVisit( scene->root , NODE_VISIT_PRE_ORDER , 0 , _SceneOctreeCollectVisit , octree , scene->stack );
+	}
+
+	// The root cell is the bounding cube of the centers, with some room to move :
+
+	BoundingBox centers = BoundingBoxEmpty();
+
+	for( int i = 0 ; i < octree->itemsCount ; i++ )
+	{
+		centers = BoundingBoxMerge( centers , (BoundingBox){ octree->items[i]->transformedCenter , octree->items[i]->transformedCenter } );
+	}
+
+	octree->cellsCount = 0 ;
+
+	int root = _SceneOctreeAddCell( octree , -1 , 0 );
+
+	if ( octree->itemsCount > 0 )
+	{
+		octree->cells[ root ].center = Vector3Scale( Vector3Add( centers.min , centers.max ) , 0.5f );
+		octree->cells[ root ].halfSize = fmaxf( _BoundingBoxHalfSize( centers ) * 1.5f , 1.0f );
+	}
+	else
+	{
+		octree->cells[ root ].center = Vector3Zero();
+		octree->cells[ root ].halfSize = 1.0f ;
+	}
+
+	for( int i = 0 ; i < octree->itemsCount ; i++ )
+	{
+		_SceneOctreeLink( octree , i , _SceneOctreeFindCell( octree , octree->items[i]->transformedBox ) );
+	}
+
+	octree->reinsertions = 0 ;
+	octree->builtNodeSlotsIndex = scene->nodeSlotsIndex ;
+	octree->hierarchyVersion = NodeGetHierarchyVersion( scene->root );
+	octree->builtRootItemsCount = octree->cells[0].itemsCount ;
+	octree->invalid = false ;
+}
+
+int SceneRefitOctree( Scene3D *scene )
+{
+	SceneOctree *octree = scene->octree ;
+
+	if ( octree == NULL ) return 0 ;
+
+	octree->reinsertions = 0 ;
+
+	for( int i = 0 ; i < octree->itemsCount ; i++ )
+	{
+		Node3D *node = octree->items[i] ;
+		SceneOctreeCell *cell = &octree->cells[ octree->itemCell[i] ] ;
+
+		// Most moves stay inside the cell, and then nothing has to be done.
+		// NOTE : a node that grew too big for the loose bounds has to move too.
+
+		bool stays ;
+
+		if ( cell->parent < 0 )
+		{
+			stays = ! _SceneOctreeCellContains( cell , node->transformedCenter ) || _BoundingBoxHalfSize( node->transformedBox ) > cell->halfSize*0.5f ;
+		}
+		else
+		{
+			stays = _SceneOctreeCellContains( cell , node->transformedCenter ) && _BoundingBoxHalfSize( node->transformedBox ) <= cell->halfSize ;
+		}
+
+		if ( stays ) continue ;
+
+		int c = _SceneOctreeFindCell( octree , node->transformedBox );
+
+		if ( c == octree->itemCell[i] ) continue ;
+
+		_SceneOctreeUnlink( octree , i );
+		_SceneOctreeLink( octree , i , c );
+
+		octree->reinsertions++ ;
+	}
+
+	return octree->reinsertions ;
+}
+
+void SceneReleaseOctree( Scene3D *scene )
+{
+	if ( scene->octree == NULL ) return ;
+
+	MemFree( scene->octree->cells );
+	MemFree( scene->octree->items );
+	MemFree( scene->octree->itemCell );
+	MemFree( scene->octree->itemNext );
+	MemFree( scene->octree->itemPrev );
+	MemFree( scene->octree );
+
+	scene->octree = NULL ;
+}
+
+// Tell the items of a culled cell and of its descendants that they are outside the view :
+void _SceneOctreeSetOutsideView( SceneOctree *octree , int c , NodeView *view )
+{
+	if ( view == NULL ) return ;
+
+	int stack[ 7*SCENE_OCTREE_MAX_DEPTH + 8 ];
+	int top = 0 ;
+	stack[ top++ ] = c ;
+
+	while( top > 0 )
+	{
+		SceneOctreeCell *cell = &octree->cells[ stack[ --top ] ] ;
+
+		if ( cell->subtreeItemsCount == 0 ) continue ;
+
+		for( int i = cell->firstItem ; i >= 0 ; i = octree->itemNext[i] )
+		{
+			_SceneSetOutsideView( octree->items[i] , view );
+		}
+
+		for( int o = 0 ; o < 8 ; o++ )
+		{
+			if ( cell->children[o] >= 0 ) stack[ top++ ] = cell->children[o] ;
+		}
+	}
+}
+
+// Draw the visible nodes using the loose octree, with the same plane masking as NodeTreeDrawInFrustum().
+int _SceneOctreeDrawInFrustum( Scene3D *scene , Frustum *frustum , NodeView *view , VisibleList *list )
+{
+	SceneOctree *octree = scene->octree ;
+
+	if ( octree->cellsCount == 0 ) return 0 ;
+
+	int nodeDrawn = 0 ;
+
+	// The stack contains pairs of ( cell , planes mask ) :
+
+	int stack[ 2*( 7*SCENE_OCTREE_MAX_DEPTH + 8 ) ];
+	int top = 0 ;
+	stack[ top++ ] = 0 ;
+	stack[ top++ ] = FRUSTUM_ALL_PLANES ;
+
+	while( top > 0 )
+	{
+		unsigned int planeMask = (unsigned int)stack[ --top ] ;
+		int c = stack[ --top ] ;
+
+		SceneOctreeCell *cell = &octree->cells[c] ;
+
+		if ( cell->subtreeItemsCount == 0 ) continue ;
+
+		// NOTE : the root also keeps the nodes that are outside of it, so it is never culled.
+
+		if ( c != 0 && FrustumClassifyBoxMasked( frustum , _SceneOctreeCellLooseBox( cell ) , &planeMask ) == FRUSTUM_OUTSIDE )
+		{
+			_SceneOctreeSetOutsideView( octree , c , view );
+			continue ;
+		}
+
+		for( int i = cell->firstItem ; i >= 0 ; i = octree->itemNext[i] )
+		{
+			if ( _SceneDrawNode( octree->items[i] , frustum , view , planeMask , list ) ) nodeDrawn++ ;
+		}
+
+		for( int o = 0 ; o < 8 ; o++ )
+		{
+			if ( cell->children[o] < 0 ) continue ;
+
+			stack[ top++ ] = cell->children[o] ;
+			stack[ top++ ] = (int)planeMask ;
+		}
+	}
+
+	return nodeDrawn ;
 }
 
 #endif //RSCENEGRAPH_IMPLEMENTATION
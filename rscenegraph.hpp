@@ -0,0 +1,166 @@
+#ifndef RSCENEGRAPH_HPP
+#define RSCENEGRAPH_HPP
+
+#include "rscenegraph.h"
+
+#include <type_traits> // Required for: std::is_void, std::true_type, std::false_type
+
+// C++ visitors :
+// NOTE : optional C++ layer over rnodes.h and rscenegraph.h. The functions below take any callable (lambda, functor...)
+// instead of a function pointer, so the compiler can inline it into the traversal loop.
+// The callable receives the node, and returns either nothing, or a NodeVisitResult to prune the subtree or stop.
+// Like NodeTreeVisit(), the traversal is iterative, and a callable can start another traversal.
+// If stack is NULL, the traversal allocates its own and frees it when it returns : give one to reuse it between the traversals.
+//
+// Example :
+//
+//     ForEachNode( root , [&]( Node *node ) { count++ ; } );
+//
+//     ForEachVisible( root , &frustum , [&]( Node *node )
+//     {
+//         DrawModel( *node->model , ... );
+//         return node->occluder ? NODE_VISIT_PRUNE : NODE_VISIT_CONTINUE ;
+//     });
+
+//--------
+
+// Call the callable, which may return void (continue) or a NodeVisitResult :
+
+template< typename F >
+inline NodeVisitResult _ForEachNodeCall( F &callable , Node *node , std::true_type /* returns void */ )
+{
+	callable( node );
+
+	return NODE_VISIT_CONTINUE ;
+}
+
+template< typename F >
+inline NodeVisitResult _ForEachNodeCall( F &callable , Node *node , std::false_type )
+{
+	return callable( node );
+}
+
+template< typename F >
+inline NodeVisitResult _ForEachNodeCall( F &callable , Node *node )
+{
+	return _ForEachNodeCall( callable , node , typename std::is_void< decltype( callable( node ) ) >::type() );
+}
+
+// Pre-order depth-first traversal of the branch, and of its next siblings if asked.
+// NOTE : unlike _NodeVisit(), there is no post-order, so a node is popped before its visit, and its next sibling
+// is pushed below its first child : the stack still holds one entry per level at most.
+// visit( node , state ) returns a NodeVisitResult, and the children inherit the state as it left it.
+template< typename V >
+inline NodeVisitResult _ForEachNodeVisit( Node *branch , bool siblings , unsigned int state , V &visit , NodeStack *stack )
+{
+	if ( branch == NULL ) return NODE_VISIT_CONTINUE ;
+
+	NodeStack local = { NULL , 0 , 0 }; // Owned by this traversal if not given a stack
+
+	if ( stack == NULL ) stack = &local ;
+
+	NodeVisitResult result = NODE_VISIT_CONTINUE ;
+
+	int base = stack->count ;
+
+	NodeStackPush( stack , branch , state );
+
+	while( stack->count > base )
+	{
+		NodeStackEntry entry = stack->entries[ --stack->count ];
+
+		Node3D *node = entry.node ;
+
+		if ( node->nextSibling != NULL && ( node != branch || siblings ) )
+		{
+			NodeStackPush( stack , node->nextSibling , entry.state );
+		}
+
+		NodeVisitResult visited = visit( node , entry.state );
+
+		if ( visited == NODE_VISIT_STOP )
+		{
+			stack->count = base ;
+			result = NODE_VISIT_STOP ;
+			break ;
+		}
+
+		if ( visited == NODE_VISIT_CONTINUE && node->firstChild != NULL )
+		{
+			NodeStackPush( stack , node->firstChild , entry.state );
+		}
+	}
+
+	MemFree( local.entries );
+
+	return result ;
+}
+
+//--------
+
+// Call the callable for each node of the tree (root and its siblings), parents first.
+// Return NODE_VISIT_STOP if stopped by the callable.
+template< typename F >
+inline NodeVisitResult ForEachNode( Node *root , F &&callable , NodeStack *stack = NULL )
+{
+	auto visit = [&]( Node *node , unsigned int & ) { return _ForEachNodeCall( callable , node ); };
+
+	return _ForEachNodeVisit( root , true , 0 , visit , stack );
+}
+
+// Same for the branch only.
+template< typename F >
+inline NodeVisitResult ForEachNodeInBranch( Node *branch , F &&callable , NodeStack *stack = NULL )
+{
+	auto visit = [&]( Node *node , unsigned int & ) { return _ForEachNodeCall( callable , node ); };
+
+	return _ForEachNodeVisit( branch , false , 0 , visit , stack );
+}
+
+template< typename F >
+inline NodeVisitResult ForEachNode( Scene3D *scene , F &&callable )
+{
+	return ForEachNode( scene->root , callable , scene->stack );
+}
+
+// Call the callable for each drawable node of the tree whose box is in the frustum (and not occluded, if the frustum
+// has an occlusion buffer), parents first.
+// NOTE : same tests as NodeTreeCullInFrustum(), without the LODs and the caches : the transforms must be up to date,
+// and the branches are culled at once with their subtree boundings. The state is the planeMask.
+template< typename F >
+inline NodeVisitResult ForEachVisible( Node *root , Frustum *frustum , F &&callable , NodeStack *stack = NULL )
+{
+	auto visit = [&]( Node *node , unsigned int &planeMask )
+	{
+		// NOTE : the subtree box of a leaf is its own box, tested below anyway.
+
+		if ( node->subtreeBoxValid && ( node->firstChild != NULL || BoundingBoxIsEmpty( node->subtreeBox ) ) )
+		{
+			if ( BoundingBoxIsEmpty( node->subtreeBox ) || FrustumClassifyBoxMasked( frustum , node->subtreeBox , &planeMask ) == FRUSTUM_OUTSIDE
+			  || ( frustum->occlusion != NULL && ! OcclusionBufferTestBox( frustum->occlusion , node->subtreeBox ) ) )
+			{
+				return NODE_VISIT_PRUNE ;
+			}
+		}
+
+		if ( ! NodeIsDrawable( node ) ) return NODE_VISIT_CONTINUE ;
+
+		unsigned int nodePlaneMask = planeMask ;
+
+		if ( FrustumClassifyBoxMasked( frustum , node->transformedBox , &nodePlaneMask ) == FRUSTUM_OUTSIDE ) return NODE_VISIT_CONTINUE ;
+
+		if ( frustum->occlusion != NULL && ! node->occluder && ! OcclusionBufferTestBox( frustum->occlusion , node->transformedBox ) ) return NODE_VISIT_CONTINUE ;
+
+		return _ForEachNodeCall( callable , node );
+	};
+
+	return _ForEachNodeVisit( root , true , FRUSTUM_ALL_PLANES , visit , stack );
+}
+
+template< typename F >
+inline NodeVisitResult ForEachVisible( Scene3D *scene , Frustum *frustum , F &&callable )
+{
+	return ForEachVisible( scene->root , frustum , callable , scene->stack );
+}
+
+#endif // RSCENEGRAPH_HPP
@@ -0,0 +1,1641 @@
+#ifndef RSKINNING_H
+#define RSKINNING_H
+
+#include "raylib.h"
+#include "raymath.h"
+
+#include "rtransforms.h"
+#include "rworkers.h"
+
+// CPU skinning :
+// NOTE : the animation of a model is split in two steps, instead of UpdateModelAnimation() doing both on the shared Model :
+// - the pose : the skinning matrix of each bone, sampled from a frame of an animation. It is small, and each node owns one.
+// - the skinning : the vertices and normals of the meshes blended by these matrices, done when the model is drawn.
+// The meshes of a Model are shared by all its copies and by all the nodes using it, so ModelSkin() remembers
+// which pose they hold, and only skins them again when another pose is drawn.
+//
+// The skinning matrices give the same vertices as UpdateModelAnimation() (up to rounding). The normals are transformed
+// by their 3x3 part, scale included (raylib only rotates them) : it is the same direction for uniform scales.
+//
+// Skinned vertex cache :
+// NOTE : the nodes sharing a model and an animation are often on the same frame, since the frame is the integer part of
+// their timeline. So ModelSkin() keeps the skinned vertices of each (model, animation, frame) in a cache, and only
+// uploads them again when the pose is found there. The least recently used entries are dropped to stay within the budget.
+// The mesh.animVertices and mesh.animNormals are only written when the pose is not cached.
+//
+// Skinning batches :
+// NOTE : the skinning can also be done for a whole frame before drawing it : SkinBatchAdd() reserves a cache entry for
+// each pose that is not cached yet, and SkinBatchRun() skins them all at once, split in ranges of vertices processed by
+// a worker pool. The draw then finds them in the cache, so only the upload to the GPU is left to the main thread.
+// The models and the poses must not change between SkinBatchAdd() and SkinBatchRun(). The queued entries are pinned :
+// if the cache drops them meanwhile (SkinCacheSetBudget(), SkinCacheClear(), ModelForgetSkin()), the batch skips them,
+// and they are freed once it has run. The poses that don't fit in the cache budget are left to the draw.
+//
+// Compressed animation clips :
+// NOTE : a ModelAnimation stores a full Transform (40 bytes) for each bone of each frame. AnimationClipCompress() splits
+// it into a translation, a rotation and a scale track per bone, and :
+// - drops the tracks that don't change more than the error bounds, keeping a single value,
+// - quantizes the others : the rotations as their 3 smallest components (15 bits each, the largest one is rebuilt),
+//   the translations and scales on 16 bits within the range of their track (6 bytes per key),
+// - optionally removes the keys that the interpolation of their neighbours gives within the error bounds,
+// - checks each track once decoded : if it is off by more than the bounds, all its keys are kept, and if the quantization
+//   alone is (a range too large for 16 bits, or bounds finer than the rotations), the track is kept raw (16 bytes per frame).
+// The frames are decompressed when sampled, by AnimationPoseSampleClip() or AnimationClipSampleBone(). The clip keeps
+// a pointer to its ModelAnimation, for its name, bones and frame count, and as the pose identity for the skin cache.
+
+#ifndef SKIN_CACHE_BUDGET
+#define SKIN_CACHE_BUDGET (32*1024*1024) // Default budget of the skinned vertex cache, in bytes (0 disables it)
+#endif
+
+#ifndef SKIN_BATCH_GRAIN
+#define SKIN_BATCH_GRAIN 2048 // Vertices skinned by each range of SkinBatchRun()
+#endif
+
+#ifndef ANIMATION_COMPRESSION_TRANSLATION_ERROR
+#define ANIMATION_COMPRESSION_TRANSLATION_ERROR 0.0005f // Default maximum distance between a compressed translation and the original one
+#endif
+
+#ifndef ANIMATION_COMPRESSION_ROTATION_ERROR
+#define ANIMATION_COMPRESSION_ROTATION_ERROR 0.001f // Default maximum angle between a compressed rotation and the original one, in radians
+#endif
+
+#ifndef ANIMATION_COMPRESSION_SCALE_ERROR
+#define ANIMATION_COMPRESSION_SCALE_ERROR 0.0005f // Default maximum difference between a compressed scale component and the original one
+#endif
+
+#ifndef ANIMATION_COMPRESSION_MAX_KEY_GAP
+#define ANIMATION_COMPRESSION_MAX_KEY_GAP 64 // Maximum number of frames between two keys kept by the key reduction
+#endif
+
+typedef struct AnimationPose
+{
+	Matrix3x4 *bones ; // Skinning matrix of each bone : from the bind pose to the animated pose, in model's space
+	int boneCount ;
+
+	// What was sampled (animation is NULL if nothing was) :
+
+	ModelAnimation *animation ;
+	int frame ;
+
+} AnimationPose;
+
+typedef struct SkinCacheStats
+{
+	int hits ;      // Poses found in the cache
+	int misses ;    // Poses skinned (not cached, or not cachable)
+	int unchanged ; // Draws whose meshes already held the pose : nothing was done
+	int evictions ; // Entries dropped to stay within the budget
+
+	int entries ;
+	size_t memory ; // Bytes of skinned vertices in the cache
+	size_t budget ;
+
+} SkinCacheStats;
+
+typedef struct SkinBatch SkinBatch ;
+
+// Track of a compressed animation clip :
+typedef struct AnimationTrack
+{
+	int keyCount ;  // 0 for a constant or raw track
+	int firstKey ;  // Index of its first key in the keys of the clip, or of its first value in the raw values
+	bool raw ;      // Not quantized : a value per frame
+	float value[4] ; // Constant value, or minimum of the quantized range of a translation or scale
+	float range[3] ; // Size of the quantized range of a translation or scale
+
+} AnimationTrack;
+
+typedef struct AnimationClip
+{
+	ModelAnimation *animation ; // Name, bones and frame count (its frame poses may be freed)
+	AnimationTrack *tracks ;    // Translation, rotation and scale of each bone (NULL if not compressed)
+	unsigned short *keyFrames ; // Frame of each key
+	unsigned short *keyValues ; // 3 quantized components of each key
+	int keyCount ;
+	float *rawValues ;          // 4 components per frame of the raw tracks
+	int rawCount ;
+
+} AnimationClip;
+
+typedef struct AnimationCompression
+{
+	bool enabled ;          // Used by the loaders only (see AnimationsListSetCompression())
+	bool reduceKeys ;       // Remove the keys that can be interpolated
+	float translationError ;
+	float rotationError ;   // In radians
+	float scaleError ;
+
+} AnimationCompression;
+
+typedef struct AnimationCompressionReport
+{
+	int clips ;
+	int tracks ;
+	int constantTracks ;
+	int rawTracks ;   // Kept raw, as their quantization exceeded the error bounds
+	int keys ;        // Keys of the animated tracks
+	int removedKeys ; // By the key reduction
+
+	size_t rawSize ;        // Bytes of the frame poses
+	size_t compressedSize ; // Bytes of the tracks and keys
+
+	float translationError ; // Maximum errors measured on all the frames
+	float rotationError ;
+	float scaleError ;
+
+} AnimationCompressionReport;
+
+
+#if defined(__cplusplus)
+extern "C" {            // Prevents name mangling of functions
+#endif
+
+RLAPI bool AnimationPoseSample( AnimationPose *pose , Model *model , ModelAnimation *animation , int frame ); // Compute the skinning matrices of the frame of the animation (frame is wrapped), unless the pose already holds them. Return true if sampled.
+#define SampleAnimationPose AnimationPoseSample
+RLAPI void AnimationPoseUnload( AnimationPose *pose ); // Free the matrices
+#define UnloadAnimationPose AnimationPoseUnload
+
+RLAPI void SkinVertices( const float *vertices , const float *normals , const unsigned char *boneIds , const float *boneWeights , const Matrix3x4 *bones , int boneCount , float *outVertices , float *outNormals , int vertexCount ); // Blend each vertex (and normal, unless NULL) by its 4 bones and weights (the bone ids must be lower than boneCount)
+
+RLAPI int ModelSkin( Model *model , AnimationPose *pose ); // Skin the meshes of the model with the pose (the bind pose if NULL) and upload them, unless they already hold it. Return how many meshes were skinned.
+#define SkinModel ModelSkin
+RLAPI void ModelForgetSkin( Model *model ); // Tell that the meshes were changed by something else (UpdateModelAnimation()...), or are about to be unloaded
+#define ForgetModelSkin ModelForgetSkin
+
+RLAPI void SkinCacheSetBudget( size_t budget ); // Maximum size of the skinned vertices kept by the cache, in bytes (0 disables the cache). Entries are dropped if needed.
+#define SetSkinCacheBudget SkinCacheSetBudget
+RLAPI void SkinCacheClear( void ); // Drop all the entries (required if an animation is unloaded while the models using it are not)
+#define ClearSkinCache SkinCacheClear
+RLAPI SkinCacheStats SkinCacheGetStats( void ); // Return the counters accumulated by ModelSkin(), and the current size of the cache
+#define GetSkinCacheStats SkinCacheGetStats
+RLAPI void SkinCacheResetStats( void );
+#define ResetSkinCacheStats SkinCacheResetStats
+
+RLAPI AnimationCompression AnimationCompressionDefaults( void ); // Return the default settings (see ANIMATION_COMPRESSION_*), enabled, with the key reduction
+RLAPI AnimationClip AnimationClipCompress( ModelAnimation *animation , AnimationCompression compression , AnimationCompressionReport *report ); // Compress the frame poses (kept) into a clip, and add its sizes and errors to the report (unless NULL)
+#define CompressAnimationClip AnimationClipCompress
+RLAPI void AnimationClipUnload( AnimationClip *clip ); // Free the tracks and keys (not the ModelAnimation)
+#define UnloadAnimationClip AnimationClipUnload
+RLAPI Transform AnimationClipSampleBone( const AnimationClip *clip , int frame , int bone ); // Decompress the transform of a bone on a frame (wrapped)
+#define SampleAnimationClipBone AnimationClipSampleBone
+RLAPI bool AnimationPoseSampleClip( AnimationPose *pose , Model *model , AnimationClip *clip , int frame ); // Same as AnimationPoseSample(), from a compressed clip
+#define SampleAnimationPoseClip AnimationPoseSampleClip
+
+RLAPI SkinBatch *SkinBatchCreate( void );
+#define CreateSkinBatch SkinBatchCreate
+RLAPI SkinBatch *SkinBatchRelease( SkinBatch *batch ); // Return NULL
+#define ReleaseSkinBatch SkinBatchRelease
+RLAPI bool SkinBatchAdd( SkinBatch *batch , Model *model , AnimationPose *pose ); // Queue the skinning of the pose into the cache, unless the meshes hold it, it is cached or queued already, or it doesn't fit. Return true if queued.
+#define AddSkinBatch SkinBatchAdd
+RLAPI int SkinBatchRun( SkinBatch *batch , WorkerPool *pool ); // Skin the queued poses on the pool (on the calling thread if NULL), and empty the batch. Return how many poses were skinned.
+#define RunSkinBatch SkinBatchRun
+
+#if defined(__cplusplus)
+}
+#endif
+
+#endif // RSKINNING_H
+
+#if defined(RSKINNING_IMPLEMENTATION)
+
+#include <string.h> // Required for: memcpy()
+#include <math.h>   // Required for: sqrtf(), asinf(), fabsf(), fminf(), fmaxf()
+
+#if defined(RFRUSTUM_SIMD_AVX2)
+	#include <immintrin.h>
+#elif defined(RFRUSTUM_SIMD_SSE)
+	#include <emmintrin.h>
+#elif defined(RFRUSTUM_SIMD_NEON)
+	#include <arm_neon.h>
+#endif
+
+// Pose held by the meshes of a model :
+// NOTE : the models are identified by their meshes, which are shared by the copies of a Model.
+typedef struct _SkinnedModel
+{
+	Mesh *meshes ;
+	ModelAnimation *animation ; // NULL for the bind pose
+	int frame ;
+
+} _SkinnedModel;
+
+_SkinnedModel *_skinnedModels = NULL ;
+int _skinnedModelsCount = 0 ;
+int _skinnedModelsCapacity = 0 ;
+
+// Skinned vertices of a (model, animation, frame) :
+typedef struct _SkinCacheEntry
+{
+	Mesh *meshes ;
+	ModelAnimation *animation ;
+	int frame ;
+
+	float *data ; // The vertices, then the normals, of each skinned mesh
+	size_t size ;
+
+	bool ready ;   // The data is skinned (entries being skinned are not evicted)
+	bool queued ;  // In a SkinBatch : pinned until it has run
+	bool dropped ; // Dropped while queued : not found anymore, not skinned by the batch, and freed after its run
+
+	int hashNext ; // Next entry of the bucket (or next free entry)
+	int lruPrev ;  // More recently used entry (-1 for the first one)
+	int lruNext ;  // Less recently used entry (-1 for the last one)
+
+} _SkinCacheEntry;
+
+typedef struct _SkinCache
+{
+	_SkinCacheEntry *entries ;
+	int entriesCapacity ;
+	int freeEntry ; // First of the free entries (-1 if none)
+
+	int *buckets ;  // First entry of each bucket (-1 if none)
+	int bucketsCount ; // Power of 2
+
+	int lruFirst ; // Most recently used
+	int lruLast ;  // Least recently used, dropped first
+
+	SkinCacheStats stats ;
+
+} _SkinCache;
+
+_SkinCache _skinCache = { NULL , 0 , -1 , NULL , 0 , -1 , -1 , { 0 , 0 , 0 , 0 , 0 , 0 , SKIN_CACHE_BUDGET } };
+
+// Vertices of a mesh to skin into a cache entry :
+typedef struct _SkinBatchRange
+{
+	int entry ;
+	Mesh *mesh ;
+	const Matrix3x4 *bones ;
+	int boneCount ;
+
+	int first ;
+	int count ;
+
+	float *outVertices ; // Skinned vertices of the mesh in the entry (from its first vertex)
+	float *outNormals ;  // NULL without normals
+
+} _SkinBatchRange;
+
+struct SkinBatch
+{
+	int *entries ; // Queued cache entries
+	int entriesCount ;
+	int entriesCapacity ;
+
+	_SkinBatchRange *ranges ;
+	int rangesCount ;
+	int rangesCapacity ;
+
+	bool warned ; // A pose didn't fit in the cache
+};
+
+_SkinnedModel *_SkinnedModelFind( Mesh *meshes , bool create );
+size_t _SkinCacheModelSize( Model *model );
+unsigned int _SkinCacheHash( Mesh *meshes , ModelAnimation *animation , int frame );
+void _SkinCacheRemove( int e );
+void _SkinCacheDrop( int e );
+void _SkinCacheTrim( void );
+int _SkinCacheGet( Model *model , ModelAnimation *animation , int frame );
+
+void _SkinBatchJob( void *userData , int first , int count );
+
+bool _AnimationPosePrepare( AnimationPose *pose , Model *model , ModelAnimation *animation , int *frame );
+void _AnimationPoseSetBone( Matrix3x4 *m , Transform bind , Transform anim );
+void _AnimationQuaternionEncode( Quaternion q , unsigned short *values );
+Quaternion _AnimationQuaternionDecode( const unsigned short *values );
+void _AnimationKeyDecode( const AnimationClip *clip , const AnimationTrack *track , bool rotation , int key , float *result );
+void _AnimationTrackSample( const AnimationClip *clip , const AnimationTrack *track , bool rotation , int frame , float *result );
+Transform _AnimationClipSampleBone( const AnimationClip *clip , int frame , int bone );
+float _AnimationTrackError( int type , const float *a , const float *b );
+bool _AnimationSegmentFits( int type , const float *values , int k , int e , float bound );
+bool _AnimationTrackFits( const AnimationClip *clip , const AnimationTrack *track , int type , const float *values , float bound );
+
+// Check the animation against the model, wrap the frame, and size the pose.
+// Return false if the pose can't be sampled, or already holds the frame.
+bool _AnimationPosePrepare( AnimationPose *pose , Model *model , ModelAnimation *animation , int *frame )
+{
+	if ( model == NULL || animation == NULL || animation->frameCount <= 0 || model->bindPose == NULL ) return false ;
+
+	if ( animation->boneCount != model->boneCount )
+	{
+		TRACELOG( LOG_WARNING , "SKINNING: Animation `%s` has %d bones, but the model has %d." , animation->name , animation->boneCount , model->boneCount );
+		return false ;
+	}
+
+	*frame = *frame < 0 ? 0 : *frame % animation->frameCount ;
+
+	if ( pose->animation == animation && pose->frame == *frame && pose->boneCount == model->boneCount ) return false ;
+
+	if ( pose->boneCount != model->boneCount )
+	{
+		pose->bones = (Matrix3x4*)MemRealloc( pose->bones , sizeof( Matrix3x4 )*model->boneCount );
+		pose->boneCount = model->boneCount ;
+	}
+
+	return true ;
+}
+
+// Same as UpdateModelAnimation() : v' = rotation*( scale*( v - bindTranslation ) ) + translation
+// with rotation = animRotation*inverse( bindRotation ), so each bone is a single affine matrix.
+void _AnimationPoseSetBone( Matrix3x4 *m , Transform bind , Transform anim )
+{
+	Matrix rotation = QuaternionToMatrix( QuaternionMultiply( anim.rotation , QuaternionInvert( bind.rotation ) ) );
+
+	m->m0 = rotation.m0*anim.scale.x ; m->m4 = rotation.m4*anim.scale.y ; m->m8  = rotation.m8*anim.scale.z ;
+	m->m1 = rotation.m1*anim.scale.x ; m->m5 = rotation.m5*anim.scale.y ; m->m9  = rotation.m9*anim.scale.z ;
+	m->m2 = rotation.m2*anim.scale.x ; m->m6 = rotation.m6*anim.scale.y ; m->m10 = rotation.m10*anim.scale.z ;
+
+	m->m12 = anim.translation.x - ( m->m0*bind.translation.x + m->m4*bind.translation.y + m->m8*bind.translation.z );
+	m->m13 = anim.translation.y - ( m->m1*bind.translation.x + m->m5*bind.translation.y + m->m9*bind.translation.z );
+	m->m14 = anim.translation.z - ( m->m2*bind.translation.x + m->m6*bind.translation.y + m->m10*bind.translation.z );
+}
+
+bool AnimationPoseSample( AnimationPose *pose , Model *model , ModelAnimation *animation , int frame )
+{
+	if ( animation == NULL || animation->framePoses == NULL ) return false ;
+
+	if ( ! _AnimationPosePrepare( pose , model , animation , &frame ) ) return false ;
+
+	// NOTE : the frame poses of a compressed animation may be freed (see AnimationPoseSampleClip()).
+
+	if ( animation->framePoses[ frame ] == NULL ) return false ;
+
+	for( int b = 0 ; b < pose->boneCount ; b++ )
+	{
+		_AnimationPoseSetBone( &pose->bones[b] , model->bindPose[b] , animation->framePoses[ frame ][b] );
+	}
+
+	pose->animation = animation ;
+	pose->frame = frame ;
+
+	return true ;
+}
+
+bool AnimationPoseSampleClip( AnimationPose *pose , Model *model , AnimationClip *clip , int frame )
+{
+	if ( clip == NULL ) return false ;
+
+	if ( clip->tracks == NULL ) return AnimationPoseSample( pose , model , clip->animation , frame );
+
+	if ( ! _AnimationPosePrepare( pose , model , clip->animation , &frame ) ) return false ;
+
+	for( int b = 0 ; b < pose->boneCount ; b++ )
+	{
+		_AnimationPoseSetBone( &pose->bones[b] , model->bindPose[b] , _AnimationClipSampleBone( clip , frame , b ) );
+	}
+
+	pose->animation = clip->animation ;
+	pose->frame = frame ;
+
+	return true ;
+}
+
+void AnimationPoseUnload( AnimationPose *pose )
+{
+	MemFree( pose->bones );
+
+	*pose = (AnimationPose){ 0 };
+}
+
+AnimationCompression AnimationCompressionDefaults( void )
+{
+	AnimationCompression compression ;
+
+	compression.enabled = true ;
+	compression.reduceKeys = true ;
+	compression.translationError = ANIMATION_COMPRESSION_TRANSLATION_ERROR ;
+	compression.rotationError = ANIMATION_COMPRESSION_ROTATION_ERROR ;
+	compression.scaleError = ANIMATION_COMPRESSION_SCALE_ERROR ;
+
+	return compression ;
+}
+
+// Smallest three : the largest component is made positive and dropped, so the 3 others are within +/- 1/sqrt(2).
+// They are stored on the 15 high bits of each value, and the index of the largest one on the low bits of the 2 first.
+void _AnimationQuaternionEncode( Quaternion q , unsigned short *values )
+{
+	float c[4] = { q.x , q.y , q.z , q.w };
+
+	int largest = 0 ;
+
+	for( int i = 1 ; i < 4 ; i++ )
+	{
+		if ( fabsf( c[i] ) > fabsf( c[ largest ] ) ) largest = i ;
+	}
+
+	float sign = c[ largest ] < 0.0f ? -1.0f : 1.0f ;
+
+	for( int i = 0 , j = 0 ; i < 4 ; i++ )
+	{
+		if ( i == largest ) continue ;
+
+		float v = Clamp( sign*c[i]*1.41421356f*0.5f + 0.5f , 0.0f , 1.0f );
+
+		values[j] = (unsigned short)( ( (unsigned int)( v*32767.0f + 0.5f ) << 1 ) | ( ( largest >> j ) & 1 ) );
+		j++ ;
+	}
+}
+
+Quaternion _AnimationQuaternionDecode( const unsigned short *values )
+{
+	int largest = ( values[0] & 1 ) | ( ( values[1] & 1 ) << 1 );
+
+	float c[4] ;
+	float sum = 0.0f ;
+
+	for( int i = 0 , j = 0 ; i < 4 ; i++ )
+	{
+		if ( i == largest ) continue ;
+
+		c[i] = ( (float)( values[j] >> 1 )*( 2.0f/32767.0f ) - 1.0f )*0.70710678f ;
+		sum += c[i]*c[i] ;
+		j++ ;
+	}
+
+	c[ largest ] = sqrtf( fmaxf( 0.0f , 1.0f - sum ) );
+
+	return (Quaternion){ c[0] , c[1] , c[2] , c[3] };
+}
+
+// Decompress a key : a rotation, or the 3 components of a translation or scale.
+void _AnimationKeyDecode( const AnimationClip *clip , const AnimationTrack *track , bool rotation , int key , float *result )
+{
+	const unsigned short *values = &clip->keyValues[ 3*key ] ;
+
+	if ( rotation )
+	{
+		Quaternion q = _AnimationQuaternionDecode( values );
+
+		result[0] = q.x ; result[1] = q.y ; result[2] = q.z ; result[3] = q.w ;
+	}
+	else
+	{
+		for( int c = 0 ; c < 3 ; c++ ) result[c] = track->value[c] + track->range[c]*( (float)values[c]*( 1.0f/65535.0f ) );
+	}
+}
+
+// Decompress a track on a frame (already wrapped) : the keys around it are interpolated, linearly for a translation
+// or scale, and normalized linearly for a rotation.
+void _AnimationTrackSample( const AnimationClip *clip , const AnimationTrack *track , bool rotation , int frame , float *result )
+{
+	if ( track->raw )
+	{
+		for( int c = 0 ; c < 4 ; c++ ) result[c] = clip->rawValues[ 4*( track->firstKey + frame ) + c ] ;
+		return ;
+	}
+
+	if ( track->keyCount == 0 )
+	{
+		for( int c = 0 ; c < 4 ; c++ ) result[c] = track->value[c] ;
+		return ;
+	}
+
+	const unsigned short *frames = &clip->keyFrames[ track->firstKey ] ;
+
+	// Last key at or before the frame :
+	// NOTE : a track that was not reduced has a key per frame.
+
+	int k = 0 ;
+
+	if ( track->keyCount == clip->animation->frameCount )
+	{
+		k = frame ;
+	}
+	else
+	{
+		int high = track->keyCount - 1 ;
+
+		while( k < high )
+		{
+			int middle = ( k + high + 1 )/2 ;
+
+			if ( frames[ middle ] <= frame ) k = middle ;
+			else high = middle - 1 ;
+		}
+	}
+
+	_AnimationKeyDecode( clip , track , rotation , track->firstKey + k , result );
+
+	if ( frames[k] == frame || k == track->keyCount - 1 ) return ;
+
+	float next[4] ;
+
+	_AnimationKeyDecode( clip , track , rotation , track->firstKey + k + 1 , next );
+
+	float t = (float)( frame - frames[k] )/(float)( frames[ k + 1 ] - frames[k] );
+
+	if ( rotation )
+	{
+		float sign = result[0]*next[0] + result[1]*next[1] + result[2]*next[2] + result[3]*next[3] < 0.0f ? -1.0f : 1.0f ;
+		float length = 0.0f ;
+
+		for( int c = 0 ; c < 4 ; c++ )
+		{
+			result[c] += ( sign*next[c] - result[c] )*t ;
+			length += result[c]*result[c] ;
+		}
+
+		length = 1.0f/sqrtf( length );
+
+		for( int c = 0 ; c < 4 ; c++ ) result[c] *= length ;
+	}
+	else
+	{
+		for( int c = 0 ; c < 3 ; c++ ) result[c] += ( next[c] - result[c] )*t ;
+	}
+}
+
+Transform _AnimationClipSampleBone( const AnimationClip *clip , int frame , int bone )
+{
+	const AnimationTrack *tracks = &clip->tracks[ 3*bone ] ;
+
+	float translation[4] , rotation[4] , scale[4] ;
+
+	_AnimationTrackSample( clip , &tracks[0] , false , frame , translation );
+	_AnimationTrackSample( clip , &tracks[1] , true , frame , rotation );
+	_AnimationTrackSample( clip , &tracks[2] , false , frame , scale );
+
+	return (Transform){ { translation[0] , translation[1] , translation[2] } , { rotation[0] , rotation[1] , rotation[2] , rotation[3] } , { scale[0] , scale[1] , scale[2] } };
+}
+
+Transform AnimationClipSampleBone( const AnimationClip *clip , int frame , int bone )
+{
+	ModelAnimation *animation = clip->animation ;
+
+	frame = frame < 0 ? 0 : frame % animation->frameCount ;
+
+	if ( clip->tracks == NULL ) return animation->framePoses[ frame ][ bone ] ;
+
+	return _AnimationClipSampleBone( clip , frame , bone );
+}
+
+// Error between two values of a track : a distance for a translation, an angle for a rotation, the largest difference
+// of the components for a scale.
+float _AnimationTrackError( int type , const float *a , const float *b )
+{
+	if ( type == 1 )
+	{
+		// NOTE : from the chord between the quaternions, as acosf() of their dot product is too coarse near 1.
+
+		float sign = a[0]*b[0] + a[1]*b[1] + a[2]*b[2] + a[3]*b[3] < 0.0f ? -1.0f : 1.0f ;
+		float chord = 0.0f ;
+
+		for( int c = 0 ; c < 4 ; c++ ) chord += ( a[c] - sign*b[c] )*( a[c] - sign*b[c] );
+
+		return 4.0f*asinf( fminf( 0.5f*sqrtf( chord ) , 1.0f ) );
+	}
+
+	float dx = a[0] - b[0] , dy = a[1] - b[1] , dz = a[2] - b[2] ;
+
+	if ( type == 0 ) return sqrtf( dx*dx + dy*dy + dz*dz );
+
+	return fmaxf( fabsf( dx ) , fmaxf( fabsf( dy ) , fabsf( dz ) ) );
+}
+
+// True if the frames between the keys k and e are interpolated within the error bound.
+bool _AnimationSegmentFits( int type , const float *values , int k , int e , float bound )
+{
+	for( int f = k + 1 ; f < e ; f++ )
+	{
+		float t = (float)( f - k )/(float)( e - k );
+		float v[4] ;
+		float length = 0.0f ;
+
+		for( int c = 0 ; c < 4 ; c++ )
+		{
+			v[c] = values[ 4*k + c ] + ( values[ 4*e + c ] - values[ 4*k + c ] )*t ;
+			length += v[c]*v[c] ;
+		}
+
+		if ( type == 1 )
+		{
+			length = 1.0f/sqrtf( length );
+			for( int c = 0 ; c < 4 ; c++ ) v[c] *= length ;
+		}
+
+		if ( _AnimationTrackError( type , v , &values[ 4*f ] ) > bound ) return false ;
+	}
+
+	return true ;
+}
+
+// True if every frame of the track, decoded from the clip, is within the error bound.
+bool _AnimationTrackFits( const AnimationClip *clip , const AnimationTrack *track , int type , const float *values , float bound )
+{
+	for( int f = 0 ; f < clip->animation->frameCount ; f++ )
+	{
+		float v[4] ;
+
+		_AnimationTrackSample( clip , track , type == 1 , f , v );
+
+		if ( !( _AnimationTrackError( type , v , &values[ 4*f ] ) <= bound ) ) return false ;
+	}
+
+	return true ;
+}
+
+AnimationClip AnimationClipCompress( ModelAnimation *animation , AnimationCompression compression , AnimationCompressionReport *report )
+{
+	AnimationClip clip = { 0 };
+
+	clip.animation = animation ;
+
+	if ( animation == NULL || animation->framePoses == NULL || animation->frameCount <= 0 || animation->boneCount <= 0 ) return clip ;
+
+	int frameCount = animation->frameCount ;
+	int boneCount = animation->boneCount ;
+
+	if ( frameCount > 65536 )
+	{
+		TRACELOG( LOG_WARNING , "SKINNING: Animation `%s` has too many frames (%d) to be compressed." , animation->name , frameCount );
+		return clip ;
+	}
+
+	for( int f = 0 ; f < frameCount ; f++ )
+	{
+		if ( animation->framePoses[f] == NULL ) return clip ; // Compressed already
+	}
+
+	float bounds[3] = { compression.translationError , compression.rotationError , compression.scaleError };
+
+	clip.tracks = (AnimationTrack*)MemAlloc( sizeof( AnimationTrack )*3*boneCount );
+
+	// Worst case, every frame of every track is a key : shrunk at the end.
+
+	clip.keyFrames = (unsigned short*)MemAlloc( sizeof( unsigned short )*3*boneCount*frameCount );
+	clip.keyValues = (unsigned short*)MemAlloc( sizeof( unsigned short )*9*boneCount*frameCount );
+
+	float *values = (float*)MemAlloc( sizeof( float )*4*frameCount ); // Values of a track, 4 per frame
+	int *keys = (int*)MemAlloc( sizeof( int )*frameCount );
+
+	int constantTracks = 0 ;
+	int rawTracks = 0 ;
+
+	for( int b = 0 ; b < boneCount ; b++ )
+	{
+		for( int type = 0 ; type < 3 ; type++ ) // Translation, rotation, scale
+		{
+			AnimationTrack *track = &clip.tracks[ 3*b + type ] ;
+
+			for( int f = 0 ; f < frameCount ; f++ )
+			{
+				Transform pose = animation->framePoses[f][b] ;
+				float *v = &values[ 4*f ] ;
+
+				if ( type == 1 )
+				{
+					Quaternion q = QuaternionNormalize( pose.rotation );
+
+					// Same hemisphere as the previous frame, for the interpolation :
+
+					if ( f > 0 && q.x*v[-4] + q.y*v[-3] + q.z*v[-2] + q.w*v[-1] < 0.0f ) q = (Quaternion){ -q.x , -q.y , -q.z , -q.w };
+
+					v[0] = q.x ; v[1] = q.y ; v[2] = q.z ; v[3] = q.w ;
+				}
+				else
+				{
+					Vector3 u = type == 0 ? pose.translation : pose.scale ;
+
+					v[0] = u.x ; v[1] = u.y ; v[2] = u.z ; v[3] = 0.0f ;
+				}
+			}
+
+			// Constant track :
+
+			bool constant = true ;
+
+			for( int f = 1 ; f < frameCount && constant ; f++ ) constant = _AnimationTrackError( type , &values[0] , &values[ 4*f ] ) <= bounds[ type ] ;
+
+			if ( constant )
+			{
+				for( int c = 0 ; c < 4 ; c++ ) track->value[c] = values[c] ;
+				for( int c = 0 ; c < 3 ; c++ ) track->range[c] = 0.0f ;
+
+				track->keyCount = 0 ;
+				track->firstKey = 0 ;
+				track->raw = false ;
+
+				constantTracks++ ;
+				continue ;
+			}
+
+			// Quantized range of a translation or scale :
+
+			if ( type != 1 )
+			{
+				for( int c = 0 ; c < 3 ; c++ )
+				{
+					float min = values[c] , max = values[c] ;
+
+					for( int f = 1 ; f < frameCount ; f++ )
+					{
+						min = fminf( min , values[ 4*f + c ] );
+						max = fmaxf( max , values[ 4*f + c ] );
+					}
+
+					track->value[c] = min ;
+					track->range[c] = max - min ;
+				}
+
+				track->value[3] = 0.0f ;
+			}
+
+			// The interpolated keys are quantized afterwards : the reduction leaves room for the quantization error
+			// (half a step on each component, about 1e-4 radians for a rotation).
+
+			float bound = bounds[ type ] ;
+
+			if ( type == 1 ) bound -= 1.1e-4f ;
+			else
+			{
+				float step = 0.0f ;
+
+				for( int c = 0 ; c < 3 ; c++ ) step += ( 0.5f*track->range[c]/65535.0f )*( 0.5f*track->range[c]/65535.0f );
+
+				bound -= type == 0 ? sqrtf( step ) : 0.5f*fmaxf( track->range[0] , fmaxf( track->range[1] , track->range[2] ) )/65535.0f ;
+			}
+
+			// Keys : the first and last frames, and those that can't be interpolated from the previous key and a further one.
+			// NOTE : greedy, and limited to ANIMATION_COMPRESSION_MAX_KEY_GAP frames between keys, so it stays linear.
+			// The room left for the quantization is an estimate, so the decoded track is checked : it is encoded again
+			// without the reduction if it doesn't fit, and kept raw if it still doesn't.
+
+			bool reduce = compression.reduceKeys && bound > 0.0f ;
+
+			track->raw = false ;
+			track->firstKey = clip.keyCount ;
+
+			for( ;; )
+			{
+				int keyCount = 0 ;
+
+				keys[ keyCount++ ] = 0 ;
+
+				for( int k = 0 ; k < frameCount - 1 ; )
+				{
+					int e = k + 1 ;
+
+					if ( reduce )
+					{
+						while( e + 1 < frameCount && e + 1 - k <= ANIMATION_COMPRESSION_MAX_KEY_GAP && _AnimationSegmentFits( type , values , k , e + 1 , bound ) ) e++ ;
+					}
+
+					keys[ keyCount++ ] = e ;
+					k = e ;
+				}
+
+				track->keyCount = keyCount ;
+				clip.keyCount = track->firstKey ;
+
+				for( int i = 0 ; i < keyCount ; i++ )
+				{
+					const float *v = &values[ 4*keys[i] ] ;
+					unsigned short *quantized = &clip.keyValues[ 3*clip.keyCount ] ;
+
+					clip.keyFrames[ clip.keyCount ] = (unsigned short)keys[i] ;
+
+					if ( type == 1 )
+					{
+						_AnimationQuaternionEncode( (Quaternion){ v[0] , v[1] , v[2] , v[3] } , quantized );
+					}
+					else
+					{
+						for( int c = 0 ; c < 3 ; c++ )
+						{
+							float u = track->range[c] > 0.0f ? ( v[c] - track->value[c] )/track->range[c] : 0.0f ;
+
+							quantized[c] = (unsigned short)( Clamp( u , 0.0f , 1.0f )*65535.0f + 0.5f );
+						}
+					}
+
+					clip.keyCount++ ;
+				}
+
+				if ( _AnimationTrackFits( &clip , track , type , values , bounds[ type ] ) ) break ;
+
+				if ( reduce && keyCount < frameCount )
+				{
+					reduce = false ;
+					continue ;
+				}
+
+				// Raw :
+
+				clip.keyCount = track->firstKey ;
+				clip.rawValues = (float*)MemRealloc( clip.rawValues , sizeof( float )*4*( clip.rawCount + frameCount ) );
+
+				memcpy( &clip.rawValues[ 4*clip.rawCount ] , values , sizeof( float )*4*frameCount );
+
+				track->keyCount = 0 ;
+				track->firstKey = clip.rawCount ;
+				track->raw = true ;
+
+				clip.rawCount += frameCount ;
+				rawTracks++ ;
+				break ;
+			}
+		}
+	}
+
+	MemFree( values );
+	MemFree( keys );
+
+	clip.keyFrames = (unsigned short*)MemRealloc( clip.keyFrames , sizeof( unsigned short )*( clip.keyCount > 0 ? clip.keyCount : 1 ) );
+	clip.keyValues = (unsigned short*)MemRealloc( clip.keyValues , sizeof( unsigned short )*3*( clip.keyCount > 0 ? clip.keyCount : 1 ) );
+
+	if ( report != NULL )
+	{
+		int tracks = 3*boneCount ;
+
+		report->clips++ ;
+		report->tracks += tracks ;
+		report->constantTracks += constantTracks ;
+		report->rawTracks += rawTracks ;
+		report->keys += clip.keyCount ;
+		report->removedKeys += ( tracks - constantTracks - rawTracks )*frameCount - clip.keyCount ;
+
+		report->rawSize += sizeof( Transform )*boneCount*frameCount ;
+		report->compressedSize += sizeof( AnimationTrack )*tracks + ( sizeof( unsigned short )*4 )*clip.keyCount + sizeof( float )*4*clip.rawCount ;
+
+		// Measured on every frame, quantization included :
+
+		for( int f = 0 ; f < frameCount ; f++ )
+		{
+			for( int b = 0 ; b < boneCount ; b++ )
+			{
+				Transform raw = animation->framePoses[f][b] ;
+				Transform decoded = _AnimationClipSampleBone( &clip , f , b );
+
+				Quaternion q = QuaternionNormalize( raw.rotation );
+
+				float a[4] = { q.x , q.y , q.z , q.w };
+				float d[4] = { decoded.rotation.x , decoded.rotation.y , decoded.rotation.z , decoded.rotation.w };
+
+				report->translationError = fmaxf( report->translationError , Vector3Distance( raw.translation , decoded.translation ) );
+				report->rotationError = fmaxf( report->rotationError , _AnimationTrackError( 1 , a , d ) );
+				report->scaleError = fmaxf( report->scaleError , _AnimationTrackError( 2 , &raw.scale.x , &decoded.scale.x ) );
+			}
+		}
+	}
+
+	return clip ;
+}
+
+void AnimationClipUnload( AnimationClip *clip )
+{
+	MemFree( clip->tracks );
+	MemFree( clip->keyFrames );
+	MemFree( clip->keyValues );
+	MemFree( clip->rawValues );
+
+	*clip = (AnimationClip){ 0 };
+}
+
+// NOTE : the columns of the bones are blended first, C = sum of w*column, then each vertex is transformed once :
+// v' = C0*x + C1*y + C2*z + C3 and n' = C0*nx + C1*ny + C2*nz. The SIMD versions do the same operations on the
+// 4 components of the columns at once, and the AVX2 version on two vertices at once, one in each 128 bits lane.
+// The outputs must not overlap the inputs.
+void SkinVertices( const float *vertices , const float *normals , const unsigned char *boneIds , const float *boneWeights , const Matrix3x4 *bones , int boneCount , float *outVertices , float *outNormals , int vertexCount )
+{
+	// Columns of the bones : the 3x3 part, then the translation, with a 4th component of 0.
+	// NOTE : the bone ids are bytes, so there are 256 bones at most.
+
+	float columns[ 16*256 ] ;
+
+	if ( boneCount > 256 ) boneCount = 256 ;
+
+	for( int b = 0 ; b < boneCount ; b++ )
+	{
+		const Matrix3x4 *m = &bones[b] ;
+		float *c = &columns[ 16*b ] ;
+
+		c[0]  = m->m0  ; c[1]  = m->m1  ; c[2]  = m->m2  ; c[3]  = 0.0f ;
+		c[4]  = m->m4  ; c[5]  = m->m5  ; c[6]  = m->m6  ; c[7]  = 0.0f ;
+		c[8]  = m->m8  ; c[9]  = m->m9  ; c[10] = m->m10 ; c[11] = 0.0f ;
+		c[12] = m->m12 ; c[13] = m->m13 ; c[14] = m->m14 ; c[15] = 0.0f ;
+	}
+
+	int i = 0 ;
+
+#if defined(RFRUSTUM_SIMD_AVX2)
+
+	// Two vertices per instruction (same operations as the SSE version below) :
+	// NOTE : the stores of 4 floats write the first component of the next vertex, so the last vertex is left to the loop below.
+
+	for( ; i + 2 < vertexCount ; i += 2 )
+	{
+		__m256 c0 = _mm256_setzero_ps();
+		__m256 c1 = _mm256_setzero_ps();
+		__m256 c2 = _mm256_setzero_ps();
+		__m256 c3 = _mm256_setzero_ps();
+
+		for( int j = 0 ; j < 4 ; j++ )
+		{
+			float w0 = boneWeights[ 4*i + j ] ;
+			float w1 = boneWeights[ 4*i + 4 + j ] ;
+
+			if ( w0 == 0.0f && w1 == 0.0f ) continue ;
+
+			// NOTE : the bone of a zero weight may not exist, so the bone of the other vertex is used, times 0.
+
+			const float *column0 = &columns[ 16*boneIds[ 4*( w0 != 0.0f ? i : i + 1 ) + j ] ] ;
+			const float *column1 = &columns[ 16*boneIds[ 4*( w1 != 0.0f ? i + 1 : i ) + j ] ] ;
+
+			__m256 weight = _mm256_insertf128_ps( _mm256_castps128_ps256( _mm_set1_ps( w0 ) ) , _mm_set1_ps( w1 ) , 1 );
+
+			c0 = _mm256_add_ps( c0 , _mm256_mul_ps( weight , _mm256_insertf128_ps( _mm256_castps128_ps256( _mm_loadu_ps( column0 + 0 ) ) , _mm_loadu_ps( column1 + 0 ) , 1 ) ) );
+			c1 = _mm256_add_ps( c1 , _mm256_mul_ps( weight , _mm256_insertf128_ps( _mm256_castps128_ps256( _mm_loadu_ps( column0 + 4 ) ) , _mm_loadu_ps( column1 + 4 ) , 1 ) ) );
+			c2 = _mm256_add_ps( c2 , _mm256_mul_ps( weight , _mm256_insertf128_ps( _mm256_castps128_ps256( _mm_loadu_ps( column0 + 8 ) ) , _mm_loadu_ps( column1 + 8 ) , 1 ) ) );
+			c3 = _mm256_add_ps( c3 , _mm256_mul_ps( weight , _mm256_insertf128_ps( _mm256_castps128_ps256( _mm_loadu_ps( column0 + 12 ) ) , _mm_loadu_ps( column1 + 12 ) , 1 ) ) );
+		}
+
+		const float *v = &vertices[ 3*i ] ;
+
+		__m256 x = _mm256_insertf128_ps( _mm256_castps128_ps256( _mm_set1_ps( v[0] ) ) , _mm_set1_ps( v[3] ) , 1 );
+		__m256 y = _mm256_insertf128_ps( _mm256_castps128_ps256( _mm_set1_ps( v[1] ) ) , _mm_set1_ps( v[4] ) , 1 );
+		__m256 z = _mm256_insertf128_ps( _mm256_castps128_ps256( _mm_set1_ps( v[2] ) ) , _mm_set1_ps( v[5] ) , 1 );
+
+		__m256 result = _mm256_add_ps( _mm256_add_ps( _mm256_add_ps( _mm256_mul_ps( c0 , x ) , _mm256_mul_ps( c1 , y ) ) , _mm256_mul_ps( c2 , z ) ) , c3 );
+
+		_mm_storeu_ps( &outVertices[ 3*i ] , _mm256_castps256_ps128( result ) );
+		_mm_storeu_ps( &outVertices[ 3*i + 3 ] , _mm256_extractf128_ps( result , 1 ) );
+
+		if ( normals != NULL )
+		{
+			const float *n = &normals[ 3*i ] ;
+
+			x = _mm256_insertf128_ps( _mm256_castps128_ps256( _mm_set1_ps( n[0] ) ) , _mm_set1_ps( n[3] ) , 1 );
+			y = _mm256_insertf128_ps( _mm256_castps128_ps256( _mm_set1_ps( n[1] ) ) , _mm_set1_ps( n[4] ) , 1 );
+			z = _mm256_insertf128_ps( _mm256_castps128_ps256( _mm_set1_ps( n[2] ) ) , _mm_set1_ps( n[5] ) , 1 );
+
+			result = _mm256_add_ps( _mm256_add_ps( _mm256_mul_ps( c0 , x ) , _mm256_mul_ps( c1 , y ) ) , _mm256_mul_ps( c2 , z ) );
+
+			_mm_storeu_ps( &outNormals[ 3*i ] , _mm256_castps256_ps128( result ) );
+			_mm_storeu_ps( &outNormals[ 3*i + 3 ] , _mm256_extractf128_ps( result , 1 ) );
+		}
+	}
+
+#endif
+
+	for( ; i < vertexCount ; i++ )
+	{
+		const float *v = &vertices[ 3*i ] ;
+		const float *n = normals != NULL ? &normals[ 3*i ] : NULL ;
+
+		// NOTE : the SIMD versions store 4 floats, so the last vertex goes through a temporary (the next one, if
+		// any, belongs to another range of vertices, possibly skinned by another thread).
+
+		bool last = i == vertexCount - 1 ;
+		float lastVertex[4] , lastNormal[4] ;
+
+		float *outVertex = last ? lastVertex : &outVertices[ 3*i ] ;
+		float *outNormal = last ? lastNormal : ( n != NULL ? &outNormals[ 3*i ] : NULL );
+
+#if defined(RFRUSTUM_SIMD_SSE)
+
+		__m128 c0 = _mm_setzero_ps();
+		__m128 c1 = _mm_setzero_ps();
+		__m128 c2 = _mm_setzero_ps();
+		__m128 c3 = _mm_setzero_ps();
+
+		for( int j = 0 ; j < 4 ; j++ )
+		{
+			float w = boneWeights[ 4*i + j ] ;
+
+			if ( w == 0.0f ) continue ;
+
+			const float *column = &columns[ 16*boneIds[ 4*i + j ] ] ;
+			__m128 weight = _mm_set1_ps( w );
+
+			c0 = _mm_add_ps( c0 , _mm_mul_ps( weight , _mm_loadu_ps( column + 0 ) ) );
+			c1 = _mm_add_ps( c1 , _mm_mul_ps( weight , _mm_loadu_ps( column + 4 ) ) );
+			c2 = _mm_add_ps( c2 , _mm_mul_ps( weight , _mm_loadu_ps( column + 8 ) ) );
+			c3 = _mm_add_ps( c3 , _mm_mul_ps( weight , _mm_loadu_ps( column + 12 ) ) );
+		}
+
+		_mm_storeu_ps( outVertex , _mm_add_ps( _mm_add_ps( _mm_add_ps(
+			_mm_mul_ps( c0 , _mm_set1_ps( v[0] ) ) ,
+			_mm_mul_ps( c1 , _mm_set1_ps( v[1] ) ) ) ,
+			_mm_mul_ps( c2 , _mm_set1_ps( v[2] ) ) ) ,
+			c3 ) );
+
+		if ( n != NULL )
+		{
+			_mm_storeu_ps( outNormal , _mm_add_ps( _mm_add_ps(
+				_mm_mul_ps( c0 , _mm_set1_ps( n[0] ) ) ,
+				_mm_mul_ps( c1 , _mm_set1_ps( n[1] ) ) ) ,
+				_mm_mul_ps( c2 , _mm_set1_ps( n[2] ) ) ) );
+		}
+
+#elif defined(RFRUSTUM_SIMD_NEON)
+
+		float32x4_t c0 = vdupq_n_f32( 0.0f );
+		float32x4_t c1 = vdupq_n_f32( 0.0f );
+		float32x4_t c2 = vdupq_n_f32( 0.0f );
+		float32x4_t c3 = vdupq_n_f32( 0.0f );
+
+		for( int j = 0 ; j < 4 ; j++ )
+		{
+			float w = boneWeights[ 4*i + j ] ;
+
+			if ( w == 0.0f ) continue ;
+
+			const float *column = &columns[ 16*boneIds[ 4*i + j ] ] ;
+			float32x4_t weight = vdupq_n_f32( w );
+
+			c0 = vaddq_f32( c0 , vmulq_f32( weight , vld1q_f32( column + 0 ) ) );
+			c1 = vaddq_f32( c1 , vmulq_f32( weight , vld1q_f32( column + 4 ) ) );
+			c2 = vaddq_f32( c2 , vmulq_f32( weight , vld1q_f32( column + 8 ) ) );
+			c3 = vaddq_f32( c3 , vmulq_f32( weight , vld1q_f32( column + 12 ) ) );
+		}
+
+		vst1q_f32( outVertex , vaddq_f32( vaddq_f32( vaddq_f32(
+			vmulq_f32( c0 , vdupq_n_f32( v[0] ) ) ,
+			vmulq_f32( c1 , vdupq_n_f32( v[1] ) ) ) ,
+			vmulq_f32( c2 , vdupq_n_f32( v[2] ) ) ) ,
+			c3 ) );
+
+		if ( n != NULL )
+		{
+			vst1q_f32( outNormal , vaddq_f32( vaddq_f32(
+				vmulq_f32( c0 , vdupq_n_f32( n[0] ) ) ,
+				vmulq_f32( c1 , vdupq_n_f32( n[1] ) ) ) ,
+				vmulq_f32( c2 , vdupq_n_f32( n[2] ) ) ) );
+		}
+
+#else
+
+		float c[16] = { 0.0f };
+
+		for( int j = 0 ; j < 4 ; j++ )
+		{
+			float w = boneWeights[ 4*i + j ] ;
+
+			if ( w == 0.0f ) continue ;
+
+			const float *column = &columns[ 16*boneIds[ 4*i + j ] ] ;
+
+			for( int k = 0 ; k < 16 ; k++ ) c[k] += w*column[k] ;
+		}
+
+		for( int k = 0 ; k < 3 ; k++ ) outVertex[k] = c[k]*v[0] + c[ 4 + k ]*v[1] + c[ 8 + k ]*v[2] + c[ 12 + k ] ;
+
+		if ( n != NULL )
+		{
+			for( int k = 0 ; k < 3 ; k++ ) outNormal[k] = c[k]*n[0] + c[ 4 + k ]*n[1] + c[ 8 + k ]*n[2] ;
+		}
+
+#endif
+
+		if ( last )
+		{
+			memcpy( &outVertices[ 3*i ] , lastVertex , sizeof( float )*3 );
+			if ( n != NULL ) memcpy( &outNormals[ 3*i ] , lastNormal , sizeof( float )*3 );
+		}
+	}
+}
+
+_SkinnedModel *_SkinnedModelFind( Mesh *meshes , bool create )
+{
+	for( int i = 0 ; i < _skinnedModelsCount ; i++ )
+	{
+		if ( _skinnedModels[i].meshes == meshes ) return &_skinnedModels[i] ;
+	}
+
+	if ( ! create ) return NULL ;
+
+	if ( _skinnedModelsCount >= _skinnedModelsCapacity )
+	{
+		_skinnedModelsCapacity = _skinnedModelsCapacity > 0 ? _skinnedModelsCapacity*2 : 16 ;
+		_skinnedModels = (_SkinnedModel*)MemRealloc( _skinnedModels , sizeof( _SkinnedModel )*_skinnedModelsCapacity );
+	}
+
+	_SkinnedModel *skinned = &_skinnedModels[ _skinnedModelsCount++ ] ;
+
+	skinned->meshes = meshes ;
+	skinned->animation = NULL ;
+	skinned->frame = -1 ; // Unknown : the meshes are skinned the first time, even for the bind pose
+
+	return skinned ;
+}
+
+int ModelSkin( Model *model , AnimationPose *pose )
+{
+	if ( model == NULL || model->boneCount <= 0 || model->meshes == NULL ) return 0 ;
+
+	if ( pose != NULL && ( pose->animation == NULL || pose->boneCount != model->boneCount ) ) pose = NULL ;
+
+	_SkinnedModel *skinned = _SkinnedModelFind( model->meshes , pose != NULL );
+
+	// A model that was never skinned still holds its bind pose :
+
+	if ( skinned == NULL ) return 0 ;
+
+	ModelAnimation *animation = pose != NULL ? pose->animation : NULL ;
+	int frame = pose != NULL ? pose->frame : 0 ;
+
+	if ( skinned->animation == animation && skinned->frame == frame )
+	{
+		if ( pose != NULL ) _skinCache.stats.unchanged++ ;
+		return 0 ;
+	}
+
+	// The skinned vertices may be cached already :
+
+	int e = pose != NULL ? _SkinCacheGet( model , animation , frame ) : -1 ;
+
+	_SkinCacheEntry *entry = e >= 0 ? &_skinCache.entries[e] : NULL ;
+
+	bool hit = entry != NULL && entry->ready ;
+	float *cached = entry != NULL ? entry->data : NULL ;
+
+	if ( pose != NULL )
+	{
+		if ( hit ) _skinCache.stats.hits++ ;
+		else _skinCache.stats.misses++ ;
+	}
+
+	int meshSkinned = 0 ;
+
+	for( int m = 0 ; m < model->meshCount ; m++ )
+	{
+		Mesh *mesh = &model->meshes[m] ;
+
+		if ( mesh->boneIds == NULL || mesh->boneWeights == NULL || mesh->animVertices == NULL ) continue ;
+
+		bool withNormals = mesh->animNormals != NULL && mesh->normals != NULL ;
+
+		const float *vertices = mesh->vertices ; // Bind pose
+		const float *normals = mesh->normals ;
+
+		if ( pose != NULL )
+		{
+			float *outVertices = cached != NULL ? cached : mesh->animVertices ;
+			float *outNormals = cached != NULL ? cached + 3*mesh->vertexCount : mesh->animNormals ;
+
+			if ( ! hit )
+			{
+				SkinVertices( mesh->vertices , withNormals ? mesh->normals : NULL , mesh->boneIds , mesh->boneWeights , pose->bones , pose->boneCount , outVertices , outNormals , mesh->vertexCount );
+				meshSkinned++ ;
+			}
+
+			vertices = outVertices ;
+			normals = outNormals ;
+
+			if ( cached != NULL ) cached += ( withNormals ? 6 : 3 )*mesh->vertexCount ;
+		}
+
+		// NOTE : same buffers as UpdateModelAnimation() : 0 for the positions, 2 for the normals.
+
+		UpdateMeshBuffer( *mesh , 0 , vertices , sizeof( float )*3*mesh->vertexCount , 0 );
+		if ( withNormals ) UpdateMeshBuffer( *mesh , 2 , normals , sizeof( float )*3*mesh->vertexCount , 0 );
+	}
+
+	if ( entry != NULL ) entry->ready = true ;
+
+	skinned->animation = animation ;
+	skinned->frame = frame ;
+
+	return meshSkinned ;
+}
+
+void ModelForgetSkin( Model *model )
+{
+	if ( model == NULL ) return ;
+
+	_SkinnedModel *skinned = _SkinnedModelFind( model->meshes , false );
+
+	if ( skinned != NULL ) *skinned = _skinnedModels[ --_skinnedModelsCount ] ;
+
+	// Its cached poses :
+
+	for( int e = 0 ; e < _skinCache.entriesCapacity ; e++ )
+	{
+		if ( _skinCache.entries[e].data != NULL && _skinCache.entries[e].meshes == model->meshes ) _SkinCacheDrop( e );
+	}
+}
+
+// Size of the skinned vertices of the model, as stored in a cache entry.
+size_t _SkinCacheModelSize( Model *model )
+{
+	size_t size = 0 ;
+
+	for( int m = 0 ; m < model->meshCount ; m++ )
+	{
+		Mesh *mesh = &model->meshes[m] ;
+
+		if ( mesh->boneIds == NULL || mesh->boneWeights == NULL || mesh->animVertices == NULL ) continue ;
+
+		bool withNormals = mesh->animNormals != NULL && mesh->normals != NULL ;
+
+		size += sizeof( float )*( withNormals ? 6 : 3 )*mesh->vertexCount ;
+	}
+
+	return size ;
+}
+
+unsigned int _SkinCacheHash( Mesh *meshes , ModelAnimation *animation , int frame )
+{
+	unsigned int hash = (unsigned int)( (size_t)meshes >> 4 )*2654435761u ;
+
+	hash ^= (unsigned int)( (size_t)animation >> 4 )*2246822519u ;
+	hash ^= (unsigned int)frame*3266489917u ;
+
+	return hash ^ ( hash >> 15 );
+}
+
+// Unlink the entry from its bucket and from the LRU list, and free it.
+void _SkinCacheRemove( int e )
+{
+	_SkinCache *cache = &_skinCache ;
+	_SkinCacheEntry *entry = &cache->entries[e] ;
+
+	int *link = &cache->buckets[ _SkinCacheHash( entry->meshes , entry->animation , entry->frame ) & ( cache->bucketsCount - 1 ) ] ;
+
+	while( *link != e ) link = &cache->entries[ *link ].hashNext ;
+
+	*link = entry->hashNext ;
+
+	if ( entry->lruPrev >= 0 ) cache->entries[ entry->lruPrev ].lruNext = entry->lruNext ;
+	else cache->lruFirst = entry->lruNext ;
+
+	if ( entry->lruNext >= 0 ) cache->entries[ entry->lruNext ].lruPrev = entry->lruPrev ;
+	else cache->lruLast = entry->lruPrev ;
+
+	MemFree( entry->data );
+
+	cache->stats.memory -= entry->size ;
+	cache->stats.entries-- ;
+
+	entry->data = NULL ;
+	entry->hashNext = cache->freeEntry ;
+	cache->freeEntry = e ;
+}
+
+// Remove the entry, unless it is queued in a batch : then it is only marked, and removed once the batch has run.
+void _SkinCacheDrop( int e )
+{
+	_SkinCacheEntry *entry = &_skinCache.entries[e] ;
+
+	if ( entry->queued ) entry->dropped = true ;
+	else _SkinCacheRemove( e );
+}
+
+// Drop the least recently used entries until the cache is within its budget, except the queued ones.
+void _SkinCacheTrim( void )
+{
+	_SkinCache *cache = &_skinCache ;
+
+	int last = cache->lruLast ;
+
+	while( last >= 0 && cache->stats.memory > cache->stats.budget )
+	{
+		int previous = cache->entries[ last ].lruPrev ;
+
+		if ( ! cache->entries[ last ].queued )
+		{
+			_SkinCacheRemove( last );
+			cache->stats.evictions++ ;
+		}
+
+		last = previous ;
+	}
+}
+
+// Return the entry of the pose, or a new entry to skin it into (not ready), or -1 if it can't fit in the budget.
+int _SkinCacheGet( Model *model , ModelAnimation *animation , int frame )
+{
+	_SkinCache *cache = &_skinCache ;
+
+	size_t size = _SkinCacheModelSize( model );
+
+	if ( size == 0 || size > cache->stats.budget ) return -1 ;
+
+	unsigned int hash = _SkinCacheHash( model->meshes , animation , frame );
+
+	if ( cache->bucketsCount > 0 )
+	{
+		for( int e = cache->buckets[ hash & ( cache->bucketsCount - 1 ) ] ; e >= 0 ; e = cache->entries[e].hashNext )
+		{
+			_SkinCacheEntry *entry = &cache->entries[e] ;
+
+			if ( entry->meshes != model->meshes || entry->animation != animation || entry->frame != frame || entry->dropped ) continue ;
+
+			// Move it to the front of the LRU list :
+
+			if ( entry->lruPrev >= 0 )
+			{
+				cache->entries[ entry->lruPrev ].lruNext = entry->lruNext ;
+
+				if ( entry->lruNext >= 0 ) cache->entries[ entry->lruNext ].lruPrev = entry->lruPrev ;
+				else cache->lruLast = entry->lruPrev ;
+
+				entry->lruPrev = -1 ;
+				entry->lruNext = cache->lruFirst ;
+				cache->entries[ cache->lruFirst ].lruPrev = e ;
+				cache->lruFirst = e ;
+			}
+
+			return e ;
+		}
+	}
+
+	// Make room, without dropping the entries being skinned :
+
+	int last = cache->lruLast ;
+
+	while( cache->stats.memory + size > cache->stats.budget )
+	{
+		while( last >= 0 && ! cache->entries[ last ].ready ) last = cache->entries[ last ].lruPrev ;
+
+		if ( last < 0 ) return -1 ;
+
+		int previous = cache->entries[ last ].lruPrev ;
+
+		_SkinCacheRemove( last );
+		cache->stats.evictions++ ;
+
+		last = previous ;
+	}
+
+	if ( cache->freeEntry < 0 )
+	{
+		int capacity = cache->entriesCapacity > 0 ? cache->entriesCapacity*2 : 64 ;
+
+		cache->entries = (_SkinCacheEntry*)MemRealloc( cache->entries , sizeof( _SkinCacheEntry )*capacity );
+
+		for( int e = capacity - 1 ; e >= cache->entriesCapacity ; e-- )
+		{
+			cache->entries[e].data = NULL ;
+			cache->entries[e].hashNext = cache->freeEntry ;
+			cache->freeEntry = e ;
+		}
+
+		cache->entriesCapacity = capacity ;
+	}
+
+	// Keep about one entry per bucket :
+
+	if ( cache->stats.entries >= cache->bucketsCount )
+	{
+		int count = cache->bucketsCount > 0 ? cache->bucketsCount*2 : 64 ;
+
+		MemFree( cache->buckets );
+		cache->buckets = (int*)MemAlloc( sizeof( int )*count );
+		cache->bucketsCount = count ;
+
+		for( int b = 0 ; b < count ; b++ ) cache->buckets[b] = -1 ;
+
+		for( int e = 0 ; e < cache->entriesCapacity ; e++ )
+		{
+			_SkinCacheEntry *entry = &cache->entries[e] ;
+
+			if ( entry->data == NULL ) continue ;
+
+			int *bucket = &cache->buckets[ _SkinCacheHash( entry->meshes , entry->animation , entry->frame ) & ( count - 1 ) ] ;
+
+			entry->hashNext = *bucket ;
+			*bucket = e ;
+		}
+	}
+
+	int e = cache->freeEntry ;
+
+	_SkinCacheEntry *entry = &cache->entries[e] ;
+
+	cache->freeEntry = entry->hashNext ;
+
+	entry->meshes = model->meshes ;
+	entry->animation = animation ;
+	entry->frame = frame ;
+	entry->data = (float*)MemAlloc( size );
+	entry->size = size ;
+	entry->ready = false ;
+	entry->queued = false ;
+	entry->dropped = false ;
+
+	int *bucket = &cache->buckets[ hash & ( cache->bucketsCount - 1 ) ] ;
+
+	entry->hashNext = *bucket ;
+	*bucket = e ;
+
+	entry->lruPrev = -1 ;
+	entry->lruNext = cache->lruFirst ;
+
+	if ( cache->lruFirst >= 0 ) cache->entries[ cache->lruFirst ].lruPrev = e ;
+	else cache->lruLast = e ;
+
+	cache->lruFirst = e ;
+
+	cache->stats.memory += size ;
+	cache->stats.entries++ ;
+
+	return e ;
+}
+
+// NOTE : the queued entries are dropped after their batch has run, if still over the budget.
+void SkinCacheSetBudget( size_t budget )
+{
+	_skinCache.stats.budget = budget ;
+
+	_SkinCacheTrim();
+}
+
+void SkinCacheClear( void )
+{
+	int last = _skinCache.lruLast ;
+
+	while( last >= 0 )
+	{
+		int previous = _skinCache.entries[ last ].lruPrev ;
+
+		_SkinCacheDrop( last );
+
+		last = previous ;
+	}
+}
+
+SkinCacheStats SkinCacheGetStats( void )
+{
+	return _skinCache.stats ;
+}
+
+void SkinCacheResetStats( void )
+{
+	_skinCache.stats.hits = 0 ;
+	_skinCache.stats.misses = 0 ;
+	_skinCache.stats.unchanged = 0 ;
+	_skinCache.stats.evictions = 0 ;
+}
+
+SkinBatch *SkinBatchCreate( void )
+{
+	SkinBatch *batch = (SkinBatch*)MemAlloc( sizeof( SkinBatch ) );
+
+	*batch = (SkinBatch){ 0 };
+
+	return batch ;
+}
+
+SkinBatch *SkinBatchRelease( SkinBatch *batch )
+{
+	if ( batch == NULL ) return NULL ;
+
+	// The entries queued but not skinned are dropped :
+
+	for( int i = 0 ; i < batch->entriesCount ; i++ )
+	{
+		_SkinCacheEntry *entry = &_skinCache.entries[ batch->entries[i] ] ;
+
+		if ( entry->data != NULL && entry->queued && ! entry->ready ) _SkinCacheRemove( batch->entries[i] );
+	}
+
+	MemFree( batch->entries );
+	MemFree( batch->ranges );
+	MemFree( batch );
+
+	return NULL ;
+}
+
+bool SkinBatchAdd( SkinBatch *batch , Model *model , AnimationPose *pose )
+{
+	if ( model == NULL || model->boneCount <= 0 || model->meshes == NULL ) return false ;
+
+	if ( pose == NULL || pose->animation == NULL || pose->boneCount != model->boneCount ) return false ;
+
+	_SkinnedModel *skinned = _SkinnedModelFind( model->meshes , false );
+
+	if ( skinned != NULL && skinned->animation == pose->animation && skinned->frame == pose->frame ) return false ;
+
+	int e = _SkinCacheGet( model , pose->animation , pose->frame );
+
+	if ( e < 0 )
+	{
+		// NOTE : expected if the cache is disabled, so only told once per batch otherwise.
+
+		size_t size = _SkinCacheModelSize( model );
+
+		if ( size > 0 && _skinCache.stats.budget > 0 && ! batch->warned )
+		{
+			TRACELOG( LOG_WARNING , "SKINNING: A pose of %d KB doesn't fit in the skin cache (budget of %d KB, or pinned by the batch) : it is left to the draw." ,
+				(int)( size/1024 ) , (int)( _skinCache.stats.budget/1024 ) );
+
+			batch->warned = true ;
+		}
+
+		return false ;
+	}
+
+	_SkinCacheEntry *entry = &_skinCache.entries[e] ;
+
+	if ( entry->ready || entry->queued ) return false ;
+
+	entry->queued = true ;
+
+	if ( batch->entriesCount >= batch->entriesCapacity )
+	{
+		batch->entriesCapacity = batch->entriesCapacity > 0 ? batch->entriesCapacity*2 : 64 ;
+		batch->entries = (int*)MemRealloc( batch->entries , sizeof( int )*batch->entriesCapacity );
+	}
+
+	batch->entries[ batch->entriesCount++ ] = e ;
+
+	// Same layout as ModelSkin() : the vertices, then the normals, of each skinned mesh.
+
+	float *data = entry->data ;
+
+	for( int m = 0 ; m < model->meshCount ; m++ )
+	{
+		Mesh *mesh = &model->meshes[m] ;
+
+		if ( mesh->boneIds == NULL || mesh->boneWeights == NULL || mesh->animVertices == NULL ) continue ;
+
+		bool withNormals = mesh->animNormals != NULL && mesh->normals != NULL ;
+
+		for( int first = 0 ; first < mesh->vertexCount ; first += SKIN_BATCH_GRAIN )
+		{
+			if ( batch->rangesCount >= batch->rangesCapacity )
+			{
+				batch->rangesCapacity = batch->rangesCapacity > 0 ? batch->rangesCapacity*2 : 64 ;
+				batch->ranges = (_SkinBatchRange*)MemRealloc( batch->ranges , sizeof( _SkinBatchRange )*batch->rangesCapacity );
+			}
+
+			_SkinBatchRange *range = &batch->ranges[ batch->rangesCount++ ] ;
+
+			range->entry = e ;
+			range->mesh = mesh ;
+			range->bones = pose->bones ;
+			range->boneCount = pose->boneCount ;
+			range->first = first ;
+			range->count = mesh->vertexCount - first < SKIN_BATCH_GRAIN ? mesh->vertexCount - first : SKIN_BATCH_GRAIN ;
+			range->outVertices = data ;
+			range->outNormals = withNormals ? data + 3*mesh->vertexCount : NULL ;
+		}
+
+		data += ( withNormals ? 6 : 3 )*mesh->vertexCount ;
+	}
+
+	return true ;
+}
+
+// Skin the ranges first to first+count-1 (on a worker thread).
+void _SkinBatchJob( void *userData , int first , int count )
+{
+	SkinBatch *batch = (SkinBatch*)userData ;
+
+	for( int r = first ; r < first + count ; r++ )
+	{
+		_SkinBatchRange *range = &batch->ranges[r] ;
+
+		// NOTE : the cache is not changed while the batch runs, so it can be read from the threads.
+
+		if ( _skinCache.entries[ range->entry ].dropped ) continue ;
+
+		Mesh *mesh = range->mesh ;
+		int v = range->first ;
+
+		SkinVertices( &mesh->vertices[ 3*v ] , range->outNormals != NULL ? &mesh->normals[ 3*v ] : NULL , &mesh->boneIds[ 4*v ] , &mesh->boneWeights[ 4*v ] ,
+			range->bones , range->boneCount , &range->outVertices[ 3*v ] , range->outNormals != NULL ? &range->outNormals[ 3*v ] : NULL , range->count );
+	}
+}
+
+int SkinBatchRun( SkinBatch *batch , WorkerPool *pool )
+{
+	// NOTE : one range per job item : each is large enough to be worth a thread.
+
+	WorkerPoolRun( pool , batch->rangesCount , 1 , _SkinBatchJob , batch );
+
+	// Unpin the entries, and remove the ones dropped meanwhile :
+
+	int skinned = 0 ;
+
+	for( int i = 0 ; i < batch->entriesCount ; i++ )
+	{
+		_SkinCacheEntry *entry = &_skinCache.entries[ batch->entries[i] ] ;
+
+		entry->queued = false ;
+
+		if ( entry->dropped )
+		{
+			_SkinCacheRemove( batch->entries[i] );
+			continue ;
+		}
+
+		entry->ready = true ;
+		skinned++ ;
+	}
+
+	_skinCache.stats.misses += skinned ;
+
+	batch->entriesCount = 0 ;
+	batch->rangesCount = 0 ;
+
+	// The budget may have been lowered while the entries were pinned :
+
+	_SkinCacheTrim();
+
+	return skinned ;
+}
+
+#endif // RSKINNING_IMPLEMENTATION
@@ -0,0 +1,529 @@
+#ifndef RTRANSFORMS_H
+#define RTRANSFORMS_H
+
+#include "raylib.h"
+#include "raymath.h"
+
+#include "rfrustum.h"
+
+// Batch transform kernels :
+// NOTE : the SIMD code path is the one selected by rfrustum.h (see RFRUSTUM_NO_SIMD).
+// The kernels do the same operations in the same order as MatrixMultiply() and BoundingBoxTransformAffine(),
+// so every path gives the same results as them (up to the sign of the zeros), unless the compiler
+// is allowed to fuse the multiply-adds (-mfma with -ffp-contract=fast).
+// The boxes are transformed with their center and extents (Arvo's method) : they match BoundingBoxTransform() up to rounding.
+//
+// In memory, a raylib Matrix is stored row by row (m0 m4 m8 m12 , m1 m5 m9 m13 , ...),
+// so MatrixMultiply( left , right ) is the product right*left of these rows.
+// An affine matrix has m3 = m7 = m11 = 0 and m15 = 1 : only its 3 first rows are stored and computed (Matrix3x4),
+// so the sign of a zero may differ from MatrixMultiply() which adds 0*m15.
+//
+// Local transforms are composed from a quaternion, a translation and a scale (40 bytes, see Node3D).
+
+
+// Affine transform matrix (48 bytes instead of 64) :
+// NOTE : it is the 3 first rows of a Matrix, in the same order. The last row is implicitly 0 0 0 1.
+
+typedef struct Matrix3x4
+{
+	float m0, m4, m8, m12;  // Matrix first row (4 components)
+	float m1, m5, m9, m13;  // Matrix second row (4 components)
+	float m2, m6, m10, m14; // Matrix third row (4 components)
+
+} Matrix3x4;
+
+
+#if defined(__cplusplus)
+extern "C" {            // Prevents name mangling of functions
+#endif
+
+RLAPI Matrix3x4 Matrix3x4FromMatrix( Matrix m ); // Drop the last row
+RLAPI Matrix Matrix3x4ToMatrix( Matrix3x4 m );   // Add the last row 0 0 0 1
+
+RLAPI Matrix3x4 Matrix3x4Invert( Matrix3x4 m ); // Inverse of an affine matrix : inverse of the 3x3 part, and its opposite times the translation
+RLAPI Matrix MatrixInvertAffine( Matrix m );    // Faster MatrixInvert() for an affine matrix (the last row is ignored)
+
+RLAPI Matrix3x4 TransformCompose( Vector3 position , Vector3 scale , Quaternion rotation ); // Same as MatrixMultiply( MatrixMultiply( MatrixScale() , QuaternionToMatrix( rotation ) ) , MatrixTranslate() ), for a unit quaternion
+RLAPI Matrix3x4 TransformComposeWorld( Matrix3x4 local , const Matrix3x4 *parent , BoundingBox box , BoundingBox *worldBox ); // Return local*parent (local if parent is NULL), and the box transformed by the result (see BoundingBoxTransformAffine())
+
+RLAPI void TransformComposeBatch( const Vector3 *position , const Vector3 *scale , const Quaternion *rotation , Matrix3x4 *local , const int *indices , int count ); // TransformCompose() of the entries listed by indices (the count first entries if NULL)
+RLAPI void TransformComposeWorldBatch( const Matrix3x4 *local , const int *parent , Matrix3x4 *world , const BoundingBox *box , BoundingBox *worldBox , const int *indices , int count ); // TransformComposeWorld() with world[ parent[i] ] (none if -1). Parents must be listed before their children.
+
+RLAPI void BoundingBoxTransformBatch( const BoundingBox *box , const Matrix3x4 *transform , BoundingBox *result , int count ); // result[i] = BoundingBoxTransformAffine( box[i] , transform[i] )
+
+RLAPI void MatrixMultiplyBatch( const Matrix *left , const Matrix *right , Matrix *result , int count ); // result[i] = MatrixMultiply( left[i] , right[i] )
+RLAPI void MatrixMultiplyAffineBatch( const Matrix3x4 *left , const Matrix3x4 *right , Matrix3x4 *result , int count ); // Same, for affine matrices
+
+#if defined(__cplusplus)
+}
+#endif
+
+#endif // RTRANSFORMS_H
+
+#if defined(RTRANSFORMS_IMPLEMENTATION)
+
+#include <string.h> // Required for: memcpy()
+
+#if defined(RFRUSTUM_SIMD_AVX2)
+	#include <immintrin.h>
+#elif defined(RFRUSTUM_SIMD_SSE)
+	#include <emmintrin.h>
+#elif defined(RFRUSTUM_SIMD_NEON)
+	#include <arm_neon.h>
+#endif
+
+void _TransformMultiply( const float *left , const float *right , float *result , int rows );
+void _TransformBox( const float *m , const BoundingBox *box , BoundingBox *result );
+void _TransformCompose( const Vector3 *position , const Vector3 *scale , const Quaternion *rotation , float *result );
+
+// Multiply the rows of the matrices as MatrixMultiply( left , right ) does.
+// NOTE : rows is 4 for a 4x4 product, or 3 for affine matrices (Matrix3x4 : 12 floats are read and written).
+void _TransformMultiply( const float *left , const float *right , float *result , int rows )
+{
+	// Each row of the result is a combination of the rows of left :
+	// result[b] = right[b][0]*left[0] + right[b][1]*left[1] + right[b][2]*left[2] + right[b][3]*left[3]
+	// For affine matrices, left[3] is 0 0 0 1 : only right[b][3] is added to the translation.
+
+#if defined(RFRUSTUM_SIMD_AVX2)
+
+	// Two rows per instruction :
+
+	__m256 l0 = _mm256_broadcast_ps( (const __m128*)( left + 0 ) );
+	__m256 l1 = _mm256_broadcast_ps( (const __m128*)( left + 4 ) );
+	__m256 l2 = _mm256_broadcast_ps( (const __m128*)( left + 8 ) );
+
+	if ( rows == 4 )
+	{
+		__m256 l3 = _mm256_broadcast_ps( (const __m128*)( left + 12 ) );
+
+		for( int b = 0 ; b < 4 ; b += 2 )
+		{
+			__m256 r = _mm256_loadu_ps( right + 4*b );
+
+			__m256 row = _mm256_add_ps( _mm256_add_ps( _mm256_add_ps(
+				_mm256_mul_ps( _mm256_permute_ps( r , 0x00 ) , l0 ) ,
+				_mm256_mul_ps( _mm256_permute_ps( r , 0x55 ) , l1 ) ) ,
+				_mm256_mul_ps( _mm256_permute_ps( r , 0xAA ) , l2 ) ) ,
+				_mm256_mul_ps( _mm256_permute_ps( r , 0xFF ) , l3 ) );
+
+			_mm256_storeu_ps( result + 4*b , row );
+		}
+	}
+	else
+	{
+		const __m256 w = _mm256_castsi256_ps( _mm256_set_epi32( -1 , 0 , 0 , 0 , -1 , 0 , 0 , 0 ) );
+
+		__m256 r01 = _mm256_loadu_ps( right );
+
+		__m256 row01 = _mm256_add_ps( _mm256_add_ps( _mm256_add_ps(
+			_mm256_mul_ps( _mm256_permute_ps( r01 , 0x00 ) , l0 ) ,
+			_mm256_mul_ps( _mm256_permute_ps( r01 , 0x55 ) , l1 ) ) ,
+			_mm256_mul_ps( _mm256_permute_ps( r01 , 0xAA ) , l2 ) ) ,
+			_mm256_and_ps( r01 , w ) );
+
+		const float *r = right + 8 ;
+
+		__m128 row2 = _mm_add_ps( _mm_add_ps( _mm_add_ps(
+			_mm_mul_ps( _mm_set1_ps( r[0] ) , _mm256_castps256_ps128( l0 ) ) ,
+			_mm_mul_ps( _mm_set1_ps( r[1] ) , _mm256_castps256_ps128( l1 ) ) ) ,
+			_mm_mul_ps( _mm_set1_ps( r[2] ) , _mm256_castps256_ps128( l2 ) ) ) ,
+			_mm_set_ps( r[3] , 0.0f , 0.0f , 0.0f ) );
+
+		_mm256_storeu_ps( result , row01 );
+		_mm_storeu_ps( result + 8 , row2 );
+	}
+
+#elif defined(RFRUSTUM_SIMD_SSE)
+
+	__m128 l0 = _mm_loadu_ps( left + 0 );
+	__m128 l1 = _mm_loadu_ps( left + 4 );
+	__m128 l2 = _mm_loadu_ps( left + 8 );
+	__m128 l3 = rows == 4 ? _mm_loadu_ps( left + 12 ) : _mm_setzero_ps();
+
+	for( int b = 0 ; b < rows ; b++ )
+	{
+		const float *r = right + 4*b ;
+
+		__m128 row = _mm_add_ps( _mm_add_ps( _mm_add_ps(
+			_mm_mul_ps( _mm_set1_ps( r[0] ) , l0 ) ,
+			_mm_mul_ps( _mm_set1_ps( r[1] ) , l1 ) ) ,
+			_mm_mul_ps( _mm_set1_ps( r[2] ) , l2 ) ) ,
+			rows == 4 ? _mm_mul_ps( _mm_set1_ps( r[3] ) , l3 ) : _mm_set_ps( r[3] , 0.0f , 0.0f , 0.0f ) );
+
+		_mm_storeu_ps( result + 4*b , row );
+	}
+
+#elif defined(RFRUSTUM_SIMD_NEON)
+
+	float32x4_t l0 = vld1q_f32( left + 0 );
+	float32x4_t l1 = vld1q_f32( left + 4 );
+	float32x4_t l2 = vld1q_f32( left + 8 );
+	float32x4_t l3 = rows == 4 ? vld1q_f32( left + 12 ) : vdupq_n_f32( 0.0f );
+
+	for( int b = 0 ; b < rows ; b++ )
+	{
+		const float *r = right + 4*b ;
+
+		// NOTE : separate multiplies and adds, as the scalar code (vmlaq_f32 may be fused).
+
+		float32x4_t row = vaddq_f32( vaddq_f32( vaddq_f32(
+			vmulq_n_f32( l0 , r[0] ) ,
+			vmulq_n_f32( l1 , r[1] ) ) ,
+			vmulq_n_f32( l2 , r[2] ) ) ,
+			rows == 4 ? vmulq_n_f32( l3 , r[3] ) : vsetq_lane_f32( r[3] , vdupq_n_f32( 0.0f ) , 3 ) );
+
+		vst1q_f32( result + 4*b , row );
+	}
+
+#else
+
+	float row[4] ;
+
+	for( int b = 0 ; b < rows ; b++ )
+	{
+		const float *r = right + 4*b ;
+
+		for( int c = 0 ; c < 4 ; c++ )
+		{
+			if ( rows == 4 )
+			{
+				row[c] = left[c]*r[0] + left[4 + c]*r[1] + left[8 + c]*r[2] + left[12 + c]*r[3] ;
+			}
+			else
+			{
+				row[c] = left[c]*r[0] + left[4 + c]*r[1] + left[8 + c]*r[2] + ( c == 3 ? r[3] : 0.0f );
+			}
+		}
+
+		for( int c = 0 ; c < 4 ; c++ ) result[ 4*b + c ] = row[c] ;
+	}
+
+#endif
+}
+
+// Same as BoundingBoxTransformAffine() : center and extents, with the operations in the same order.
+// NOTE : the SIMD versions transpose the 3 rows of m to get its columns (and the translation), so the
+// center and the extents are computed with 3 multiply-adds each. Only the 3 first rows of m are read.
+void _TransformBox( const float *m , const BoundingBox *box , BoundingBox *result )
+{
+#if defined(RFRUSTUM_SIMD_SSE)
+
+	__m128 c0 = _mm_loadu_ps( m + 0 );
+	__m128 c1 = _mm_loadu_ps( m + 4 );
+	__m128 c2 = _mm_loadu_ps( m + 8 );
+	__m128 c3 = _mm_setzero_ps();
+
+	_MM_TRANSPOSE4_PS( c0 , c1 , c2 , c3 ); // Columns of the 3x3 part, and the translation
+
+	const __m128 absMask = _mm_castsi128_ps( _mm_set1_epi32( 0x7FFFFFFF ) );
+
+	__m128 bmin = _mm_set_ps( 0.0f , box->min.z , box->min.y , box->min.x );
+	__m128 bmax = _mm_set_ps( 0.0f , box->max.z , box->max.y , box->max.x );
+
+	__m128 center = _mm_mul_ps( _mm_add_ps( bmin , bmax ) , _mm_set1_ps( 0.5f ) );
+	__m128 extent = _mm_mul_ps( _mm_sub_ps( bmax , bmin ) , _mm_set1_ps( 0.5f ) );
+
+	__m128 c = _mm_add_ps( _mm_add_ps( _mm_add_ps(
+		_mm_mul_ps( c0 , _mm_shuffle_ps( center , center , _MM_SHUFFLE(0,0,0,0) ) ) ,
+		_mm_mul_ps( c1 , _mm_shuffle_ps( center , center , _MM_SHUFFLE(1,1,1,1) ) ) ) ,
+		_mm_mul_ps( c2 , _mm_shuffle_ps( center , center , _MM_SHUFFLE(2,2,2,2) ) ) ) ,
+		c3 );
+
+	__m128 e = _mm_add_ps( _mm_add_ps(
+		_mm_mul_ps( _mm_and_ps( c0 , absMask ) , _mm_shuffle_ps( extent , extent , _MM_SHUFFLE(0,0,0,0) ) ) ,
+		_mm_mul_ps( _mm_and_ps( c1 , absMask ) , _mm_shuffle_ps( extent , extent , _MM_SHUFFLE(1,1,1,1) ) ) ) ,
+		_mm_mul_ps( _mm_and_ps( c2 , absMask ) , _mm_shuffle_ps( extent , extent , _MM_SHUFFLE(2,2,2,2) ) ) );
+
+	float lo[4] , hi[4] ;
+
+	_mm_storeu_ps( lo , _mm_sub_ps( c , e ) );
+	_mm_storeu_ps( hi , _mm_add_ps( c , e ) );
+
+	result->min = (Vector3){ lo[0] , lo[1] , lo[2] };
+	result->max = (Vector3){ hi[0] , hi[1] , hi[2] };
+
+#elif defined(RFRUSTUM_SIMD_NEON)
+
+	// Transpose : ( r0[0] r1[0] r0[2] r1[2] ) , ( r0[1] r1[1] r0[3] r1[3] ) , then the same for r2 and 0 0 0 0 :
+
+	float32x4x2_t t01 = vtrnq_f32( vld1q_f32( m + 0 ) , vld1q_f32( m + 4 ) );
+	float32x4x2_t t23 = vtrnq_f32( vld1q_f32( m + 8 ) , vdupq_n_f32( 0.0f ) );
+
+	float32x4_t c0 = vcombine_f32( vget_low_f32( t01.val[0] ) , vget_low_f32( t23.val[0] ) );
+	float32x4_t c1 = vcombine_f32( vget_low_f32( t01.val[1] ) , vget_low_f32( t23.val[1] ) );
+	float32x4_t c2 = vcombine_f32( vget_high_f32( t01.val[0] ) , vget_high_f32( t23.val[0] ) );
+	float32x4_t c3 = vcombine_f32( vget_high_f32( t01.val[1] ) , vget_high_f32( t23.val[1] ) );
+
+	Vector3 center = { ( box->min.x + box->max.x )*0.5f , ( box->min.y + box->max.y )*0.5f , ( box->min.z + box->max.z )*0.5f };
+	Vector3 extent = { ( box->max.x - box->min.x )*0.5f , ( box->max.y - box->min.y )*0.5f , ( box->max.z - box->min.z )*0.5f };
+
+	// NOTE : separate multiplies and adds, as the scalar code (vmlaq_f32 may be fused).
+
+	float32x4_t c = vaddq_f32( vaddq_f32( vaddq_f32(
+		vmulq_n_f32( c0 , center.x ) ,
+		vmulq_n_f32( c1 , center.y ) ) ,
+		vmulq_n_f32( c2 , center.z ) ) ,
+		c3 );
+
+	float32x4_t e = vaddq_f32( vaddq_f32(
+		vmulq_n_f32( vabsq_f32( c0 ) , extent.x ) ,
+		vmulq_n_f32( vabsq_f32( c1 ) , extent.y ) ) ,
+		vmulq_n_f32( vabsq_f32( c2 ) , extent.z ) );
+
+	float lo[4] , hi[4] ;
+
+	vst1q_f32( lo , vsubq_f32( c , e ) );
+	vst1q_f32( hi , vaddq_f32( c , e ) );
+
+	result->min = (Vector3){ lo[0] , lo[1] , lo[2] };
+	result->max = (Vector3){ hi[0] , hi[1] , hi[2] };
+
+#else
+
+	Matrix transform ;
+
+	memcpy( &transform , m , 12*sizeof( float ) );
+
+	*result = BoundingBoxTransformAffine( *box , transform ); // The last row is ignored
+
+#endif
+}
+
+// Rows of scale*rotation*translation : the columns of the rotation are scaled, and the translation is the last column.
+void _TransformCompose( const Vector3 *position , const Vector3 *scale , const Quaternion *rotation , float *result )
+{
+	Matrix matRotation = QuaternionToMatrix( *rotation );
+
+	const float *r = (const float*)&matRotation ;
+
+#if defined(RFRUSTUM_SIMD_SSE)
+
+	__m128 s = _mm_set_ps( 0.0f , scale->z , scale->y , scale->x );
+
+	const __m128 xyz = _mm_castsi128_ps( _mm_set_epi32( 0 , -1 , -1 , -1 ) );
+
+	_mm_storeu_ps( result + 0 , _mm_or_ps( _mm_and_ps( _mm_mul_ps( _mm_loadu_ps( r + 0 ) , s ) , xyz ) , _mm_set_ps( position->x , 0.0f , 0.0f , 0.0f ) ) );
+	_mm_storeu_ps( result + 4 , _mm_or_ps( _mm_and_ps( _mm_mul_ps( _mm_loadu_ps( r + 4 ) , s ) , xyz ) , _mm_set_ps( position->y , 0.0f , 0.0f , 0.0f ) ) );
+	_mm_storeu_ps( result + 8 , _mm_or_ps( _mm_and_ps( _mm_mul_ps( _mm_loadu_ps( r + 8 ) , s ) , xyz ) , _mm_set_ps( position->z , 0.0f , 0.0f , 0.0f ) ) );
+
+#elif defined(RFRUSTUM_SIMD_NEON)
+
+	const float sv[4] = { scale->x , scale->y , scale->z , 0.0f };
+	float32x4_t s = vld1q_f32( sv );
+
+	vst1q_f32( result + 0 , vsetq_lane_f32( position->x , vmulq_f32( vld1q_f32( r + 0 ) , s ) , 3 ) );
+	vst1q_f32( result + 4 , vsetq_lane_f32( position->y , vmulq_f32( vld1q_f32( r + 4 ) , s ) , 3 ) );
+	vst1q_f32( result + 8 , vsetq_lane_f32( position->z , vmulq_f32( vld1q_f32( r + 8 ) , s ) , 3 ) );
+
+#else
+
+	const float t[3] = { position->x , position->y , position->z };
+
+	for( int b = 0 ; b < 3 ; b++ )
+	{
+		result[ 4*b + 0 ] = r[ 4*b + 0 ]*scale->x ;
+		result[ 4*b + 1 ] = r[ 4*b + 1 ]*scale->y ;
+		result[ 4*b + 2 ] = r[ 4*b + 2 ]*scale->z ;
+		result[ 4*b + 3 ] = t[b] ;
+	}
+
+#endif
+}
+
+Matrix3x4 Matrix3x4FromMatrix( Matrix m )
+{
+	Matrix3x4 result ;
+
+	memcpy( &result , &m , sizeof( Matrix3x4 ) );
+
+	return result ;
+}
+
+Matrix Matrix3x4ToMatrix( Matrix3x4 m )
+{
+	Matrix result = MatrixIdentity();
+
+	memcpy( &result , &m , sizeof( Matrix3x4 ) );
+
+	return result ;
+}
+
+// NOTE : does not check for division by zero (singular matrix), as MatrixInvert().
+Matrix3x4 Matrix3x4Invert( Matrix3x4 m )
+{
+	Matrix3x4 result ;
+
+	// Cofactors of the first row, then the determinant :
+
+	float c0 = m.m5*m.m10 - m.m9*m.m6 ;
+	float c1 = m.m9*m.m2 - m.m1*m.m10 ;
+	float c2 = m.m1*m.m6 - m.m5*m.m2 ;
+
+	float invDet = 1.0f/( m.m0*c0 + m.m4*c1 + m.m8*c2 );
+
+	// Inverse of the 3x3 part (transposed cofactors divided by the determinant) :
+
+	result.m0 = c0*invDet ;
+	result.m4 = ( m.m8*m.m6 - m.m4*m.m10 )*invDet ;
+	result.m8 = ( m.m4*m.m9 - m.m8*m.m5 )*invDet ;
+
+	result.m1 = c1*invDet ;
+	result.m5 = ( m.m0*m.m10 - m.m8*m.m2 )*invDet ;
+	result.m9 = ( m.m8*m.m1 - m.m0*m.m9 )*invDet ;
+
+	result.m2 = c2*invDet ;
+	result.m6 = ( m.m4*m.m2 - m.m0*m.m6 )*invDet ;
+	result.m10 = ( m.m0*m.m5 - m.m4*m.m1 )*invDet ;
+
+	// Translation :
+
+	result.m12 = -( result.m0*m.m12 + result.m4*m.m13 + result.m8*m.m14 );
+	result.m13 = -( result.m1*m.m12 + result.m5*m.m13 + result.m9*m.m14 );
+	result.m14 = -( result.m2*m.m12 + result.m6*m.m13 + result.m10*m.m14 );
+
+	return result ;
+}
+
+Matrix MatrixInvertAffine( Matrix m )
+{
+	return Matrix3x4ToMatrix( Matrix3x4Invert( Matrix3x4FromMatrix( m ) ) );
+}
+
+Matrix3x4 TransformCompose( Vector3 position , Vector3 scale , Quaternion rotation )
+{
+	Matrix3x4 result ;
+
+	_TransformCompose( &position , &scale , &rotation , (float*)&result );
+
+	return result ;
+}
+
+Matrix3x4 TransformComposeWorld( Matrix3x4 local , const Matrix3x4 *parent , BoundingBox box , BoundingBox *worldBox )
+{
+	Matrix3x4 world = local ;
+
+	if ( parent != NULL ) _TransformMultiply( (const float*)&local , (const float*)parent , (float*)&world , 3 );
+
+	if ( worldBox != NULL ) _TransformBox( (const float*)&world , &box , worldBox );
+
+	return world ;
+}
+
+void TransformComposeBatch( const Vector3 *position , const Vector3 *scale , const Quaternion *rotation , Matrix3x4 *local , const int *indices , int count )
+{
+	for( int n = 0 ; n < count ; n++ )
+	{
+		int i = indices != NULL ? indices[n] : n ;
+
+		_TransformCompose( &position[i] , &scale[i] , &rotation[i] , (float*)&local[i] );
+	}
+}
+
+// NOTE : the matrices and the boxes are computed in the same pass, while the world matrix is still hot.
+void TransformComposeWorldBatch( const Matrix3x4 *local , const int *parent , Matrix3x4 *world , const BoundingBox *box , BoundingBox *worldBox , const int *indices , int count )
+{
+	for( int n = 0 ; n < count ; n++ )
+	{
+		int i = indices != NULL ? indices[n] : n ;
+		int p = parent[i] ;
+
+		if ( p >= 0 )
+		{
+			_TransformMultiply( (const float*)&local[i] , (const float*)&world[p] , (float*)&world[i] , 3 );
+		}
+		else
+		{
+			world[i] = local[i] ;
+		}
+
+		_TransformBox( (const float*)&world[i] , &box[i] , &worldBox[i] );
+	}
+}
+
+void BoundingBoxTransformBatch( const BoundingBox *box , const Matrix3x4 *transform , BoundingBox *result , int count )
+{
+	int i = 0 ;
+
+#if defined(RFRUSTUM_SIMD_AVX2)
+
+	// Two boxes per instruction, one in each 128 bits lane (same operations as the SSE version of _TransformBox()) :
+
+	const __m256 absMask = _mm256_castsi256_ps( _mm256_set1_epi32( 0x7FFFFFFF ) );
+	const __m256 half = _mm256_set1_ps( 0.5f );
+
+	for( ; i + 1 < count ; i += 2 )
+	{
+		const float *m0 = (const float*)&transform[i] ;
+		const float *m1 = (const float*)&transform[i + 1] ;
+
+		__m256 r0 = _mm256_insertf128_ps( _mm256_castps128_ps256( _mm_loadu_ps( m0 + 0 ) ) , _mm_loadu_ps( m1 + 0 ) , 1 );
+		__m256 r1 = _mm256_insertf128_ps( _mm256_castps128_ps256( _mm_loadu_ps( m0 + 4 ) ) , _mm_loadu_ps( m1 + 4 ) , 1 );
+		__m256 r2 = _mm256_insertf128_ps( _mm256_castps128_ps256( _mm_loadu_ps( m0 + 8 ) ) , _mm_loadu_ps( m1 + 8 ) , 1 );
+		__m256 r3 = _mm256_setzero_ps();
+
+		// _MM_TRANSPOSE4_PS() in each lane :
+
+		__m256 t0 = _mm256_unpacklo_ps( r0 , r1 );
+		__m256 t1 = _mm256_unpacklo_ps( r2 , r3 );
+		__m256 t2 = _mm256_unpackhi_ps( r0 , r1 );
+		__m256 t3 = _mm256_unpackhi_ps( r2 , r3 );
+
+		__m256 c0 = _mm256_shuffle_ps( t0 , t1 , _MM_SHUFFLE(1,0,1,0) );
+		__m256 c1 = _mm256_shuffle_ps( t0 , t1 , _MM_SHUFFLE(3,2,3,2) );
+		__m256 c2 = _mm256_shuffle_ps( t2 , t3 , _MM_SHUFFLE(1,0,1,0) );
+		__m256 c3 = _mm256_shuffle_ps( t2 , t3 , _MM_SHUFFLE(3,2,3,2) );
+
+		const BoundingBox *b0 = &box[i] ;
+		const BoundingBox *b1 = &box[i + 1] ;
+
+		__m256 bmin = _mm256_set_ps( 0.0f , b1->min.z , b1->min.y , b1->min.x , 0.0f , b0->min.z , b0->min.y , b0->min.x );
+		__m256 bmax = _mm256_set_ps( 0.0f , b1->max.z , b1->max.y , b1->max.x , 0.0f , b0->max.z , b0->max.y , b0->max.x );
+
+		__m256 center = _mm256_mul_ps( _mm256_add_ps( bmin , bmax ) , half );
+		__m256 extent = _mm256_mul_ps( _mm256_sub_ps( bmax , bmin ) , half );
+
+		__m256 c = _mm256_add_ps( _mm256_add_ps( _mm256_add_ps(
+			_mm256_mul_ps( c0 , _mm256_permute_ps( center , 0x00 ) ) ,
+			_mm256_mul_ps( c1 , _mm256_permute_ps( center , 0x55 ) ) ) ,
+			_mm256_mul_ps( c2 , _mm256_permute_ps( center , 0xAA ) ) ) ,
+			c3 );
+
+		__m256 e = _mm256_add_ps( _mm256_add_ps(
+			_mm256_mul_ps( _mm256_and_ps( c0 , absMask ) , _mm256_permute_ps( extent , 0x00 ) ) ,
+			_mm256_mul_ps( _mm256_and_ps( c1 , absMask ) , _mm256_permute_ps( extent , 0x55 ) ) ) ,
+			_mm256_mul_ps( _mm256_and_ps( c2 , absMask ) , _mm256_permute_ps( extent , 0xAA ) ) );
+
+		float lo[8] , hi[8] ;
+
+		_mm256_storeu_ps( lo , _mm256_sub_ps( c , e ) );
+		_mm256_storeu_ps( hi , _mm256_add_ps( c , e ) );
+
+		result[i]     = (BoundingBox){ { lo[0] , lo[1] , lo[2] } , { hi[0] , hi[1] , hi[2] } };
+		result[i + 1] = (BoundingBox){ { lo[4] , lo[5] , lo[6] } , { hi[4] , hi[5] , hi[6] } };
+	}
+
+#endif
+
+	for( ; i < count ; i++ )
+	{
+		_TransformBox( (const float*)&transform[i] , &box[i] , &result[i] );
+	}
+}
+
+void MatrixMultiplyBatch( const Matrix *left , const Matrix *right , Matrix *result , int count )
+{
+	for( int i = 0 ; i < count ; i++ )
+	{
+		_TransformMultiply( (const float*)&left[i] , (const float*)&right[i] , (float*)&result[i] , 4 );
+	}
+}
+
+void MatrixMultiplyAffineBatch( const Matrix3x4 *left , const Matrix3x4 *right , Matrix3x4 *result , int count )
+{
+	for( int i = 0 ; i < count ; i++ )
+	{
+		_TransformMultiply( (const float*)&left[i] , (const float*)&right[i] , (float*)&result[i] , 3 );
+	}
+}
+
+#endif // RTRANSFORMS_IMPLEMENTATION
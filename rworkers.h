@@ -0,0 +1,257 @@
+#ifndef RWORKERS_H
+#define RWORKERS_H
+
+#include "raylib.h"
+
+// Worker pool :
+// NOTE : a fixed set of threads that share the ranges of a job with the calling thread.
+// It uses pthreads (Linux, macOS, MinGW). Elsewhere, or with RWORKERS_NO_THREADS defined,
+// the jobs simply run on the calling thread.
+
+#if !defined(RWORKERS_NO_THREADS) && ( defined(__unix__) || defined(__APPLE__) || defined(__MINGW32__) )
+	#define RWORKERS_PTHREADS
+#endif
+
+#ifndef WORKERS_MAX_THREADS
+#define WORKERS_MAX_THREADS 64
+#endif
+
+typedef void (*WorkerJobCallback)( void *userData , int first , int count ); // Process the items first to first+count-1
+
+typedef struct WorkerPool WorkerPool ;
+
+
+#if defined(__cplusplus)
+extern "C" {            // Prevents name mangling of functions
+#endif
+
+RLAPI WorkerPool *WorkerPoolCreate( int threadCount ); // Number of threads including the calling one (0 : one per core, 1 : no additional thread)
+#define CreateWorkerPool WorkerPoolCreate
+RLAPI WorkerPool *WorkerPoolRelease( WorkerPool *pool ); // Return NULL
+#define ReleaseWorkerPool WorkerPoolRelease
+
+RLAPI int WorkerPoolGetThreadCount( WorkerPool *pool ); // 1 if pool is NULL
+
+RLAPI void WorkerPoolRun( WorkerPool *pool , int count , int grain , WorkerJobCallback callback , void *userData ); // Split the count items in ranges of grain items processed in parallel, and return when they are all done. Runs on the calling thread if pool is NULL or count <= grain.
+
+#if defined(__cplusplus)
+}
+#endif
+
+#endif // RWORKERS_H
+
+#if defined(RWORKERS_IMPLEMENTATION)
+
+#if defined(RWORKERS_PTHREADS)
+	#include <pthread.h>
+	#if defined(_WIN32)
+		// NOTE : declared here, windows.h conflicts with raylib.h
+		#if defined(__cplusplus)
+		extern "C"
+		#endif
+		__declspec(dllimport) unsigned long __stdcall GetActiveProcessorCount( unsigned short groupNumber );
+	#else
+		#include <unistd.h> // Required for: sysconf()
+	#endif
+#endif
+
+struct WorkerPool
+{
+	int threadCount ; // Including the calling thread
+
+#if defined(RWORKERS_PTHREADS)
+
+	pthread_t *threads ;
+
+	pthread_mutex_t mutex ;
+	pthread_cond_t wake ; // Signaled when a job starts, or to quit
+	pthread_cond_t done ; // Signaled when the last range of the job is done
+
+	unsigned int generation ; // Incremented for each job
+	bool quit ;
+
+	// Current job :
+	// NOTE : only accessed with the mutex locked.
+
+	WorkerJobCallback callback ;
+	void *userData ;
+	int count ;
+	int grain ;
+	int next ;    // First item not taken yet
+	int pending ; // Items not done yet
+
+#endif
+};
+
+#if defined(RWORKERS_PTHREADS)
+
+void _WorkerPoolWork( WorkerPool *pool );
+void *_WorkerPoolThread( void *arg );
+
+// Take and process the ranges of the current job till there are none left.
+// NOTE : called with the mutex locked, which is released while a range is processed.
+void _WorkerPoolWork( WorkerPool *pool )
+{
+	while( pool->next < pool->count )
+	{
+		WorkerJobCallback callback = pool->callback ;
+		void *userData = pool->userData ;
+
+		int first = pool->next ;
+		int count = pool->count - first < pool->grain ? pool->count - first : pool->grain ;
+
+		pool->next += count ;
+
+		pthread_mutex_unlock( &pool->mutex );
+
+		callback( userData , first , count );
+
+		pthread_mutex_lock( &pool->mutex );
+
+		pool->pending -= count ;
+
+		if ( pool->pending == 0 ) pthread_cond_broadcast( &pool->done );
+	}
+}
+
+void *_WorkerPoolThread( void *arg )
+{
+	WorkerPool *pool = (WorkerPool*)arg ;
+
+	pthread_mutex_lock( &pool->mutex );
+
+	unsigned int seen = pool->generation ;
+
+	while( true )
+	{
+		while( ! pool->quit && pool->generation == seen ) pthread_cond_wait( &pool->wake , &pool->mutex );
+
+		if ( pool->quit ) break ;
+
+		seen = pool->generation ;
+
+		_WorkerPoolWork( pool );
+	}
+
+	pthread_mutex_unlock( &pool->mutex );
+
+	return NULL ;
+}
+
+#endif
+
+WorkerPool *WorkerPoolCreate( int threadCount )
+{
+	WorkerPool *pool = (WorkerPool*)MemAlloc( sizeof( WorkerPool ) );
+
+	if ( pool == NULL ) return NULL ;
+
+#if defined(RWORKERS_PTHREADS)
+
+#if defined(_WIN32)
+	if ( threadCount <= 0 ) threadCount = (int)GetActiveProcessorCount( 0xffff ); // ALL_PROCESSOR_GROUPS
+#else
+	if ( threadCount <= 0 ) threadCount = (int)sysconf( _SC_NPROCESSORS_ONLN );
+#endif
+	if ( threadCount > WORKERS_MAX_THREADS ) threadCount = WORKERS_MAX_THREADS ;
+	if ( threadCount < 1 ) threadCount = 1 ;
+
+	pthread_mutex_init( &pool->mutex , NULL );
+	pthread_cond_init( &pool->wake , NULL );
+	pthread_cond_init( &pool->done , NULL );
+
+	pool->threads = (pthread_t*)MemAlloc( sizeof( pthread_t )*threadCount );
+	pool->threadCount = 1 ;
+
+	for( int i = 1 ; i < threadCount ; i++ )
+	{
+		if ( pthread_create( &pool->threads[ pool->threadCount ] , NULL , _WorkerPoolThread , pool ) != 0 )
+		{
+			TRACELOG( LOG_WARNING , "WORKERS: Could only start %d threads out of %d." , pool->threadCount , threadCount );
+			break;
+		}
+
+		pool->threadCount++ ;
+	}
+
+#else
+
+	pool->threadCount = 1 ;
+
+#endif
+
+	return pool ;
+}
+
+WorkerPool *WorkerPoolRelease( WorkerPool *pool )
+{
+	if ( pool == NULL ) return NULL ;
+
+#if defined(RWORKERS_PTHREADS)
+
+	pthread_mutex_lock( &pool->mutex );
+	pool->quit = true ;
+	pthread_cond_broadcast( &pool->wake );
+	pthread_mutex_unlock( &pool->mutex );
+
+	for( int i = 1 ; i < pool->threadCount ; i++ )
+	{
+		pthread_join( pool->threads[i] , NULL );
+	}
+
+	pthread_cond_destroy( &pool->done );
+	pthread_cond_destroy( &pool->wake );
+	pthread_mutex_destroy( &pool->mutex );
+
+	MemFree( pool->threads );
+
+#endif
+
+	MemFree( pool );
+
+	return NULL ;
+}
+
+int WorkerPoolGetThreadCount( WorkerPool *pool )
+{
+	return pool == NULL ? 1 : pool->threadCount ;
+}
+
+void WorkerPoolRun( WorkerPool *pool , int count , int grain , WorkerJobCallback callback , void *userData )
+{
+	if ( count <= 0 ) return ;
+
+	if ( grain < 1 ) grain = 1 ;
+
+	if ( pool == NULL || pool->threadCount <= 1 || count <= grain )
+	{
+		callback( userData , 0 , count );
+		return;
+	}
+
+#if defined(RWORKERS_PTHREADS)
+
+	pthread_mutex_lock( &pool->mutex );
+
+	pool->callback = callback ;
+	pool->userData = userData ;
+	pool->count = count ;
+	pool->grain = grain ;
+	pool->next = 0 ;
+	pool->pending = count ;
+	pool->generation++ ;
+
+	pthread_cond_broadcast( &pool->wake );
+
+	// The calling thread works too, then waits for the ranges still processed by the workers :
+
+	_WorkerPoolWork( pool );
+
+	while( pool->pending > 0 ) pthread_cond_wait( &pool->done , &pool->mutex );
+
+	pthread_mutex_unlock( &pool->mutex );
+
+#endif
+}
+
+#endif // RWORKERS_IMPLEMENTATION